@@ -0,0 +1,78 @@
+#include "AllocationCheck.h"
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+static thread_local uint64_t threadAllocations = 0;
+
+//the array and nothrow forms forward to these
+void* operator new(size_t size)
+{
+	threadAllocations++;
+	//malloc(0) is allowed to return nullptr, new has to hand out a unique pointer
+	if (void* memory = std::malloc(size != 0 ? size : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+uint64_t threadAllocationCount() noexcept
+{
+	return threadAllocations;
+}
+#else
+uint64_t threadAllocationCount() noexcept
+{
+	return 0;
+}
+#endif
+
+AllocationCheck::AllocationCheck(char const* name, uint32_t warmupFrames)
+	:name{ name }, warmupFrames{ warmupFrames }, warmFrames{ 0 }, started{ 0 }, frameAllocations{ 0 }
+{
+
+}
+
+void AllocationCheck::begin() noexcept
+{
+	started = threadAllocationCount();
+}
+
+void AllocationCheck::end() noexcept
+{
+	frameAllocations += threadAllocationCount() - started;
+}
+
+void AllocationCheck::endFrame()
+{
+#ifndef NDEBUG
+	if (warmFrames >= warmupFrames && frameAllocations != 0)
+	{
+		std::cout << name << " allocated " << frameAllocations << " times in a frame after warming up\n";
+		assert(!"per-frame path allocated after warming up");
+	}
+#endif
+	if (warmFrames < warmupFrames)
+	{
+		warmFrames++;
+	}
+	frameAllocations = 0;
+}
+
+void AllocationCheck::rewarm() noexcept
+{
+	warmFrames = 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+//heap allocations the calling thread made through operator new so far
+//debug builds count them, release builds don't replace operator new and always return 0
+uint64_t threadAllocationCount() noexcept;
+
+//asserts in debug builds that a per-frame path stopped allocating once it warmed up, does nothing in release builds
+//only the calling thread's allocations between begin and end count towards the frame
+class AllocationCheck
+{
+public:
+	AllocationCheck(char const* name, uint32_t warmupFrames);
+
+	void begin() noexcept;
+	void end() noexcept;
+	//asserts if this frame allocated and warmupFrames frames passed since the last rewarm
+	void endFrame();
+	//something that is allowed to allocate happened, like a resize or more sprites than ever before
+	void rewarm() noexcept;
+
+private:
+	char const* name;
+	uint32_t warmupFrames;
+	uint32_t warmFrames;		//frames since the last rewarm
+	uint64_t started;			//count at begin
+	uint64_t frameAllocations;
+};
@@ -0,0 +1,249 @@
+#include "Benchmark.h"
+#include "Log.h"
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+Benchmark::Benchmark()
+	:running{ false }, scene{ 0 }, variant{ 0 }, sceneCount{ 0 }, framesRendered{ 0 }, timeSum{ 0.0 },
+	waitingForImages{ false }, waitedFrames{ 0 }
+{
+
+}
+
+void Benchmark::start(std::vector<BenchmarkVariant> variants, int sceneCount, std::function<void(int)> loadScene,
+	std::function<void()> requestImage)
+{
+	this->variants = std::move(variants);
+	this->sceneCount = sceneCount;
+	this->loadScene = std::move(loadScene);
+	this->requestImage = std::move(requestImage);
+	averageTimes.assign(sceneCount, std::vector<double>(this->variants.size(), 0.0));
+	images.assign(sceneCount, std::vector<BenchmarkImage>(this->variants.size()));
+	captured.assign(this->variants.size(), false);
+	for (size_t i = 0; i < this->variants.size(); i++)
+	{
+		if (this->variants[i].reference >= 0)
+		{
+			captured[i] = true;
+			captured[this->variants[i].reference] = true;
+		}
+	}
+	pendingImage.reset();
+	waitingForImages = false;
+	scene = 0;
+	variant = 0;
+	running = !this->variants.empty() && sceneCount > 0;
+
+	if (running)
+	{
+		LOG_INFO("started benchmark of {} variants on {} scenes", this->variants.size(), sceneCount);
+		applyCase();
+	}
+}
+
+void Benchmark::addSample(float milliseconds)
+{
+	if (!running)
+	{
+		return;
+	}
+
+	//an image lost to a swap chain recreation shows up as missing instead of stalling the benchmark
+	if (waitingForImages)
+	{
+		waitedFrames++;
+		if (!pendingImage || waitedFrames > warmupFrames)
+		{
+			finish();
+		}
+		return;
+	}
+
+	framesRendered++;
+	if (framesRendered <= warmupFrames)
+	{
+		return;
+	}
+	timeSum += milliseconds;
+	//the frame drawn after this sample still belongs to this case
+	if (framesRendered == warmupFrames + measuredFrames - 1 && captured[variant])
+	{
+		pendingImage = std::make_pair(scene, variant);
+		requestImage();
+	}
+	if (framesRendered < warmupFrames + measuredFrames)
+	{
+		return;
+	}
+
+	averageTimes[scene][variant] = timeSum / measuredFrames;
+
+	//variants change fastest so each scene is measured back to back
+	variant++;
+	if (variant == variants.size())
+	{
+		variant = 0;
+		scene++;
+	}
+
+	if (scene == sceneCount)
+	{
+		variants.front().apply();
+		waitingForImages = true;
+		waitedFrames = 0;
+		if (!pendingImage)
+		{
+			finish();
+		}
+		return;
+	}
+
+	applyCase();
+}
+
+void Benchmark::addImage(std::vector<uint8_t> pixels, uint32_t width, uint32_t height)
+{
+	if (!running || !pendingImage)
+	{
+		return;
+	}
+
+	BenchmarkImage& image = images[pendingImage->first][pendingImage->second];
+	image.width = width;
+	image.height = height;
+	image.pixels = std::move(pixels);
+	pendingImage.reset();
+}
+
+void Benchmark::finish()
+{
+	running = false;
+	waitingForImages = false;
+	printResults();
+	printImageDifferences();
+}
+
+void Benchmark::applyCase()
+{
+	framesRendered = 0;
+	timeSum = 0.0;
+	loadScene(scene);
+	variants[variant].apply();
+}
+
+//a table doesn't fit in a log record, anything logged before it is written first and the table goes out in one piece
+static void writeTable(std::string const& table)
+{
+	Logger::flush();
+	std::cout << table << std::flush;
+}
+
+void Benchmark::printResults() const
+{
+	std::ostringstream table;
+	table << "benchmark results, average fractal time in ms (speedup over " << variants.front().name << ")\n";
+	table << "scene";
+	for (auto const& benchmarkVariant : variants)
+	{
+		table << "\t" << benchmarkVariant.name;
+	}
+	table << "\n";
+
+	std::vector<double> totals(variants.size(), 0.0);
+	for (int i = 0; i < sceneCount; i++)
+	{
+		table << i;
+		for (size_t j = 0; j < variants.size(); j++)
+		{
+			totals[j] += averageTimes[i][j];
+			table << "\t" << std::fixed << std::setprecision(3) << averageTimes[i][j]
+				<< " (" << std::setprecision(2) << averageTimes[i][0] / averageTimes[i][j] << "x)";
+		}
+		table << "\n";
+	}
+
+	table << "total";
+	for (size_t j = 0; j < variants.size(); j++)
+	{
+		table << "\t" << std::fixed << std::setprecision(3) << totals[j]
+			<< " (" << std::setprecision(2) << totals[0] / totals[j] << "x)";
+	}
+	table << "\n";
+	writeTable(table.str());
+}
+
+void Benchmark::printImageDifferences() const
+{
+	if (std::none_of(variants.begin(), variants.end(), [](BenchmarkVariant const& v) { return v.reference >= 0; }))
+	{
+		return;
+	}
+
+	std::ostringstream table;
+	table << "image difference against the reference variant (mean and max abs error of 255, psnr in dB, speedup over reference)\n";
+	table << "scene";
+	for (auto const& benchmarkVariant : variants)
+	{
+		if (benchmarkVariant.reference >= 0)
+		{
+			table << "\t" << benchmarkVariant.name << " vs " << variants[benchmarkVariant.reference].name;
+		}
+	}
+	table << "\n";
+
+	for (int i = 0; i < sceneCount; i++)
+	{
+		table << i;
+		for (size_t j = 0; j < variants.size(); j++)
+		{
+			int reference = variants[j].reference;
+			if (reference < 0)
+			{
+				continue;
+			}
+
+			BenchmarkImage const& image = images[i][j];
+			BenchmarkImage const& referenceImage = images[i][reference];
+			if (image.pixels.empty() || image.width != referenceImage.width || image.height != referenceImage.height ||
+				image.pixels.size() != referenceImage.pixels.size())
+			{
+				table << "\tn/a";
+				continue;
+			}
+
+			//color channels only, alpha is always opaque
+			double absSum = 0.0;
+			double squareSum = 0.0;
+			int maxError = 0;
+			for (size_t k = 0; k < image.pixels.size(); k++)
+			{
+				if (k % 4 == 3)
+				{
+					continue;
+				}
+				int error = std::abs((int)image.pixels[k] - (int)referenceImage.pixels[k]);
+				absSum += error;
+				squareSum += (double)error * error;
+				maxError = std::max(maxError, error);
+			}
+			double channelCount = (double)image.pixels.size() / 4 * 3;
+			double meanSquare = squareSum / channelCount;
+
+			table << "\t" << std::fixed << std::setprecision(3) << absSum / channelCount << " " << maxError << " ";
+			if (meanSquare > 0.0)
+			{
+				table << std::setprecision(1) << 10.0 * std::log10(255.0 * 255.0 / meanSquare);
+			}
+			else
+			{
+				table << "inf";
+			}
+			table << " (" << std::setprecision(2) << averageTimes[i][reference] / averageTimes[i][j] << "x)";
+		}
+		table << "\n";
+	}
+	writeTable(table.str());
+}
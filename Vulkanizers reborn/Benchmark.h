@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <optional>
+#include <cstdint>
+
+struct BenchmarkVariant
+{
+	std::string name;
+	std::function<void()> apply;	//switch the renderer to this variant
+	int reference = -1;				//variant whose image this one's is compared against, both get captured
+};
+
+struct BenchmarkImage
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;	//rgba8 rows
+};
+
+//renders every scene with every variant and reports the average fractal time
+class Benchmark
+{
+public:
+	Benchmark();
+
+	//first variant is the baseline the others are compared against, requestImage captures the next frame drawn
+	void start(std::vector<BenchmarkVariant> variants, int sceneCount, std::function<void(int)> loadScene,
+		std::function<void()> requestImage);
+	//feed the time of the last frame, moves to the next case when enough frames were measured
+	void addSample(float milliseconds);
+	//image captured after the last requestImage
+	void addImage(std::vector<uint8_t> pixels, uint32_t width, uint32_t height);
+
+	bool isRunning() const noexcept { return running; }
+
+	static constexpr int warmupFrames = 10;		//frames skipped after switching cases
+	static constexpr int measuredFrames = 60;
+
+private:
+	void applyCase();
+	void finish();
+	void printResults() const;
+	void printImageDifferences() const;
+
+	bool running;
+	int scene;
+	int variant;
+	int sceneCount;
+	int framesRendered;
+	double timeSum;
+
+	std::vector<BenchmarkVariant> variants;
+	std::function<void(int)> loadScene;
+	std::function<void()> requestImage;
+	std::vector<std::vector<double>> averageTimes;	//[scene][variant] in ms
+	std::vector<bool> captured;						//variants whose images are compared
+	std::vector<std::vector<BenchmarkImage>> images;	//[scene][variant], empty if not captured
+	std::optional<std::pair<int, int>> pendingImage;	//scene and variant of the requested image
+	bool waitingForImages;							//every case is measured, the last image isn't back yet
+	int waitedFrames;
+};
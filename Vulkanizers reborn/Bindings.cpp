@@ -0,0 +1,175 @@
+#include "Bindings.h"
+#include "Log.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+
+static char const* const axisNames[] = { "MOVE_FORWARD", "MOVE_RIGHT", "MOVE_UP", "STEPS", "FRACTAL_DATA_0", "FRACTAL_DATA_1",
+	"CAMERA_SPEED", "JULIA_X", "JULIA_Y", "JULIA_Z", "JULIA_W" };
+static char const* const actionNames[] = { "QUIT", "PREVIOUS_SCENE", "NEXT_SCENE", "FEWER_ITERATIONS", "MORE_ITERATIONS",
+	"NEXT_FRACTAL_PATH", "TOGGLE_DEEP_ZOOM", "TOGGLE_DISTANCE_CACHE", "TOGGLE_TEMPORAL", "TOGGLE_ADAPTIVE_PRECISION",
+	"TOGGLE_ITERATION_LOD", "NEXT_FRACTAL_SHADING", "BENCHMARK", "TOGGLE_CURSOR", "TOGGLE_RENDER_ON_DEMAND",
+	"NEXT_FRAMES_IN_FLIGHT", "NEXT_PRESENT_MODE", "TOGGLE_LATENCY_REPORT" };
+static_assert(std::size(axisNames) == ActionMap::axisCount, "every axis needs a name");
+static_assert(std::size(actionNames) == ActionMap::actionCount, "every action needs a name");
+
+//letters and digits are their own names, the rest go by their glfw name without the GLFW_KEY_ prefix
+int keyFromName(std::string const& name)
+{
+	if (name.size() == 1 && ((name[0] >= 'A' && name[0] <= 'Z') || (name[0] >= '0' && name[0] <= '9')))
+	{
+		//glfw uses the ascii codes for both
+		return name[0];
+	}
+	if (name.size() >= 2 && name[0] == 'F' && std::isdigit((unsigned char)name[1]))
+	{
+		int number = std::stoi(name.substr(1));
+		if (number >= 1 && number <= 25)
+		{
+			return GLFW_KEY_F1 + number - 1;
+		}
+	}
+
+	static std::pair<char const*, int> const namedKeys[] = {
+		{ "SPACE", GLFW_KEY_SPACE }, { "ESCAPE", GLFW_KEY_ESCAPE }, { "ENTER", GLFW_KEY_ENTER }, { "TAB", GLFW_KEY_TAB },
+		{ "BACKSPACE", GLFW_KEY_BACKSPACE }, { "UP", GLFW_KEY_UP }, { "DOWN", GLFW_KEY_DOWN }, { "LEFT", GLFW_KEY_LEFT },
+		{ "RIGHT", GLFW_KEY_RIGHT }, { "LEFT_SHIFT", GLFW_KEY_LEFT_SHIFT }, { "RIGHT_SHIFT", GLFW_KEY_RIGHT_SHIFT },
+		{ "LEFT_CONTROL", GLFW_KEY_LEFT_CONTROL }, { "RIGHT_CONTROL", GLFW_KEY_RIGHT_CONTROL }, { "LEFT_ALT", GLFW_KEY_LEFT_ALT },
+		{ "RIGHT_ALT", GLFW_KEY_RIGHT_ALT }, { "PAGE_UP", GLFW_KEY_PAGE_UP }, { "PAGE_DOWN", GLFW_KEY_PAGE_DOWN },
+		{ "MOUSE_LEFT", GLFW_MOUSE_BUTTON_LEFT }, { "MOUSE_RIGHT", GLFW_MOUSE_BUTTON_RIGHT }, { "MOUSE_MIDDLE", GLFW_MOUSE_BUTTON_MIDDLE }
+	};
+	for (auto const& key : namedKeys)
+	{
+		if (name == key.first)
+		{
+			return key.second;
+		}
+	}
+	throw std::runtime_error("unknown key " + name + " in bindings");
+}
+
+ActionMap::ActionMap()
+{
+	axes[toUType(Axes::eMoveForward)] = { { GLFW_KEY_W, GLFW_KEY_S } };
+	axes[toUType(Axes::eMoveRight)] = { { GLFW_KEY_D, GLFW_KEY_A } };
+	axes[toUType(Axes::eMoveUp)] = { { GLFW_KEY_LEFT_SHIFT, GLFW_KEY_LEFT_CONTROL } };
+	axes[toUType(Axes::eSteps)] = { { GLFW_KEY_UP, GLFW_KEY_DOWN } };
+	axes[toUType(Axes::eFractalData0)] = { { GLFW_KEY_E, GLFW_KEY_Q } };
+	axes[toUType(Axes::eFractalData1)] = { { GLFW_KEY_X, GLFW_KEY_Z } };
+	axes[toUType(Axes::eCameraSpeed)] = { { GLFW_KEY_G, GLFW_KEY_F } };
+	axes[toUType(Axes::eJuliaX)] = { { GLFW_KEY_2, GLFW_KEY_1 } };
+	axes[toUType(Axes::eJuliaY)] = { { GLFW_KEY_4, GLFW_KEY_3 } };
+	axes[toUType(Axes::eJuliaZ)] = { { GLFW_KEY_6, GLFW_KEY_5 } };
+	axes[toUType(Axes::eJuliaW)] = { { GLFW_KEY_8, GLFW_KEY_7 } };
+
+	actions[toUType(Actions::eQuit)] = { GLFW_KEY_ESCAPE };
+	actions[toUType(Actions::ePreviousScene)] = { GLFW_KEY_LEFT };
+	actions[toUType(Actions::eNextScene)] = { GLFW_KEY_RIGHT };
+	actions[toUType(Actions::eFewerIterations)] = { GLFW_KEY_R };
+	actions[toUType(Actions::eMoreIterations)] = { GLFW_KEY_T };
+	actions[toUType(Actions::eNextFractalPath)] = { GLFW_KEY_C };
+	actions[toUType(Actions::eToggleDeepZoom)] = { GLFW_KEY_V };
+	actions[toUType(Actions::eToggleDistanceCache)] = { GLFW_KEY_N };
+	actions[toUType(Actions::eToggleTemporal)] = { GLFW_KEY_H };
+	actions[toUType(Actions::eToggleAdaptivePrecision)] = { GLFW_KEY_J };
+	actions[toUType(Actions::eToggleIterationLod)] = { GLFW_KEY_L };
+	actions[toUType(Actions::eNextFractalShading)] = { GLFW_KEY_M };
+	actions[toUType(Actions::eBenchmark)] = { GLFW_KEY_B };
+	actions[toUType(Actions::eToggleCursor)] = { GLFW_KEY_SPACE };
+	actions[toUType(Actions::eToggleRenderOnDemand)] = { GLFW_KEY_O };
+	actions[toUType(Actions::eNextFramesInFlight)] = { GLFW_KEY_I };
+	actions[toUType(Actions::eNextPresentMode)] = { GLFW_KEY_P };
+	actions[toUType(Actions::eToggleLatencyReport)] = { GLFW_KEY_K };
+}
+
+void ActionMap::load(std::string const& filename)
+{
+	std::ifstream file{ filename };
+	if (!file.is_open())
+	{
+		LOG_WARNING("couldn't open bindings file, using default bindings");
+		return;
+	}
+
+	std::array<bool, axisCount> axisLoaded = {};
+	std::array<bool, actionCount> actionLoaded = {};
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		std::istringstream words(line);
+		std::string kind, name;
+		if (!(words >> kind) || kind.rfind("//", 0) == 0)
+		{
+			continue;
+		}
+		if (!(words >> name))
+		{
+			throw std::runtime_error("missing name on bindings line " + std::to_string(lineNumber));
+		}
+
+		if (kind == "AXIS")
+		{
+			auto found = std::find_if(std::begin(axisNames), std::end(axisNames), [&name](char const* axisName) { return name == axisName; });
+			std::string positive, negative;
+			if (found == std::end(axisNames) || !(words >> positive >> negative))
+			{
+				throw std::runtime_error("bad axis binding on bindings line " + std::to_string(lineNumber));
+			}
+			size_t index = found - std::begin(axisNames);
+			if (!axisLoaded[index])
+			{
+				axes[index].clear();
+				axisLoaded[index] = true;
+			}
+			axes[index].push_back({ keyFromName(positive), keyFromName(negative) });
+		}
+		else if (kind == "ACTION")
+		{
+			auto found = std::find_if(std::begin(actionNames), std::end(actionNames), [&name](char const* actionName) { return name == actionName; });
+			std::string key;
+			if (found == std::end(actionNames) || !(words >> key))
+			{
+				throw std::runtime_error("bad action binding on bindings line " + std::to_string(lineNumber));
+			}
+			size_t index = found - std::begin(actionNames);
+			if (!actionLoaded[index])
+			{
+				actions[index].clear();
+				actionLoaded[index] = true;
+			}
+			actions[index].push_back(keyFromName(key));
+		}
+		else
+		{
+			throw std::runtime_error("unknown binding kind " + kind + " on bindings line " + std::to_string(lineNumber));
+		}
+	}
+	LOG_DEBUG("loaded bindings from {}", filename);
+}
+
+float ActionMap::axis(Axes axis, InputState const& input) const
+{
+	float value = 0.0f;
+	for (auto const& binding : axes[toUType(axis)])
+	{
+		value += (input.isHeld(binding.positive) ? 1.0f : 0.0f) - (input.isHeld(binding.negative) ? 1.0f : 0.0f);
+	}
+	return std::clamp(value, -1.0f, 1.0f);
+}
+
+bool ActionMap::triggered(Actions action, InputState const& input) const
+{
+	for (int key : actions[toUType(action)])
+	{
+		if (input.wasPressed(key))
+		{
+			return true;
+		}
+	}
+	return false;
+}
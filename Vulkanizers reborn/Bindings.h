@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Constants.h"
+#include "Input.h"
+#include <array>
+#include <vector>
+#include <string>
+
+//held keys that move a value continuously, scaled by the elapsed update time
+enum class Axes
+{
+	eMoveForward, eMoveRight, eMoveUp, eSteps, eFractalData0, eFractalData1, eCameraSpeed,
+	eJuliaX, eJuliaY, eJuliaZ, eJuliaW
+};
+
+//pressed keys that do something once
+enum class Actions
+{
+	eQuit, ePreviousScene, eNextScene, eFewerIterations, eMoreIterations, eNextFractalPath, eToggleDeepZoom,
+	eToggleDistanceCache, eToggleTemporal, eToggleAdaptivePrecision, eToggleIterationLod, eNextFractalShading,
+	eBenchmark, eToggleCursor, eToggleRenderOnDemand, eNextFramesInFlight, eNextPresentMode, eToggleLatencyReport
+};
+
+//which keys drive which axes and actions, the defaults can be overridden by a bindings file
+class ActionMap
+{
+public:
+	static constexpr size_t axisCount = toUType(Axes::eJuliaW) + 1;
+	static constexpr size_t actionCount = toUType(Actions::eToggleLatencyReport) + 1;
+
+	//default bindings
+	ActionMap();
+
+	//lines of AXIS name positiveKey negativeKey or ACTION name key, // starts a comment line
+	//every axis and action the file names loses its default keys, the rest keep them
+	void load(std::string const& filename);
+
+	//positive minus negative keys held, between -1 and 1
+	float axis(Axes axis, InputState const& input) const;
+	bool triggered(Actions action, InputState const& input) const;
+
+private:
+	struct AxisBinding
+	{
+		int positive;
+		int negative;
+	};
+
+	std::array<std::vector<AxisBinding>, axisCount> axes;
+	std::array<std::vector<int>, actionCount> actions;
+};
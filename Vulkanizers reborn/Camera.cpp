@@ -1,14 +1,14 @@
 #include "Camera.h"
 
 Camera::Camera()
-	:position{ glm::vec3(0.0f, 0.0f, 0.0f) }, focalLength{ 1.0 }, pitch{ 0.0f }, yaw{ 0.0f }, speed{ 0.5f }
+	:position{ glm::dvec3(0.0, 0.0, 0.0) }, focalLength{ 1.0 }, pitch{ 0.0f }, yaw{ 0.0f }, speed{ defaultSpeed }
 {
 	updateDirection();
 	calculateUpAndRight();
 }
 
-Camera::Camera(glm::vec3 const& position, glm::vec3 const& target, float focalLength)
-	: position{ position }, focalLength{ focalLength }, direction{ glm::normalize(target - position) }, speed{ 0.5f }
+Camera::Camera(glm::dvec3 const& position, glm::dvec3 const& target, float focalLength)
+	: position{ position }, focalLength{ focalLength }, direction{ glm::vec3(glm::normalize(target - position)) }, speed{ defaultSpeed }
 {
 	calculateEulerAngles();
 	calculateUpAndRight();
@@ -22,9 +22,9 @@ void Camera::orient(float pitch, float yaw)
 	calculateUpAndRight();
 }
 
-void Camera::point(glm::vec3 const& target)
+void Camera::point(glm::dvec3 const& target)
 {
-	direction = glm::normalize(target - position);
+	direction = glm::vec3(glm::normalize(target - position));
 	calculateEulerAngles();
 }
 
@@ -7,16 +7,18 @@ class Camera
 {
 public:
 	Camera();
-	Camera(glm::vec3 const& position, glm::vec3 const& target, float focalLength);
+	Camera(glm::dvec3 const& position, glm::dvec3 const& target, float focalLength);
 
 	void orient(float pitch, float yaw);
-	void point(glm::vec3 const& target);
+	void point(glm::dvec3 const& target);
+
+	static constexpr float defaultSpeed = 0.5f;
 
 	float focalLength;
 	float pitch;
 	float yaw;
 	float speed;
-	glm::vec3 position;
+	glm::dvec3 position;	//double so deep zoom can move by less than a float ulp
 	glm::vec3 direction;
 	glm::vec3 right;
 	glm::vec3 up;
@@ -1,66 +1,228 @@
 #include "Constants.h"
+#include "Log.h"
+#include <sstream>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
 
 unsigned int Settings::WINDOW_WIDTH = 800;
 unsigned int Settings::WINDOW_HEIGHT = 800;
 float Settings::CURSOR_SIZE = 20.0f;
+bool Settings::RENDER_ON_DEMAND = false;
+float Settings::RESOLUTION_SCALE = 1.0f;
+unsigned int Settings::FRAMES_IN_FLIGHT = 2;
+vk::PresentModeKHR Settings::PRESENT_MODE = vk::PresentModeKHR::eMailbox;
+unsigned int Settings::MAX_SPRITES = 0;
+bool Settings::LATENCY_REPORT = false;
+bool Settings::CHECK_FRAME_ORDER = false;
+LogLevel Settings::LOG_LEVEL = LogLevel::eInfo;
+std::string Settings::LOG_FILE = "";
+bool Settings::ALLOW_SOFTWARE_DEVICE = false;
+bool Settings::HIDE_WINDOW = false;
+unsigned int Settings::EXIT_AFTER_FRAMES = 0;
+bool Settings::VALIDATION_LAYERS = enableValidationLayers;
 
 std::string Settings::SPRITE_FRAG_SHADER_PATH = "shaders/sprite_frag.spv";
 std::string Settings::SPRITE_VERT_SHADER_PATH = "shaders/sprite_vert.spv";
 std::string Settings::FRACTAL_FRAG_SHADER_PATH = "shaders/fractal_frag.spv";
 std::string Settings::FRACTAL_VERT_SHADER_PATH = "shaders/fractal_vert.spv";
+std::string Settings::FRACTAL_COMP_SHADER_PATH = "shaders/fractal_comp.spv";
+std::string Settings::FRACTAL_COMPOSITE_FRAG_SHADER_PATH = "shaders/fractal_composite_frag.spv";
+std::string Settings::FRACTAL_BAKE_SHADER_PATH = "shaders/fractal_bake.spv";
+std::string Settings::FRACTAL_REPROJECT_SHADER_PATH = "shaders/fractal_reproject.spv";
 
-std::any loadSetting(std::ifstream& file, std::string const& settingName, SettingTypes settingType)
+static SettingEntry const settingRegistry[] = {
+	{ "WINDOW_WIDTH", &Settings::WINDOW_WIDTH, 1, 16384 },
+	{ "WINDOW_HEIGHT", &Settings::WINDOW_HEIGHT, 1, 16384 },
+	{ "CURSOR_SIZE", &Settings::CURSOR_SIZE, 0, 1000 },
+	{ "RENDER_ON_DEMAND", &Settings::RENDER_ON_DEMAND, 0, 1 },
+	{ "RESOLUTION_SCALE", &Settings::RESOLUTION_SCALE, 0.1, 1 },
+	{ "FRAMES_IN_FLIGHT", &Settings::FRAMES_IN_FLIGHT, 1, Settings::MAX_FRAMES_IN_FLIGHT },
+	{ "PRESENT_MODE", &Settings::PRESENT_MODE, 0, 0 },
+	{ "MAX_SPRITES", &Settings::MAX_SPRITES, 0, 4294967295.0 },
+	{ "LATENCY_REPORT", &Settings::LATENCY_REPORT, 0, 1 },
+	{ "CHECK_FRAME_ORDER", &Settings::CHECK_FRAME_ORDER, 0, 1 },
+	{ "LOG_LEVEL", &Settings::LOG_LEVEL, 0, 0 },
+	{ "LOG_FILE", &Settings::LOG_FILE, 0, 0 },
+	{ "ALLOW_SOFTWARE_DEVICE", &Settings::ALLOW_SOFTWARE_DEVICE, 0, 1 },
+	{ "HIDE_WINDOW", &Settings::HIDE_WINDOW, 0, 1 },
+	{ "EXIT_AFTER_FRAMES", &Settings::EXIT_AFTER_FRAMES, 0, 4294967295.0 },
+	{ "VALIDATION_LAYERS", &Settings::VALIDATION_LAYERS, 0, 1 },
+	{ "SPRITE_FRAG_SHADER_PATH", &Settings::SPRITE_FRAG_SHADER_PATH, 0, 0 },
+	{ "SPRITE_VERT_SHADER_PATH", &Settings::SPRITE_VERT_SHADER_PATH, 0, 0 },
+	{ "FRACTAL_FRAG_SHADER_PATH", &Settings::FRACTAL_FRAG_SHADER_PATH, 0, 0 },
+	{ "FRACTAL_VERT_SHADER_PATH", &Settings::FRACTAL_VERT_SHADER_PATH, 0, 0 },
+	{ "FRACTAL_COMP_SHADER_PATH", &Settings::FRACTAL_COMP_SHADER_PATH, 0, 0 },
+	{ "FRACTAL_COMPOSITE_FRAG_SHADER_PATH", &Settings::FRACTAL_COMPOSITE_FRAG_SHADER_PATH, 0, 0 },
+	{ "FRACTAL_BAKE_SHADER_PATH", &Settings::FRACTAL_BAKE_SHADER_PATH, 0, 0 },
+	{ "FRACTAL_REPROJECT_SHADER_PATH", &Settings::FRACTAL_REPROJECT_SHADER_PATH, 0, 0 }
+};
+
+static std::pair<char const*, vk::PresentModeKHR> const presentModeNames[] = {
+	{ "immediate", vk::PresentModeKHR::eImmediate }, { "mailbox", vk::PresentModeKHR::eMailbox },
+	{ "fifo", vk::PresentModeKHR::eFifo }, { "fifo_relaxed", vk::PresentModeKHR::eFifoRelaxed }
+};
+
+static std::pair<char const*, LogLevel> const logLevelNames[] = {
+	{ "trace", LogLevel::eTrace }, { "debug", LogLevel::eDebug }, { "info", LogLevel::eInfo },
+	{ "warning", LogLevel::eWarning }, { "error", LogLevel::eError }
+};
+
+static SettingEntry const* findSetting(std::string const& name)
+{
+	for (auto const& setting : settingRegistry)
+	{
+		if (name == setting.name)
+		{
+			return &setting;
+		}
+	}
+	return nullptr;
+}
+
+//the whole text has to be the number, or true, false, 1 and 0 for bools
+static void parseSetting(SettingEntry const& setting, std::string const& text, std::string const& source)
+{
+	std::istringstream stream(text);
+	auto fail = [&]() { return std::runtime_error("bad value " + text + " for " + setting.name + " in " + source); };
+	auto checkRange = [&](double value)
+	{
+		if (stream.fail() || !stream.eof() || value < setting.min || value > setting.max)
+		{
+			throw fail();
+		}
+	};
+
+	if (auto value = std::get_if<unsigned int*>(&setting.value))
+	{
+		//istream takes a minus sign for unsigned values and wraps around
+		long long number = -1;
+		stream >> number;
+		checkRange((double)number);
+		**value = (unsigned int)number;
+	}
+	else if (auto value = std::get_if<float*>(&setting.value))
+	{
+		float number = 0.0f;
+		stream >> number;
+		checkRange(number);
+		**value = number;
+	}
+	else if (auto value = std::get_if<bool*>(&setting.value))
+	{
+		if (text != "true" && text != "false" && text != "1" && text != "0")
+		{
+			throw fail();
+		}
+		**value = text == "true" || text == "1";
+	}
+	else if (auto value = std::get_if<std::string*>(&setting.value))
+	{
+		if (text.empty())
+		{
+			throw fail();
+		}
+		**value = text;
+	}
+	else if (auto value = std::get_if<vk::PresentModeKHR*>(&setting.value))
+	{
+		for (auto const& mode : presentModeNames)
+		{
+			if (text == mode.first)
+			{
+				**value = mode.second;
+				return;
+			}
+		}
+		throw fail();
+	}
+	else if (auto value = std::get_if<LogLevel*>(&setting.value))
+	{
+		for (auto const& level : logLevelNames)
+		{
+			if (text == level.first)
+			{
+				**value = level.second;
+				return;
+			}
+		}
+		throw fail();
+	}
+}
+
+static std::string settingToString(SettingEntry const& setting)
 {
-	std::string name;
-	std::any value;
-	file >> name;
-	if (file.fail())
+	if (auto value = std::get_if<unsigned int*>(&setting.value))
 	{
-		throw std::runtime_error("config file input error");
+		return std::to_string(**value);
 	}
-	if (name != settingName)
+	if (auto value = std::get_if<float*>(&setting.value))
 	{
-		throw std::runtime_error(settingName + " doesn't match config name");
+		std::ostringstream stream;
+		stream << **value;
+		return stream.str();
 	}
-	switch (settingType)
+	if (auto value = std::get_if<bool*>(&setting.value))
 	{
-	case SettingTypes::eUInt:
+		return **value ? "true" : "false";
+	}
+	if (auto value = std::get_if<std::string*>(&setting.value))
 	{
-		unsigned int temp;
-		file >> temp;
-		value = temp;
-		break;
+		return **value;
 	}
-	case SettingTypes::eUShort:
+	if (auto value = std::get_if<LogLevel*>(&setting.value))
 	{
-		unsigned short temp;
-		file >> temp;
-		value = temp;
-		break;
+		for (auto const& level : logLevelNames)
+		{
+			if (**value == level.second)
+			{
+				return level.first;
+			}
+		}
+		return "unknown";
 	}
-	case SettingTypes::eFloat:
+	for (auto const& mode : presentModeNames)
 	{
-		float temp;
-		file >> temp;
-		value = temp;
-		break;
+		if (*std::get<vk::PresentModeKHR*>(setting.value) == mode.second)
+		{
+			return mode.first;
+		}
 	}
-	case SettingTypes::eString:
+	return "unknown";
+}
+
+//FRAMES_IN_FLIGHT goes by --frames-in-flight
+static std::string argumentName(char const* name)
+{
+	std::string argument = "--";
+	for (char const* c = name; *c; c++)
 	{
-		std::string temp;
-		file >> temp;
-		value = temp;
-		break;
+		argument += *c == '_' ? '-' : (char)std::tolower((unsigned char)*c);
 	}
-	default:
-		throw std::runtime_error("unknown type in config loadSetting()");
-		break;
+	return argument;
+}
+
+bool readEnvironmentVariable(char const* name, std::string& value)
+{
+#ifdef _MSC_VER
+	char* buffer = nullptr;
+	size_t length = 0;
+	if (_dupenv_s(&buffer, &length, name) != 0 || !buffer)
+	{
+		return false;
 	}
-	if (file.fail())
+	value = buffer;
+	free(buffer);
+	return true;
+#else
+	char const* buffer = std::getenv(name);
+	if (!buffer)
 	{
-		throw std::runtime_error("config file value error");
+		return false;
 	}
-	return value;
+	value = buffer;
+	return true;
+#endif
 }
 
 void loadConfig(std::string const& filename)
@@ -68,15 +230,105 @@ void loadConfig(std::string const& filename)
 	std::ifstream file{ filename, file.binary | file.in };
 	if (!file.is_open())
 	{
-		std::cout << "couldn't open config file\n";
+		LOG_WARNING("couldn't open config file {}, using the defaults", filename);
 		return;
 	}
 
-	Settings::WINDOW_WIDTH = std::any_cast<unsigned int>(loadSetting(file, "WINDOW_WIDTH", SettingTypes::eUInt));
-	Settings::WINDOW_HEIGHT = std::any_cast<unsigned int>(loadSetting(file, "WINDOW_HEIGHT", SettingTypes::eUInt));
-	Settings::CURSOR_SIZE = std::any_cast<float>(loadSetting(file, "CURSOR_SIZE", SettingTypes::eFloat));
-	Settings::SPRITE_FRAG_SHADER_PATH = std::any_cast<std::string>(loadSetting(file, "SPRITE_FRAG_SHADER_PATH", SettingTypes::eString));
-	Settings::SPRITE_VERT_SHADER_PATH = std::any_cast<std::string>(loadSetting(file, "SPRITE_VERT_SHADER_PATH", SettingTypes::eString));
-	Settings::FRACTAL_FRAG_SHADER_PATH = std::any_cast<std::string>(loadSetting(file, "FRACTAL_FRAG_SHADER_PATH", SettingTypes::eString));
-	Settings::FRACTAL_VERT_SHADER_PATH = std::any_cast<std::string>(loadSetting(file, "FRACTAL_VERT_SHADER_PATH", SettingTypes::eString));
-}
\ No newline at end of file
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		std::istringstream words(line);
+		std::string name, value;
+		words >> name;
+		if (name.empty() || name.compare(0, 2, "//") == 0)
+		{
+			continue;
+		}
+		//the value is the rest of the line, strings like paths can have spaces in them
+		std::getline(words >> std::ws, value);
+		value.erase(value.find_last_not_of(" \t\r") + 1);
+		std::string source = filename + " line " + std::to_string(lineNumber);
+		SettingEntry const* setting = findSetting(name);
+		if (!setting)
+		{
+			throw std::runtime_error("unknown setting " + name + " in " + source);
+		}
+		if (!std::holds_alternative<std::string*>(setting->value) && value.find_first_of(" \t") != std::string::npos)
+		{
+			throw std::runtime_error("extra text after the value of " + name + " in " + source);
+		}
+		parseSetting(*setting, value, source);
+	}
+}
+
+void applySettingOverrides(int argc, char* argv[])
+{
+	for (auto const& setting : settingRegistry)
+	{
+		std::string variable = std::string("VULKANIZERS_") + setting.name;
+		std::string value;
+		if (readEnvironmentVariable(variable.c_str(), value))
+		{
+			parseSetting(setting, value, "environment variable " + variable);
+		}
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		//kept from before there were settings on the command line
+		if (argument == "--on-demand")
+		{
+			Settings::RENDER_ON_DEMAND = true;
+			continue;
+		}
+
+		std::string value;
+		bool hasValue = false;
+		size_t equals = argument.find('=');
+		if (equals != std::string::npos)
+		{
+			value = argument.substr(equals + 1);
+			argument.resize(equals);
+			hasValue = true;
+		}
+
+		SettingEntry const* setting = nullptr;
+		for (auto const& entry : settingRegistry)
+		{
+			if (argument == argumentName(entry.name))
+			{
+				setting = &entry;
+				break;
+			}
+		}
+		if (!setting)
+		{
+			throw std::runtime_error("unknown argument " + argument);
+		}
+
+		if (!hasValue)
+		{
+			if (std::holds_alternative<bool*>(setting->value) && (i + 1 == argc || std::strncmp(argv[i + 1], "--", 2) == 0))
+			{
+				value = "true";
+			}
+			else if (i + 1 < argc)
+			{
+				value = argv[++i];
+			}
+		}
+		parseSetting(*setting, value, "argument " + argument);
+	}
+}
+
+void printSettings()
+{
+	std::cout << "settings:\n";
+	for (auto const& setting : settingRegistry)
+	{
+		std::cout << "\t" << setting.name << " " << settingToString(setting) << "\n";
+	}
+}
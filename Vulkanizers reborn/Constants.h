@@ -4,10 +4,14 @@
 #include <vulkan/vulkan.hpp>
 #include <vector>
 #include <cassert>
-#include <any>
+#include <variant>
+#include <string>
 #include <fstream>
 #include <iostream>
 #include <GLFW/glfw3.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #ifdef NDEBUG
 const bool enableValidationLayers = false;
@@ -27,23 +31,59 @@ enum class SpriteLayers
 	eBackground, eGround, eAir, eGUI
 };
 
-enum class SettingTypes
+//how the fractal is marched, compute paths write a storage image that gets composited
+enum class FractalPaths
+{
+	eFragment, eCompute, eComputeWavefront
+};
+
+//share of the pixels the compute paths march every frame, the rest is reconstructed
+enum class FractalShading
 {
-	eUInt, eUShort, eFloat, eString
+	eFull, eCheckerboard, eQuarter
 };
 
+//severity of a log record, records below LOG_LEVEL are skipped
+enum class LogLevel : uint8_t
+{
+	eTrace, eDebug, eInfo, eWarning, eError
+};
+
+//every setting is a static here, settingRegistry in Constants.cpp lists the ones that can be set from outside
 struct Settings
 {
 	static unsigned int WINDOW_WIDTH;
 	static unsigned int WINDOW_HEIGHT;
 	static float CURSOR_SIZE;
-	static constexpr unsigned int MAX_FRAMES_IN_FLIGHT = 2;
-	static constexpr unsigned short MAX_SPRITES = 512;
-	static constexpr unsigned short MAX_TEXTURES = 64;
+	static bool RENDER_ON_DEMAND;	//only draw frames that look different, --on-demand sets it too
+	static float RESOLUTION_SCALE;	//share of the window's width and height the compute fractal paths march
+	static unsigned int FRAMES_IN_FLIGHT;	//frames the cpu can record ahead of the gpu
+	static constexpr unsigned int MAX_FRAMES_IN_FLIGHT = 4;
+	static vk::PresentModeKHR PRESENT_MODE;	//falls back to fifo where the surface doesn't support it
+	static unsigned int MAX_SPRITES;	//adding more throws, 0 for no limit
+	static bool LATENCY_REPORT;	//print input to present latency every second
+	static bool CHECK_FRAME_ORDER;	//verify every frame wait against the timeline semaphore, throws if frames retire out of order
+	static LogLevel LOG_LEVEL;		//sites below it cost a branch, debug builds compile in every level and release builds info and up
+	static std::string LOG_FILE;	//binary log written next to the console output, empty for none, --format-log prints it
+	static bool ALLOW_SOFTWARE_DEVICE;	//let cpu implementations like lavapipe be picked, still only when no gpu is suitable
+	static bool HIDE_WINDOW;		//for unattended runs like --frame-order-test
+	static unsigned int EXIT_AFTER_FRAMES;	//close the window once this many frames were submitted, 0 keeps running
+	static bool VALIDATION_LAYERS;	//on in debug builds, turning it off profiles a debug build without the layers' overhead
+	static constexpr unsigned int FRACTAL_STEPS_PER_PASS = 16;	//march steps per wavefront pass before compaction
+	static constexpr unsigned int FRACTAL_CACHE_GRID = 64;		//distance cache cells per axis, matches CACHE_GRID
+	static constexpr unsigned int FRACTAL_CACHE_BRICK = 8;		//samples per brick axis, matches CACHE_BRICK
+	static constexpr unsigned int FRACTAL_CACHE_MAX_BRICKS = 16384;	//cells past this use the exact DE
+	static constexpr float FRACTAL_PIXEL_FOOTPRINT = 0.5f;	//adaptive precision hit threshold, in pixel footprints at the hit distance
+	static constexpr float FRACTAL_LOD_DISTANCE = 2.0f;		//distance where iteration lod starts dropping iterations
+	static constexpr float FRACTAL_LOD_ITERATIONS = 1.0f;	//iterations dropped per doubling of the distance past that
 	static std::string SPRITE_FRAG_SHADER_PATH;
 	static std::string SPRITE_VERT_SHADER_PATH;
 	static std::string FRACTAL_FRAG_SHADER_PATH;
 	static std::string FRACTAL_VERT_SHADER_PATH;
+	static std::string FRACTAL_COMP_SHADER_PATH;
+	static std::string FRACTAL_COMPOSITE_FRAG_SHADER_PATH;
+	static std::string FRACTAL_BAKE_SHADER_PATH;
+	static std::string FRACTAL_REPROJECT_SHADER_PATH;
 };
 
 const std::vector<char const*> validationLayers = {
@@ -54,19 +94,13 @@ const std::vector<char const*> deviceExtensions = {
 	VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
-//keys that are polled every frame
-const std::vector<short> mappedKeys = {
-	GLFW_KEY_ESCAPE, GLFW_KEY_SPACE, GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT,
-	GLFW_KEY_RIGHT, GLFW_KEY_K, GLFW_KEY_P, GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_S, GLFW_KEY_Q, GLFW_KEY_E, GLFW_KEY_LEFT_SHIFT, GLFW_KEY_LEFT_CONTROL,
-	GLFW_KEY_Z, GLFW_KEY_X, GLFW_KEY_R, GLFW_KEY_T, GLFW_KEY_G, GLFW_KEY_F, GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4, GLFW_KEY_5, GLFW_KEY_6, GLFW_KEY_7, GLFW_KEY_8
-};
-
-const std::vector<char> mappedMouseKeys = {
-	GLFW_MOUSE_BUTTON_LEFT
-};
-
-const std::vector<char const*> configSettingNames = {
-	"WINDOW_WIDTH", "WINDOW_HEIGHT", "CURSOR_SIZE", "MAX_FRAMES_IN_FLIGHT", "MAX_SPRITES", "MAX_TEXTURES", "FRAG_SHADER_PATH", "VERT_SHADER_PATH"
+//a setting that can come from the config file, the environment or the command line
+struct SettingEntry
+{
+	char const* name;	//NAME in the config file, VULKANIZERS_NAME in the environment, --name on the command line
+	std::variant<unsigned int*, float*, bool*, std::string*, vk::PresentModeKHR*, LogLevel*> value;
+	double min;			//numbers outside min and max are rejected
+	double max;
 };
 
 //returns underlying type of the enumerator
@@ -76,6 +110,18 @@ constexpr auto toUType(E enumerator) noexcept
 	return static_cast<std::underlying_type_t<E>>(enumerator);
 }
 
+//index of the lowest set bit, value mustn't be 0
+inline uint32_t lowestSetBit(uint64_t value) noexcept
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return index;
+#else
+	return (uint32_t)__builtin_ctzll(value);
+#endif
+}
+
 //floor value but constexpr
 constexpr int cfloor(double num)
 {
@@ -104,6 +150,13 @@ constexpr int convertYToRow(double y) noexcept
 	return cfloor(y * 4.0 + 4.0);
 }
 
-std::any loadSetting(std::ifstream& file, std::string const& settingName, SettingTypes settingType);
+//true if name is set in the environment, its value goes to value
+bool readEnvironmentVariable(char const* name, std::string& value);
 
-void loadConfig(std::string const& filename);
\ No newline at end of file
+//NAME value lines in any order, // starts a comment line, throws on unknown names and bad values
+void loadConfig(std::string const& filename);
+//environment variables first, then --name value or --name=value arguments, bools can leave the value out
+//throws on unknown arguments and bad values
+void applySettingOverrides(int argc, char* argv[]);
+//every registered setting and its value, so a benchmark log says what it ran with
+void printSettings();
\ No newline at end of file
@@ -48,11 +48,13 @@ void Cursor::update(GLFWwindow* window)
 	double newXPos = 0.0, newYPos = 0.0;
 	glfwGetCursorPos(window, &newXPos, &newYPos);
 
-	//convert screen coords to (-1, 1) range
-	if (sprite.vulkan)
+	//convert screen coords to (-1, 1) range, the swap chain extent belongs to the render thread
+	int width = 0, height = 0;
+	glfwGetWindowSize(window, &width, &height);
+	if (sprite.vulkan && width > 0 && height > 0)
 	{
-		newXPos = newXPos * 2.0 / sprite.vulkan->swapChainExtent.width - 1.0;
-		newYPos = -newYPos * 2.0 / sprite.vulkan->swapChainExtent.height + 1.0;
+		newXPos = newXPos * 2.0 / width - 1.0;
+		newYPos = -newYPos * 2.0 / height + 1.0;
 	}
 
 	//move sprite so top left part of cursor is at the center
@@ -21,7 +21,6 @@ public:
 	Cursor(Cursor&&) = default;
 	Cursor& operator=(Cursor&&) = default;
 
-	void recreateSprite() { createSprite(sprite.vulkan); }	//remake the graphics component
 	void update(GLFWwindow* window);						//update position and move sprite
 	void createSprite(VulkanResources* vulkan);
 	void deleteSprite();
@@ -59,8 +58,6 @@ public:
 	Outline(Outline&&) = default;
 	Outline& operator=(Outline&&) = default;
 
-	void recreateSprite() { createSprite(sprite.vulkan); }	//remake the graphics component
-
 	int row;
 	int column;
 private:
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+//bump allocator for data that only lives for one frame, reset once nothing of the frame uses it anymore
+//takes its memory once up front, running out throws instead of growing
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t capacity)
+		:memory{ std::make_unique<std::byte[]>(capacity) }, capacity{ capacity }, offset{ 0 }, highWater{ 0 }
+	{
+
+	}
+
+	FrameArena(FrameArena const&) = delete;
+	FrameArena& operator=(FrameArena const&) = delete;
+
+	//destructors never run, so only trivially destructible types
+	template<typename T, typename... Args>
+	T* make(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "frame arena objects are never destroyed");
+		static_assert(alignof(T) <= alignof(std::max_align_t), "new[] only aligns the arena's memory this far");
+		return new (allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+	}
+	//count value initialized elements
+	template<typename T>
+	T* makeArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "frame arena objects are never destroyed");
+		static_assert(alignof(T) <= alignof(std::max_align_t), "new[] only aligns the arena's memory this far");
+		return new (allocate(sizeof(T) * count, alignof(T))) T[count]();
+	}
+
+	//everything made since the last reset is gone
+	void reset() noexcept { offset = 0; }
+	//most bytes a frame used, for sizing the arena
+	size_t getHighWater() const noexcept { return highWater; }
+
+private:
+	void* allocate(size_t size, size_t alignment)
+	{
+		size_t start = (offset + alignment - 1) & ~(alignment - 1);
+		if (start + size > capacity)
+		{
+			throw std::runtime_error("frame arena of " + std::to_string(capacity) + " bytes is full");
+		}
+		offset = start + size;
+		highWater = offset > highWater ? offset : highWater;
+		return memory.get() + start;
+	}
+
+	std::unique_ptr<std::byte[]> memory;
+	size_t capacity;
+	size_t offset;		//first free byte
+	size_t highWater;
+};
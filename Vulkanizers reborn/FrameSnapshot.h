@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Constants.h"
+#include "Camera.h"
+#include "Sprite.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+//everything the render thread needs to draw a frame, filled by the update thread and read-only once published
+struct FrameSnapshot
+{
+	uint64_t sequence = 0;			//counts published snapshots, 0 until the first one
+	Camera camera;
+	float steps = 0.0f;
+	std::vector<float> fractalData;
+	float iterations = 0.0f;
+	int estimator = 0;				//distance estimator of the scene
+	glm::vec4 sceneBounds = glm::vec4(0.0f);	//bounding sphere center and radius, 0 radius if unbounded
+	glm::vec4 juliaC = glm::vec4(0.0f);
+	FractalPaths fractalPath = FractalPaths::eFragment;
+	bool deepZoom = false;
+	bool distanceCache = false;
+	bool temporal = false;
+	bool adaptivePrecision = false;
+	bool iterationLod = false;
+	FractalShading fractalShading = FractalShading::eFull;
+	uint32_t captureRequests = 0;	//counts requested fractal captures so a skipped snapshot can't lose one
+	bool renderOnDemand = false;	//the render thread idles while sceneVersion stays the same
+	uint64_t sceneVersion = 0;		//bumped whenever something the picture depends on changed
+	uint32_t framesInFlight = 0;	//the render thread rebuilds its sync objects when this changes
+	vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo;	//and its swap chain when this does
+	bool measureLatency = false;
+	double inputTime = -1.0;		//glfw time of the first key or button event of the newest update that had any, negative before that
+
+	SpriteArrays sprites;
+
+	//true if every value the picture depends on apart from the sprites is the same
+	bool drawsSameAs(FrameSnapshot const& other) const
+	{
+		return camera.position == other.camera.position && camera.direction == other.camera.direction && camera.right == other.camera.right &&
+			camera.up == other.camera.up && camera.focalLength == other.camera.focalLength && steps == other.steps &&
+			fractalData == other.fractalData && iterations == other.iterations && estimator == other.estimator && sceneBounds == other.sceneBounds &&
+			juliaC == other.juliaC && fractalPath == other.fractalPath && deepZoom == other.deepZoom && distanceCache == other.distanceCache &&
+			temporal == other.temporal && adaptivePrecision == other.adaptivePrecision && iterationLod == other.iterationLod &&
+			fractalShading == other.fractalShading && captureRequests == other.captureRequests && renderOnDemand == other.renderOnDemand &&
+			framesInFlight == other.framesInFlight && presentMode == other.presentMode;
+	}
+};
+
+//what the render thread reports back about a submitted frame
+struct FrameResult
+{
+	uint64_t sequence;	//snapshot it was drawn from
+	float fractalTime;	//gpu time of the fractal pass in ms, negative if timestamps are unsupported
+	float frameTime;	//cpu time since the previous frame in ms
+	SpriteDrawStats spriteStats;
+	float inputLatency;	//ms from the input the frame is the first to show to its present, negative if it shows no new input
+};
@@ -1,27 +1,52 @@
 #include "Game.h"
 #include "Sound.h"
+#include "Log.h"
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static char const* const fractalPathNames[] = { "fragment", "compute", "compute wavefront" };
+static char const* const fractalShadingNames[] = { "full", "checkerboard", "quarter" };
+static vk::PresentModeKHR const presentModes[] = { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox,
+	vk::PresentModeKHR::eFifo, vk::PresentModeKHR::eFifoRelaxed };
 
 Game::Game()
 	:lastFrameTime{ 0 }, deltaTime{ 0 }, fpsFramesRendered{ 0 }, fpsTimePassed{ 0.0f },
-	updateTime{ 0.0f }, gameOver{ false }, soundEngine{ std::make_unique<SoundEngine>() }, vulkan{ std::make_unique<VulkanResources>(this) },
-	cursor{ vulkan.get(), Settings::CURSOR_SIZE }, random{}, gen{ random() }, camera{ glm::vec3(2.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), 1.0f }, steps{ 100.0f }, fractalData{ 0.15f, 0.0f },
-	iterations{ 1.0f }, sceneID{ 13 }, juliaC{ 0.0f, 0.0f, 0.0f, 0.0f }, cursorEnabled{ true }, mWheelMovement{ 0.0 }
+	updateTime{ 0.0f }, gameOver{ false }, startupBegin{ std::chrono::steady_clock::now() }, vulkan{ std::make_unique<VulkanResources>(this) },
+	cursor{ vulkan.get(), Settings::CURSOR_SIZE }, random{}, gen{ random() }, camera{ glm::dvec3(2.0, 0.0, 0.0), glm::dvec3(0.0, 0.0, 0.0), 1.0f }, steps{ 100.0f }, fractalData{ 0.15f, 0.0f },
+	iterations{ 1.0f }, sceneID{ 13 }, estimator{ 0 }, juliaC{ 0.0f, 0.0f, 0.0f, 0.0f }, sceneBounds{ 0.0f }, fractalPath{ FractalPaths::eFragment }, deepZoom{ false }, distanceCache{ false }, temporal{ false }, adaptivePrecision{ false }, iterationLod{ false }, fractalShading{ FractalShading::eFull }, renderOnDemand{ Settings::RENDER_ON_DEMAND }, framesInFlight{ Settings::FRAMES_IN_FLIGHT }, presentMode{ Settings::PRESENT_MODE }, measureLatency{ Settings::LATENCY_REPORT }, cursorEnabled{ true }, mWheelMovement{ 0.0 }, benchmarkReturnScene{ 0 }, benchmarkSequence{ 0 }, captureRequests{ 0 }, frameSequence{ 0 }, sceneVersion{ 0 }, publishedSpriteVersion{ 0 }, inputTime{ -1.0 }, latencySum{ 0.0f }, latencyWorst{ 0.0f }, latencyCount{ 0 }, updateAllocations{ "processInput and publishFrame", 120 }, spriteHighWater{ 0 }
 {
+	double vulkanTime = millisecondsSince(startupBegin);
 
 	//get window pointer from vulkan
 	window = vulkan->window;
 
+	auto start = std::chrono::steady_clock::now();
+	soundEngine = std::make_unique<SoundEngine>();
+	double audioDeviceTime = millisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
 	disableCursor();
+	scenes.load("configs/scenes.txt");
 	loadScene(sceneID);
+	bindings.load("configs/bindings.txt");
+	double configTime = millisecondsSince(start);
 
-	//reset input buffers
-	std::fill_n(keysPressed, 512, false);
-	std::fill_n(keysHeld, 512, false);
-
+	//only queues the files, they are decoded on the sound engine's loader thread while the first frames draw
+	start = std::chrono::steady_clock::now();
 	soundEngine->loadSound("sounds/thud.wav");
 	soundEngine->loadSound("sounds/clang.wav");
 	soundEngine->loadMusic("sounds/violin.wav");
 	soundEngine->setMusicVolume(0, 2.0f);
+	double soundTime = millisecondsSince(start);
+
+	startupReport = "window and vulkan " + std::to_string(vulkanTime) + " ms, audio device " + std::to_string(audioDeviceTime) +
+		" ms, configs " + std::to_string(configTime) + " ms, sound load requests " + std::to_string(soundTime) + " ms";
 }
 
 Game::~Game()
@@ -35,272 +60,270 @@ void Game::start()
 	soundEngine->startMusic(0);
 	soundEngine->loopMusic(0, true);
 
+	//the render thread draws the newest snapshot, waiting on the gpu there doesn't hold up input and updates here
+	publishFrame();
+	vulkan->startRendering();
+
+	bool idled = false;
 	while (!glfwWindowShouldClose(window))
 	{
 		calculateDeltaTime();
 		fpsTimePassed += deltaTime;
-		updateTime += deltaTime;
+		//time spent idle isn't owed to the simulation, whatever woke it up is applied as one tick
+		updateTime = idled ? 0.01f : updateTime + deltaTime;
 		if (fpsTimePassed > 1.0f)
 		{
-			std::cout << fpsFramesRendered << "\t" << 1.0f / fpsFramesRendered << "\n";
-			fpsTimePassed -= 1.0f;
-			fpsFramesRendered = 0;
-		}
-
-		int timesUpdated = 0;
-		while (updateTime >= 0.01f)	//update 100 times a second
-		{
-			//update key arrays
-			processInput();
-
-			if (keysHeld[GLFW_KEY_W])
-			{
-				camera.position += 0.01f * camera.direction * camera.speed;
-			}
-			if (keysHeld[GLFW_KEY_S])
-			{
-				camera.position -= 0.01f * camera.direction * camera.speed;
-			}
-			if (keysHeld[GLFW_KEY_A])
-			{
-				camera.position -= 0.01f * camera.right * camera.speed;
-			}
-			if (keysHeld[GLFW_KEY_D])
-			{
-				camera.position += 0.01f * camera.right * camera.speed;
-			}
-			if (keysHeld[GLFW_KEY_LEFT_SHIFT])
-			{
-				camera.position += 0.01f * camera.up * camera.speed;
-			}
-			if (keysHeld[GLFW_KEY_LEFT_CONTROL])
-			{
-				camera.position -= 0.01f * camera.up * camera.speed;
-			}
-			if (keysHeld[GLFW_KEY_UP])
+			//render on demand can go a whole second without drawing, idle seconds have no frame time to print
+			if (fpsFramesRendered > 0)
 			{
-				steps += 0.01f * 20.0f;
+				LOG_INFO("{}\t{}", fpsFramesRendered, 1.0f / fpsFramesRendered);
 			}
-			if (keysHeld[GLFW_KEY_DOWN])
+			//unsorted every sprite was a draw and a descriptor set bind
+			if (spriteStats != printedSpriteStats)
 			{
-				steps -= 0.01f * 20.0f;
+				LOG_INFO("{} sprites in {} draws and {} binds, saved {} draws and {} binds", spriteStats.sprites, spriteStats.draws, spriteStats.binds, spriteStats.sprites - spriteStats.draws, (int)spriteStats.sprites - (int)spriteStats.binds);
+				printedSpriteStats = spriteStats;
 			}
-			if (keysHeld[GLFW_KEY_Q])
+			if (measureLatency && latencyCount > 0)
 			{
-				fractalData[0] -= 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_E])
-			{
-				fractalData[0] += 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_Z])
-			{
-				fractalData[1] -= 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_X])
-			{
-				fractalData[1] += 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_F])
-			{
-				camera.speed *= (1.0f - 0.01f);
-			}
-			if (keysHeld[GLFW_KEY_G])
-			{
-				camera.speed *= (1.0f + 0.01f);
-			}
-			if (keysHeld[GLFW_KEY_1])
-			{
-				juliaC.x -= 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_2])
-			{
-				juliaC.x += 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_3])
-			{
-				juliaC.y -= 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_4])
-			{
-				juliaC.y += 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_5])
-			{
-				juliaC.z -= 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_6])
-			{
-				juliaC.z += 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_7])
-			{
-				juliaC.w -= 0.01f * 0.1f;
-			}
-			if (keysHeld[GLFW_KEY_8])
-			{
-				juliaC.w += 0.01f * 0.1f;
-			}
-			if (keysPressed[GLFW_KEY_LEFT])
-			{
-				loadScene(sceneID - 1);
-			}
-			if (keysPressed[GLFW_KEY_RIGHT])
-			{
-				loadScene(sceneID + 1);
-			}
-			if (keysPressed[GLFW_KEY_R])
-			{
-				iterations -= 1.0f;
-				if (iterations < 1.0f)
-				{
-					iterations = 1.0f;
-				}
-			}
-			if (keysPressed[GLFW_KEY_T])
-			{
-				iterations += 1.0f;
-			}
-			if (keysPressed[GLFW_KEY_SPACE])
-			{
-				if (cursorEnabled)
-				{
-					disableCursor();
-				}
-				else
-				{
-					enableCursor();
-				}
-			}
-			if (mWheelMovement != 0.0)
-			{
-				camera.focalLength += (float)mWheelMovement * 0.05f;
-				if (camera.focalLength <= 0.0f)
-				{
-					camera.focalLength = 0.0f;
-				}
-				mWheelMovement = 0.0;
+				LOG_INFO("input to present: {} ms average, {} ms worst over {} inputs, {} frames in flight, {}", latencySum / latencyCount, latencyWorst, latencyCount, framesInFlight, vk::to_string(presentMode));
 			}
+			latencySum = 0.0f;
+			latencyWorst = 0.0f;
+			latencyCount = 0;
+			fpsTimePassed -= 1.0f;
+			fpsFramesRendered = 0;
 
-			float newYaw = float(cursor.xPos - cursor.prevXPos) * cursor.sensitivity + camera.yaw;
-			float newPitch = -float(cursor.yPos - cursor.prevYPos) * cursor.sensitivity + camera.pitch;
-			if (newPitch > 89.5f)
+			//the benchmark walks the scenes by index, they can't change under it
+			if (!benchmark.isRunning() && scenes.reloadIfChanged())
 			{
-				newPitch = 89.5f;
-			}
-			else if (newPitch < -89.5f)
-			{
-				newPitch = -89.5f;
-			}
-			if (newYaw > 180.0f)
-			{
-				newYaw -= 360.0f;
-			}
-			else if (newYaw < -180.0f)
-			{
-				newYaw += 360.0f;
-			}
-			if (!cursorEnabled)
-			{
-				camera.orient(newPitch, newYaw);
+				//keep the camera where it is, only the parameters being tuned change
+				sceneID = std::min(sceneID, scenes.size() - 1);
+				applySceneParameters();
 			}
+		}
 
-			updateTime -= 0.01f;
-			timesUpdated++;
+		//updates are due 100 times a second, ticks that piled up are applied as one longer step
+		int ticksDue = (int)(updateTime / 0.01f);
+		if (ticksDue > 0)
+		{
 			//cap updates if rendering needs to catch up
-			if (timesUpdated > 4)
+			if (ticksDue > 5)
 			{
+				ticksDue = 5;
 				updateTime = 0.0f;
-				break;
 			}
+			else
+			{
+				updateTime -= ticksDue * 0.01f;
+			}
+
+			updateAllocations.begin();
+			processInput();
+			updateAllocations.end();
+			applyAxes(ticksDue * 0.01f);
+			applyActions();
+			updateView();
 		}
 
-		drawFrame();
+		updateAllocations.begin();
+		bool changed = publishFrame();
+		updateAllocations.end();
+		updateAllocations.endFrame();
+
+		collectFrameResults();
 
-		fpsFramesRendered++;
+		//sleep until the next update is due instead of spinning, input wakes it early
+		//on demand with nothing moving there is nothing to update until input arrives, only the once a second report is due
+		idled = renderOnDemand && !changed && updateTime < 0.01f;
+		if (idled)
+		{
+			glfwWaitEventsTimeout(std::max(1.0 - fpsTimePassed, 0.01));
+		}
+		else if (updateTime < 0.01f)
+		{
+			glfwWaitEventsTimeout(0.01 - updateTime);
+		}
 	}
 
+	vulkan->stopRendering();
+
 	soundEngine->stopMusic(0);
 
 	vulkan->waitUntilDeviceIsIdle();
 }
 
-void Game::processInput()
+void Game::applyAxes(float elapsed)
 {
-	glfwPollEvents();
+	float forward = bindings.axis(Axes::eMoveForward, input) * elapsed;
+	float right = bindings.axis(Axes::eMoveRight, input) * elapsed;
+	float up = bindings.axis(Axes::eMoveUp, input) * elapsed;
+	camera.position += forward * camera.direction * camera.speed;
+	camera.position += right * camera.right * camera.speed;
+	camera.position += up * camera.up * camera.speed;
+
+	steps += bindings.axis(Axes::eSteps, input) * elapsed * 20.0f;
+	fractalData[0] += bindings.axis(Axes::eFractalData0, input) * elapsed * 0.1f;
+	fractalData[1] += bindings.axis(Axes::eFractalData1, input) * elapsed * 0.1f;
+	//about 1% a tick like before, but compounds correctly over a longer step
+	camera.speed *= std::exp(bindings.axis(Axes::eCameraSpeed, input) * elapsed);
+
+	juliaC += glm::vec4(bindings.axis(Axes::eJuliaX, input), bindings.axis(Axes::eJuliaY, input),
+		bindings.axis(Axes::eJuliaZ, input), bindings.axis(Axes::eJuliaW, input)) * elapsed * 0.1f;
+}
 
-	if (windowResized)
+void Game::applyActions()
+{
+	if (bindings.triggered(Actions::ePreviousScene, input))
 	{
-		vulkan->recreateSwapChain();
-		windowResized = false;
+		loadScene(sceneID - 1);
 	}
-
-	updateKeyStates();
-
-	//update cursor position
-	cursor.update(window);
-
-	//close the program
-	if (keysPressed[GLFW_KEY_ESCAPE])
+	if (bindings.triggered(Actions::eNextScene, input))
 	{
-		glfwSetWindowShouldClose(window, GLFW_TRUE);
+		loadScene(sceneID + 1);
 	}
-}
-
-void Game::updateKeyStates()
-{
-	//iterate relevant keys
-	for (auto key : mappedKeys)
+	if (bindings.triggered(Actions::eFewerIterations, input))
 	{
-		//key is being pressed
-		if (glfwGetKey(window, key) == GLFW_PRESS && !keysHeld[key])
-		{
-			//second frame of key being pressed
-			if (keysPressed[key])
-			{
-				keysHeld[key] = true;
-				keysPressed[key] = false;
-			}
-			//first frame of key being pressed
-			else
-			{
-				keysPressed[key] = true;
-			}
-		}
-		//key is released
-		else if (glfwGetKey(window, key) == GLFW_RELEASE)
+		iterations -= 1.0f;
+		if (iterations < 1.0f)
 		{
-			keysHeld[key] = false;
-			keysPressed[key] = false;
+			iterations = 1.0f;
 		}
 	}
-	//iterate mouse keys
-	for (auto key : mappedMouseKeys)
+	if (bindings.triggered(Actions::eMoreIterations, input))
+	{
+		iterations += 1.0f;
+	}
+	if (bindings.triggered(Actions::eNextFractalPath, input))
+	{
+		fractalPath = static_cast<FractalPaths>((toUType(fractalPath) + 1) % (toUType(FractalPaths::eComputeWavefront) + 1));
+		LOG_INFO("fractal path: {}", fractalPathNames[toUType(fractalPath)]);
+	}
+	if (bindings.triggered(Actions::eToggleDeepZoom, input))
+	{
+		deepZoom = !deepZoom;
+		LOG_INFO("deep zoom: {}", (deepZoom ? "on" : "off"));
+	}
+	if (bindings.triggered(Actions::eToggleDistanceCache, input))
+	{
+		distanceCache = !distanceCache;
+		LOG_INFO("distance cache: {}", (distanceCache ? "on" : "off"));
+	}
+	if (bindings.triggered(Actions::eToggleTemporal, input))
+	{
+		temporal = !temporal;
+		LOG_INFO("temporal reprojection: {}", (temporal ? "on" : "off"));
+	}
+	if (bindings.triggered(Actions::eToggleAdaptivePrecision, input))
+	{
+		adaptivePrecision = !adaptivePrecision;
+		LOG_INFO("adaptive precision: {}", (adaptivePrecision ? "on" : "off"));
+	}
+	if (bindings.triggered(Actions::eToggleIterationLod, input))
+	{
+		iterationLod = !iterationLod;
+		LOG_INFO("iteration lod: {}", (iterationLod ? "on" : "off"));
+	}
+	if (bindings.triggered(Actions::eNextFractalShading, input))
+	{
+		fractalShading = static_cast<FractalShading>((toUType(fractalShading) + 1) % (toUType(FractalShading::eQuarter) + 1));
+		LOG_INFO("fractal shading: {}{}", fractalShadingNames[toUType(fractalShading)], ((fractalPath == FractalPaths::eFragment) ? ", only used by the compute paths" : ""));
+	}
+	if (bindings.triggered(Actions::eBenchmark, input) && !benchmark.isRunning())
+	{
+		startBenchmark();
+	}
+	if (bindings.triggered(Actions::eToggleRenderOnDemand, input))
+	{
+		renderOnDemand = !renderOnDemand;
+		LOG_INFO("render on demand: {}", (renderOnDemand ? "on" : "off"));
+	}
+	if (bindings.triggered(Actions::eNextFramesInFlight, input))
+	{
+		framesInFlight = framesInFlight % Settings::MAX_FRAMES_IN_FLIGHT + 1;
+		LOG_INFO("frames in flight: {}", framesInFlight);
+	}
+	if (bindings.triggered(Actions::eNextPresentMode, input))
+	{
+		size_t mode = std::find(std::begin(presentModes), std::end(presentModes), presentMode) - std::begin(presentModes);
+		presentMode = presentModes[(mode + 1) % std::size(presentModes)];
+		LOG_INFO("present mode: {}", vk::to_string(presentMode));
+	}
+	if (bindings.triggered(Actions::eToggleLatencyReport, input))
+	{
+		measureLatency = !measureLatency;
+		LOG_INFO("latency report: {}", (measureLatency ? "on" : "off"));
+	}
+	if (bindings.triggered(Actions::eToggleCursor, input))
 	{
-		//key is being pressed
-		if (glfwGetMouseButton(window, key) == GLFW_PRESS && !keysHeld[key])
+		if (cursorEnabled)
 		{
-			//second frame of key being pressed
-			if (keysPressed[key])
-			{
-				keysHeld[key] = true;
-				keysPressed[key] = false;
-			}
-			//first frame of key being pressed
-			else
-			{
-				keysPressed[key] = true;
-			}
+			disableCursor();
 		}
-		//key is released
-		else if (glfwGetMouseButton(window, key) == GLFW_RELEASE)
+		else
 		{
-			keysHeld[key] = false;
-			keysPressed[key] = false;
+			enableCursor();
 		}
 	}
 }
 
+void Game::updateView()
+{
+	if (mWheelMovement != 0.0)
+	{
+		camera.focalLength += (float)mWheelMovement * 0.05f;
+		if (camera.focalLength <= 0.0f)
+		{
+			camera.focalLength = 0.0f;
+		}
+		mWheelMovement = 0.0;
+	}
+
+	float newYaw = float(cursor.xPos - cursor.prevXPos) * cursor.sensitivity + camera.yaw;
+	float newPitch = -float(cursor.yPos - cursor.prevYPos) * cursor.sensitivity + camera.pitch;
+	if (newPitch > 89.5f)
+	{
+		newPitch = 89.5f;
+	}
+	else if (newPitch < -89.5f)
+	{
+		newPitch = -89.5f;
+	}
+	if (newYaw > 180.0f)
+	{
+		newYaw -= 360.0f;
+	}
+	else if (newYaw < -180.0f)
+	{
+		newYaw += 360.0f;
+	}
+	if (!cursorEnabled)
+	{
+		camera.orient(newPitch, newYaw);
+	}
+}
+
+void Game::processInput()
+{
+	//resizes are picked up by the render thread, keys and mouse buttons are queued by the callbacks
+	glfwPollEvents();
+
+	input.update();
+	if (input.firstEventTime() >= 0.0)
+	{
+		inputTime = input.firstEventTime();
+	}
+
+	//update cursor position
+	cursor.update(window);
+
+	//close the program
+	if (bindings.triggered(Actions::eQuit, input))
+	{
+		glfwSetWindowShouldClose(window, GLFW_TRUE);
+	}
+}
+
 void Game::calculateDeltaTime()
 {
 	double currentTime = glfwGetTime();
@@ -313,9 +336,110 @@ void Game::update()
 
 }
 
-void Game::drawFrame()
+bool Game::publishFrame()
 {
-	vulkan->drawFrame();
+	FrameSnapshot& frame = vulkan->frames.writeBuffer();
+	frame.sequence = frameSequence + 1;
+	frame.camera = camera;
+	frame.steps = steps;
+	frame.fractalData = fractalData;
+	frame.iterations = iterations;
+	frame.estimator = estimator;
+	frame.sceneBounds = sceneBounds;
+	frame.juliaC = juliaC;
+	frame.fractalPath = fractalPath;
+	frame.deepZoom = deepZoom;
+	frame.distanceCache = distanceCache;
+	frame.temporal = temporal;
+	frame.adaptivePrecision = adaptivePrecision;
+	frame.iterationLod = iterationLod;
+	frame.fractalShading = fractalShading;
+	frame.captureRequests = captureRequests;
+	frame.renderOnDemand = renderOnDemand;
+	frame.framesInFlight = framesInFlight;
+	frame.presentMode = presentMode;
+	frame.measureLatency = measureLatency;
+	frame.inputTime = inputTime;
+
+	//benchmark frames are timed, they have to be drawn even if they look the same
+	bool changed = publishedScene.sequence == 0 || benchmark.isRunning() || !frame.drawsSameAs(publishedScene) ||
+		vulkan->spritesToRender->version() != publishedSpriteVersion || frame.measureLatency != publishedScene.measureLatency;
+	//the render thread keeps drawing the last snapshot, an identical one isn't worth copying the sprites for
+	if (!changed)
+	{
+		return false;
+	}
+	frameSequence++;
+	sceneVersion++;
+	publishedSpriteVersion = vulkan->spritesToRender->version();
+	//sprites are compared by version, only copy the rest and keep their capacity in the snapshot
+	SpriteArrays sprites = std::move(frame.sprites);
+	publishedScene = frame;
+	frame.sprites = std::move(sprites);
+	frame.sceneVersion = sceneVersion;
+
+	//every snapshot's sprite arrays grow to the most sprites there were
+	if (vulkan->spritesToRender->size() > spriteHighWater)
+	{
+		spriteHighWater = vulkan->spritesToRender->size();
+		updateAllocations.rewarm();
+	}
+	vulkan->spritesToRender->copyTo(frame);
+	vulkan->frames.publish();
+	vulkan->wakeRenderThread();
+	return true;
+}
+
+void Game::collectFrameResults()
+{
+	vulkan->takeFrameResults(frameResults);
+	fpsFramesRendered += (int)frameResults.size();
+	if (!startupReport.empty() && !frameResults.empty())
+	{
+		LOG_INFO("first frame drawn {} ms after startup: {}", millisecondsSince(startupBegin), startupReport);
+		startupReport.clear();
+	}
+	if (!frameResults.empty())
+	{
+		spriteStats = frameResults.back().spriteStats;
+	}
+	for (auto const& result : frameResults)
+	{
+		if (result.inputLatency >= 0.0f)
+		{
+			latencySum += result.inputLatency;
+			latencyWorst = std::max(latencyWorst, result.inputLatency);
+			latencyCount++;
+		}
+	}
+
+	if (!benchmark.isRunning())
+	{
+		return;
+	}
+
+	std::vector<uint8_t> pixels;
+	vk::Extent2D extent;
+	if (vulkan->takeFractalCapture(pixels, extent))
+	{
+		benchmark.addImage(std::move(pixels), extent.width, extent.height);
+	}
+
+	for (auto const& result : frameResults)
+	{
+		//drawn before the current case was applied
+		if (result.sequence < benchmarkSequence)
+		{
+			continue;
+		}
+		//fall back to the whole frame time if the gpu can't write timestamps
+		benchmark.addSample((result.fractalTime >= 0.0f) ? result.fractalTime : result.frameTime);
+		if (!benchmark.isRunning())
+		{
+			loadScene(benchmarkReturnScene);
+			break;
+		}
+	}
 }
 
 void Game::resetGame()
@@ -339,114 +463,63 @@ void Game::disableCursor()
 	cursorEnabled = false;
 }
 
-//make new sprites after pool was cleared
-void Game::recreateSprites()
+void Game::startBenchmark()
+{
+	benchmarkReturnScene = sceneID;
+
+	std::vector<BenchmarkVariant> variants;
+	for (int i = 0; i <= toUType(FractalPaths::eComputeWavefront); i++)
+	{
+		variants.push_back({ fractalPathNames[i], [this, i]() { resetFractalModes(); fractalPath = static_cast<FractalPaths>(i); } });
+	}
+	//the bake lands in the warmup frames after every scene switch
+	variants.push_back({ "fragment cached", [this]() { resetFractalModes(); distanceCache = true; } });
+	variants.push_back({ "fragment adaptive", [this]() { resetFractalModes(); adaptivePrecision = true; } });
+	variants.push_back({ "fragment adaptive lod", [this]() { resetFractalModes(); adaptivePrecision = true; iterationLod = true; } });
+	//full rate compute is the reference image for the reduced shading rates
+	int computeVariant = toUType(FractalPaths::eCompute);
+	variants.push_back({ "compute checkerboard", [this]() { resetFractalModes(); fractalPath = FractalPaths::eCompute;
+		fractalShading = FractalShading::eCheckerboard; }, computeVariant });
+	variants.push_back({ "compute quarter", [this]() { resetFractalModes(); fractalPath = FractalPaths::eCompute;
+		fractalShading = FractalShading::eQuarter; }, computeVariant });
+
+	//the case and the capture only apply from the next snapshot on, frames still in flight mustn't count towards them
+	benchmark.start(std::move(variants), scenes.size(), [this](int id) { loadScene(id); benchmarkSequence = frameSequence + 1; },
+		[this]() { captureRequests++; benchmarkSequence = frameSequence + 1; });
+}
+
+void Game::resetFractalModes()
 {
-	cursor.recreateSprite();
+	fractalPath = FractalPaths::eFragment;
+	deepZoom = false;
+	distanceCache = false;
+	temporal = false;
+	adaptivePrecision = false;
+	iterationLod = false;
+	fractalShading = FractalShading::eFull;
 }
 
 void Game::loadScene(int id)
 {
-	sceneID = id;
-	switch (sceneID)
-	{
-	case 0:
-		fractalData = { 0.15f, 0.0f };
-		steps = 100.0f;
-		break;
-	case 1:
-		fractalData = { 8.0f, 0.0f };
-		iterations = 4.0f;
-		break;
-	case 2:
-		fractalData = { 4.0f, 0.0f };
-		iterations = 20.0f;
-		juliaC = { -0.2f, 0.4f, 0.1f, -0.423f };
-		steps = 50.0f;
-		break;
-	case 3:
-		fractalData = { 0.0f, 0.0f };
-		iterations = 80.0f;
-		juliaC = { 0.0f, 0.0f, 0.0f, 0.0f };
-		break;
-	case 4:
-		fractalData = { 0.0f, 0.0f };
-		iterations = 40.0f;
-		juliaC = { 0.0f, 0.0f, -1.08f, 0.0f };
-		break;
-	case 5:
-		fractalData = { 2.0f, 0.5f };
-		iterations = 25.0f;
-		juliaC = { 0.0f, 0.0f, 0.0f, 1.0f };
-		steps = 50.0f;
-		camera.position = glm::vec3(10.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	case 6:
-		fractalData = { 2.5f, 0.0f };
-		iterations = 25.0f;
-		juliaC = { 2.0f, -2.0f, -2.0f, 1.0f };
-		steps = 50.0f;
-		camera.position = glm::vec3(15.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	case 7:
-		fractalData = { 3.596f, 2.03f };
-		iterations = 30.0f;
-		juliaC = { -1.0f, -0.5f, -0.2f, 1.5f };
-		steps = 50.0f;
-		camera.position = glm::vec3(5.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	case 8:
-		fractalData = { -1.0f, 2.0f };
-		iterations = 16.0f;
-		juliaC = { -2.0f, -2.0f, 0.0f, 3.0f };
-		steps = 50.0f;
-		camera.position = glm::vec3(5.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	case 9:
-		fractalData = { 0.34f, 1.5708f };
-		iterations = 16.0f;
-		juliaC = { -5.27f, -0.34f, 0.0f, 3.28f };
-		steps = 50.0f;
-		camera.position = glm::vec3(5.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	case 10:
-		fractalData = { 0.0f, 0.44f };
-		iterations = 50.0f;
-		juliaC = { -2.0f, -4.8f, 0.0f, 1.3f };
-		steps = 50.0f;
-		camera.position = glm::vec3(12.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	case 11:
-		fractalData = { 0.0f, 0.0f };
-		iterations = 11.0f;
-		juliaC = { -1.0f, -1.0f, -1.0f, 2.0f };
-		steps = 50.0f;
-		camera.position = glm::vec3(5.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	case 12:
-		fractalData = { -2.95318f, 0.15f };
-		iterations = 30.0f;
-		juliaC = { -6.61f, -4.0f, -2.42f, 1.57f };
-		steps = 50.0f;
-		camera.position = glm::vec3(15.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	case 13:
-		fractalData = { -1.570796f, 1.815f };
-		iterations = 20.0f;
-		juliaC = { -7.1f, 0.396f, -6.29f, 1.89f };
-		steps = 50.0f;
-		camera.position = glm::vec3(5.0f, 0.0f, 0.0f);
-		camera.point(glm::vec3(0.0f, 0.0f, 0.0f));
-		break;
-	default:
-		break;
-	}
-}
\ No newline at end of file
+	//wraps around both ways
+	sceneID = ((id % scenes.size()) + scenes.size()) % scenes.size();
+	applySceneParameters();
+	SceneDescription const& scene = scenes[sceneID];
+	if (scene.placesCamera)
+	{
+		camera.position = scene.cameraPosition;
+		camera.point(scene.cameraTarget);
+	}
+	LOG_INFO("scene {}: {}", sceneID, scene.name);
+}
+
+void Game::applySceneParameters()
+{
+	SceneDescription const& scene = scenes[sceneID];
+	estimator = scene.estimator;
+	fractalData = { scene.fractalData[0], scene.fractalData[1] };
+	juliaC = scene.juliaC;
+	steps = scene.steps;
+	iterations = scene.iterations;
+	sceneBounds = scene.bounds;
+}
@@ -4,6 +4,9 @@
 #include "GraphicsComponent.h"
 #include "Cursor.h"
 #include "Camera.h"
+#include "Benchmark.h"
+#include "Bindings.h"
+#include "Scenes.h"
 #include <random>
 #include <array>
 #include <cassert>
@@ -25,43 +28,88 @@ public:
 
 	//starts the game loop
 	void start();
-	//remakes all object sprites
-	void recreateSprites();
 
 	//set GLFW window for getting cursor data
 	void setWindow(GLFWwindow* win) noexcept { window = win; }
 
-	bool getWindowWasResized() const noexcept { return windowResized; }
-	void setWindowWasResized() noexcept { windowResized = true; }
-
 	Camera camera;
 	float steps;
 	std::vector<float> fractalData;
 	float iterations;
-	int sceneID;
+	int sceneID;	//index into scenes
+	int estimator;
 	glm::vec4 juliaC;
+	glm::vec4 sceneBounds;
+	FractalPaths fractalPath;
+	bool deepZoom;	//march relative to the camera and perturb the fold DEs around its reference orbit
+	bool distanceCache;	//march a baked copy of the distance field, the exact DE only close to the surface
+	bool temporal;	//start rays at last frame's hit distances reprojected into this view
+	bool adaptivePrecision;	//hit threshold grows with the pixel footprint instead of staying at rayPrecision
+	bool iterationLod;	//fewer DE iterations for distant points
+	FractalShading fractalShading;	//compute paths only
+	bool renderOnDemand;	//draw only when the picture changes instead of continuously
+	uint32_t framesInFlight;	//fewer for lower latency, more for throughput
+	vk::PresentModeKHR presentMode;
+	bool measureLatency;	//print input to present latency every second
 
 	bool cursorEnabled;
 	double mWheelMovement;
+	InputState input;	//fed by the key and mouse button callbacks
+	ActionMap bindings;
 private:
 	void calculateDeltaTime();
-	//check window resizing, update cursor/keys
+	//update cursor/keys
 	void processInput();
-	void drawFrame();
+	//move everything bound to a held axis by elapsed seconds worth of change
+	void applyAxes(float elapsed);
+	//run the actions whose keys were pressed since the last update
+	void applyActions();
+	//zoom with the mouse wheel and look around with the cursor
+	void updateView();
+	//copy the state the renderer needs into the next snapshot and hand it to the render thread, false if nothing changed and it wasn't published
+	bool publishFrame();
+	//feed the frames the render thread finished to the fps counter and the benchmark
+	void collectFrameResults();
 	void update();
 	void resetGame();
 	void enableCursor();
 	void disableCursor();
 
+	//set everything the scene describes and place the camera if it says where
 	void loadScene(int id);
+	//set the current scene's parameters without moving the camera
+	void applySceneParameters();
+	//measure every fractal path on every scene
+	void startBenchmark();
+	//turn off everything a benchmark variant can turn on
+	void resetFractalModes();
 
-	bool keysPressed[512];
-	bool keysHeld[512];
-	//update key pressed/held arrays
-	void updateKeyStates();
 
 	bool gameOver;
 
+	SceneCatalog scenes;
+
+	Benchmark benchmark;
+	int benchmarkReturnScene;	//scene to go back to after benchmarking
+	uint64_t benchmarkSequence;	//first snapshot of the current benchmark case, older frames aren't counted
+	uint32_t captureRequests;
+
+	uint64_t frameSequence;		//snapshots published so far
+	uint64_t sceneVersion;		//changes of the published picture
+	FrameSnapshot publishedScene;	//last published values without the sprites, to tell if the picture changed
+	uint32_t publishedSpriteVersion;
+	std::vector<FrameResult> frameResults;
+	double inputTime;			//first event of the newest update that had input
+	float latencySum;			//input latencies of the frames drawn since the last report
+	float latencyWorst;
+	int latencyCount;
+	AllocationCheck updateAllocations;	//debug builds assert once input and publishing stopped allocating
+	uint32_t spriteHighWater;			//most sprites published so far, more make the snapshots' arrays grow
+	SpriteDrawStats spriteStats;		//of the last frame drawn
+	SpriteDrawStats printedSpriteStats;
+
+	std::chrono::steady_clock::time_point startupBegin;	//construction start, first frames are timed from it
+	std::string startupReport;		//where the startup time went, printed with the first drawn frame
 	std::unique_ptr<SoundEngine> soundEngine;
 
 	std::unique_ptr<VulkanResources> vulkan;
@@ -72,7 +120,6 @@ private:
 	std::mt19937 gen;
 
 	GLFWwindow* window;
-	bool windowResized;
 
 	double lastFrameTime;
 	float deltaTime;
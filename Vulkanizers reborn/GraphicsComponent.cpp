@@ -1,7 +1,7 @@
 #include "GraphicsComponent.h"
 
 GraphicsComponent::GraphicsComponent()
-	:spriteIndex{ -1 }, vulkan{ nullptr }
+	:sprite{}, vulkan{ nullptr }
 {
 
 }
@@ -9,21 +9,21 @@ GraphicsComponent::GraphicsComponent()
 GraphicsComponent::GraphicsComponent(VulkanResources* vulkan, float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation, vk::Sampler sampler, Texture* texture)
 	: vulkan{ vulkan }
 {
-	spriteIndex = vulkan->addSprite(posX, posY, layer, sizeX, sizeY, rotation,
-		sampler, texture, this);
+	sprite = vulkan->addSprite(posX, posY, layer, sizeX, sizeY, rotation,
+		sampler, texture);
 }
 
 GraphicsComponent::~GraphicsComponent()
 {
 	//check if sprite exists and remove it
-	if (spriteIndex != -1)
+	if (!sprite.isEmpty())
 	{
-		vulkan->removeSprite(spriteIndex);
+		vulkan->removeSprite(sprite);
 	}
 }
 
 GraphicsComponent::GraphicsComponent(GraphicsComponent&& other) noexcept
-	:spriteIndex{ -1 }, vulkan{ nullptr } //make other destructible after swap
+	:sprite{}, vulkan{ nullptr } //make other destructible after swap
 {
 	swap(*this, other);
 }
@@ -37,7 +37,7 @@ GraphicsComponent& GraphicsComponent::operator=(GraphicsComponent other) noexcep
 
 void GraphicsComponent::moveSprite(float posX, float posY)
 {
-	assert(spriteIndex != -1 && "moved nonexistent sprite");
+	assert(!sprite.isEmpty() && "moved nonexistent sprite");
 
-	vulkan->spritesToRender->getSprites()[spriteIndex].movePosition(posX, posY);
+	vulkan->spritesToRender->moveSprite(sprite, posX, posY);
 }
\ No newline at end of file
@@ -21,31 +21,13 @@ public:
 	{
 		using std::swap;
 
-		//two empty graphics components swapped
-		if (!first.vulkan && !second.vulkan) return;
-
-		auto& sprites = (first.vulkan) ? first.vulkan->spritesToRender->getSprites() : second.vulkan->spritesToRender->getSprites();
-		//first sprite is empty, update second's object location
-		if (first.spriteIndex == -1 && second.spriteIndex != -1)
-		{
-			sprites[second.spriteIndex].object = &first;
-		}
-		//second sprite is empty, update first's object location
-		else if (first.spriteIndex != -1 && second.spriteIndex == -1)
-		{
-			sprites[first.spriteIndex].object = &second;
-		}
-		//both sprites exist, swap object locations
-		else if (first.spriteIndex != -1 && second.spriteIndex != -1)
-		{
-			swap(sprites[first.spriteIndex].object, sprites[second.spriteIndex].object);
-		}
-		swap(first.spriteIndex, second.spriteIndex);
+		//the pool doesn't know the owners, swapping the handles is enough
+		swap(first.sprite, second.sprite);
 		swap(first.vulkan, second.vulkan);
 	}
 
 	void moveSprite(float newX, float newY);
 
-	short spriteIndex;
+	SpriteHandle sprite;	//empty if the component has no sprite
 	VulkanResources* vulkan;
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "Input.h"
+#include "Log.h"
+
+InputState::InputState()
+	:droppedEvents{ 0 }, eventTime{ -1.0 }
+{
+
+}
+
+void InputState::push(int code, bool pressed, double time) noexcept
+{
+	if (code < 0 || code >= codeCount)
+	{
+		return;
+	}
+	if (!events.push({ (int16_t)code, pressed, time }))
+	{
+		droppedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void InputState::update()
+{
+	pressed.reset();
+	released.reset();
+	eventTime = -1.0;
+
+	InputEvent event;
+	while (events.pop(event))
+	{
+		if (eventTime < 0.0)
+		{
+			eventTime = event.time;
+		}
+		if (event.pressed)
+		{
+			held.set(event.code);
+			pressed.set(event.code);
+		}
+		else
+		{
+			held.reset(event.code);
+			released.set(event.code);
+		}
+	}
+
+	uint32_t dropped = droppedEvents.exchange(0, std::memory_order_relaxed);
+	if (dropped != 0)
+	{
+		LOG_WARNING("dropped {} input events, the queue was full", dropped);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "SpscQueue.h"
+#include <bitset>
+#include <atomic>
+#include <cstdint>
+
+//a key or mouse button changing state, mouse buttons use codes 0 to 7 below the first key code
+struct InputEvent
+{
+	int16_t code;
+	bool pressed;
+	double time;	//glfw time the callback ran
+};
+
+//key and mouse button state of one update tick, built from the events glfw reported since the last tick
+class InputState
+{
+public:
+	static constexpr int codeCount = 512;
+
+	InputState();
+
+	InputState(InputState const&) = delete;
+	InputState& operator=(InputState const&) = delete;
+
+	//called from the glfw callbacks, codes out of range are ignored and events past the queue's capacity dropped
+	void push(int code, bool pressed, double time) noexcept;
+	//apply the queued events, pressed and released only last for the tick they happened in
+	void update();
+
+	bool isHeld(int code) const { return held[code]; }
+	bool wasPressed(int code) const { return pressed[code]; }
+	bool wasReleased(int code) const { return released[code]; }
+	//glfw time of the first event applied by the last update, negative if there was none
+	double firstEventTime() const noexcept { return eventTime; }
+
+private:
+	SpscQueue<InputEvent, 256> events;
+	std::atomic<uint32_t> droppedEvents;
+	std::bitset<codeCount> held;
+	std::bitset<codeCount> pressed;		//went down this tick, stays set if it also went up again
+	std::bitset<codeCount> released;	//went up this tick
+	double eventTime;
+};
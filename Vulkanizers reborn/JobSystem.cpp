@@ -0,0 +1,91 @@
+#include "JobSystem.h"
+#include "Log.h"
+
+JobSystem::JobSystem(unsigned int workerCount)
+	:nextJob{ 0 }, unfinishedJobs{ 0 }, stopping{ false }
+{
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		workers.emplace_back(&JobSystem::work, this);
+	}
+	LOG_DEBUG("started {} job threads", workerCount);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+	LOG_DEBUG("stopped {} job threads", workers.size());
+}
+
+void JobSystem::submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+		unfinishedJobs++;
+	}
+	jobAvailable.notify_one();
+}
+
+void JobSystem::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	jobsDone.wait(lock, [this]() { return unfinishedJobs == 0; });
+
+	if (error)
+	{
+		std::exception_ptr thrown = error;
+		error = nullptr;
+		std::rethrow_exception(thrown);
+	}
+}
+
+void JobSystem::work()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		jobAvailable.wait(lock, [this]() { return stopping || nextJob != jobs.size(); });
+		if (nextJob == jobs.size())
+		{
+			return;
+		}
+
+		std::function<void()> job = std::move(jobs[nextJob++]);
+		if (nextJob == jobs.size())
+		{
+			jobs.clear();
+			nextJob = 0;
+		}
+
+		lock.unlock();
+		std::exception_ptr thrown;
+		try
+		{
+			job();
+		}
+		catch (...)
+		{
+			thrown = std::current_exception();
+		}
+		lock.lock();
+
+		if (thrown && !error)
+		{
+			error = thrown;
+		}
+		unfinishedJobs--;
+		if (unfinishedJobs == 0)
+		{
+			jobsDone.notify_all();
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+//fixed set of worker threads that run submitted jobs in any order
+class JobSystem
+{
+public:
+	explicit JobSystem(unsigned int workerCount);
+	//finishes the queued jobs first
+	~JobSystem();
+
+	JobSystem(JobSystem const&) = delete;
+	JobSystem& operator=(JobSystem const&) = delete;
+
+	//jobs capturing more than two pointers can make std::function allocate, pass bigger state through a pointer
+	void submit(std::function<void()> job);
+	//block until every submitted job is done, rethrows the first exception one of them threw
+	void wait();
+
+	unsigned int size() const noexcept { return (unsigned int)workers.size(); }
+
+private:
+	void work();
+
+	std::vector<std::thread> workers;
+	std::vector<std::function<void()>> jobs;	//cleared once every job was taken so it keeps its capacity
+	size_t nextJob;							//first job no worker took yet
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobsDone;
+	unsigned int unfinishedJobs;	//queued and running
+	bool stopping;
+	std::exception_ptr error;
+};
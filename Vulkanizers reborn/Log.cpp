@@ -0,0 +1,430 @@
+#include "Log.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <chrono>
+#include <memory>
+#include <cstdio>
+#include <algorithm>
+
+std::atomic<LogLevel> Logger::runtimeLevel{ LogLevel::eInfo };
+
+static char const binaryLogMagic[8] = { 'V', 'K', 'Z', 'L', 'O', 'G', '1', '\0' };
+
+//entries of a binary log after the magic, a format is written once before the first record using it
+enum class BinaryLogEntry : uint8_t
+{
+	eFormat, eRecord, eDropped
+};
+
+static char const* const levelNames[] = { "trace", "debug", "info", "warning", "error" };
+
+namespace
+{
+	//bounded multi-producer ring, a cell's sequence says whether it's free for the producer at a position or filled for the writer
+	struct RingCell
+	{
+		std::atomic<size_t> sequence;
+		LogRecord record;
+	};
+
+	struct LoggerState
+	{
+		std::unique_ptr<RingCell[]> cells;
+		std::atomic<size_t> enqueuePosition{ 0 };
+		std::atomic<size_t> dequeuePosition{ 0 };	//only the writer moves it, flush waits on it
+		std::atomic<uint32_t> droppedRecords{ 0 };
+		std::atomic<uint8_t> nextThread{ 0 };
+		std::chrono::steady_clock::time_point clockStart = std::chrono::steady_clock::now();
+
+		std::thread writer;
+		std::mutex mutex;						//guards stopping and flushRequested, cells are never locked
+		std::condition_variable wake;			//the writer also polls, producers never notify it
+		std::condition_variable written;
+		bool stopping = false;
+		bool flushRequested = false;
+
+		//writer thread only
+		std::ofstream binary;
+		std::unordered_map<char const*, uint32_t> formatIds;
+		std::string line;
+
+		LoggerState()
+			:cells{ std::make_unique<RingCell[]>(Logger::ringSize) }
+		{
+			for (size_t i = 0; i < Logger::ringSize; i++)
+			{
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	//constructed on first use, records can be logged before main starts the writer
+	LoggerState& state()
+	{
+		static LoggerState loggerState;
+		return loggerState;
+	}
+
+	uint8_t threadNumber() noexcept
+	{
+		thread_local uint8_t number = state().nextThread.fetch_add(1, std::memory_order_relaxed);
+		return number;
+	}
+
+	void appendArgument(std::string& out, LogRecord const& record, uint8_t index)
+	{
+		char buffer[32];
+		uint64_t bits = record.arguments[index];
+		switch (record.types[index])
+		{
+		case LogArgumentType::eInt:
+			snprintf(buffer, sizeof(buffer), "%lld", (long long)(int64_t)bits);
+			out += buffer;
+			break;
+		case LogArgumentType::eUnsigned:
+			snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)bits);
+			out += buffer;
+			break;
+		case LogArgumentType::eFloat:
+		{
+			//same as std::cout's default
+			double number;
+			memcpy(&number, &bits, sizeof(double));
+			snprintf(buffer, sizeof(buffer), "%g", number);
+			out += buffer;
+			break;
+		}
+		case LogArgumentType::eBool:
+			out += bits ? "true" : "false";
+			break;
+		case LogArgumentType::eText:
+			out += &record.text[bits];
+			break;
+		}
+	}
+
+	//every {} takes the next argument, arguments left over are appended
+	void formatRecord(std::string& out, char const* format, LogRecord const& record)
+	{
+		uint8_t next = 0;
+		for (char const* c = format; *c; c++)
+		{
+			if (c[0] == '{' && c[1] == '}' && next < record.argumentCount)
+			{
+				appendArgument(out, record, next++);
+				c++;
+				continue;
+			}
+			out += *c;
+		}
+		for (; next < record.argumentCount; next++)
+		{
+			out += ' ';
+			appendArgument(out, record, next);
+		}
+	}
+
+	void writeConsole(LoggerState& logger, LogRecord const& record)
+	{
+		logger.line.clear();
+		if (record.level >= LogLevel::eWarning)
+		{
+			logger.line += levelNames[toUType(record.level)];
+			logger.line += ": ";
+		}
+		formatRecord(logger.line, record.format, record);
+		logger.line += '\n';
+		std::cout << logger.line;
+	}
+
+	template<typename T>
+	void writeBinary(std::ofstream& file, T const& value)
+	{
+		file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool readBinary(std::ifstream& file, T& value)
+	{
+		return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(T));
+	}
+
+	//host byte order, the log is meant to be formatted on the machine that wrote it
+	void writeBinaryRecord(LoggerState& logger, LogRecord const& record)
+	{
+		auto found = logger.formatIds.find(record.format);
+		uint32_t formatId;
+		if (found == logger.formatIds.end())
+		{
+			formatId = (uint32_t)logger.formatIds.size();
+			logger.formatIds.emplace(record.format, formatId);
+			uint32_t length = (uint32_t)strlen(record.format);
+			writeBinary(logger.binary, BinaryLogEntry::eFormat);
+			writeBinary(logger.binary, formatId);
+			writeBinary(logger.binary, length);
+			logger.binary.write(record.format, length);
+		}
+		else
+		{
+			formatId = found->second;
+		}
+
+		writeBinary(logger.binary, BinaryLogEntry::eRecord);
+		writeBinary(logger.binary, record.time);
+		writeBinary(logger.binary, formatId);
+		writeBinary(logger.binary, record.level);
+		writeBinary(logger.binary, record.thread);
+		writeBinary(logger.binary, record.argumentCount);
+		writeBinary(logger.binary, record.textUsed);
+		logger.binary.write(reinterpret_cast<char const*>(record.types.data()), record.argumentCount);
+		logger.binary.write(reinterpret_cast<char const*>(record.arguments.data()), record.argumentCount * sizeof(uint64_t));
+		logger.binary.write(record.text.data(), record.textUsed);
+	}
+
+	//write every record that's complete, returns false if there was none
+	bool drain(LoggerState& logger)
+	{
+		bool wrote = false;
+		size_t position = logger.dequeuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			RingCell& cell = logger.cells[position & (Logger::ringSize - 1)];
+			if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+			{
+				break;
+			}
+			writeConsole(logger, cell.record);
+			if (logger.binary.is_open())
+			{
+				writeBinaryRecord(logger, cell.record);
+			}
+			//free for the producer one lap ahead
+			cell.sequence.store(position + Logger::ringSize, std::memory_order_release);
+			position++;
+			logger.dequeuePosition.store(position, std::memory_order_release);
+			wrote = true;
+		}
+
+		uint32_t dropped = logger.droppedRecords.exchange(0, std::memory_order_relaxed);
+		if (dropped != 0)
+		{
+			std::cout << "dropped " << dropped << " log records, the ring was full\n";
+			if (logger.binary.is_open())
+			{
+				writeBinary(logger.binary, BinaryLogEntry::eDropped);
+				writeBinary(logger.binary, dropped);
+			}
+			wrote = true;
+		}
+		if (wrote)
+		{
+			std::cout.flush();
+			logger.binary.flush();
+		}
+		return wrote;
+	}
+
+	void writeRecords()
+	{
+		LoggerState& logger = state();
+		std::unique_lock<std::mutex> lock(logger.mutex);
+		while (true)
+		{
+			bool stopping = logger.stopping;
+			logger.flushRequested = false;
+			lock.unlock();
+			drain(logger);
+			lock.lock();
+			logger.written.notify_all();
+			if (stopping)
+			{
+				return;
+			}
+			//a few ms late on the console is fine, it saves producers from ever signalling
+			logger.wake.wait_for(lock, std::chrono::milliseconds(5), [&logger]() { return logger.stopping || logger.flushRequested; });
+		}
+	}
+}
+
+void Logger::start(LogLevel level, std::string const& binaryPath)
+{
+	LoggerState& logger = state();
+	runtimeLevel.store(level, std::memory_order_relaxed);
+	if (!binaryPath.empty())
+	{
+		logger.binary.open(binaryPath, std::ios::binary | std::ios::trunc);
+		if (!logger.binary)
+		{
+			throw std::runtime_error("couldn't open log file " + binaryPath);
+		}
+		logger.binary.write(binaryLogMagic, sizeof(binaryLogMagic));
+	}
+	logger.stopping = false;
+	logger.writer = std::thread(writeRecords);
+}
+
+void Logger::stop()
+{
+	LoggerState& logger = state();
+	if (!logger.writer.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(logger.mutex);
+		logger.stopping = true;
+	}
+	logger.wake.notify_all();
+	logger.writer.join();
+	logger.binary.close();
+}
+
+void Logger::flush()
+{
+	LoggerState& logger = state();
+	size_t target = logger.enqueuePosition.load(std::memory_order_acquire);
+	std::unique_lock<std::mutex> lock(logger.mutex);
+	if (!logger.writer.joinable() || logger.stopping)
+	{
+		return;
+	}
+	logger.flushRequested = true;
+	logger.wake.notify_all();
+	//a record claimed before the call but still being filled is waited for too
+	logger.written.wait(lock, [&logger, target]() { return logger.dequeuePosition.load(std::memory_order_acquire) >= target; });
+}
+
+void Logger::addText(LogRecord& record, uint8_t index, std::string_view text) noexcept
+{
+	size_t room = LogRecord::textSize - record.textUsed;
+	if (room == 0)
+	{
+		//the last argument's terminator stands in for this one
+		record.types[index] = LogArgumentType::eText;
+		record.arguments[index] = LogRecord::textSize - 1;
+		return;
+	}
+	size_t length = std::min(text.size(), room - 1);
+	memcpy(&record.text[record.textUsed], text.data(), length);
+	record.text[record.textUsed + length] = '\0';
+	record.types[index] = LogArgumentType::eText;
+	record.arguments[index] = record.textUsed;
+	record.textUsed = (uint16_t)(record.textUsed + length + 1);
+}
+
+void Logger::push(LogRecord& record) noexcept
+{
+	LoggerState& logger = state();
+	record.time = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - logger.clockStart).count();
+	record.thread = threadNumber();
+
+	size_t position = logger.enqueuePosition.load(std::memory_order_relaxed);
+	RingCell* cell;
+	while (true)
+	{
+		cell = &logger.cells[position & (ringSize - 1)];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		if (sequence == position)
+		{
+			if (logger.enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (sequence < position)
+		{
+			//the writer hasn't freed this cell yet, the ring is full
+			logger.droppedRecords.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			position = logger.enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+	cell->record = record;
+	cell->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool Logger::formatBinaryLog(std::string const& path, std::ostream& out)
+{
+	std::ifstream file(path, std::ios::binary);
+	char magic[sizeof(binaryLogMagic)];
+	if (!file.read(magic, sizeof(magic)) || memcmp(magic, binaryLogMagic, sizeof(magic)) != 0)
+	{
+		return false;
+	}
+
+	std::vector<std::string> formats;
+	std::string line;
+	BinaryLogEntry entry;
+	while (readBinary(file, entry))
+	{
+		if (entry == BinaryLogEntry::eFormat)
+		{
+			uint32_t id, length;
+			if (!readBinary(file, id) || !readBinary(file, length))
+			{
+				return false;
+			}
+			std::string format(length, '\0');
+			if (!file.read(format.data(), length))
+			{
+				return false;
+			}
+			formats.resize(std::max<size_t>(formats.size(), id + 1));
+			formats[id] = std::move(format);
+		}
+		else if (entry == BinaryLogEntry::eRecord)
+		{
+			LogRecord record = {};
+			uint32_t formatId;
+			if (!readBinary(file, record.time) || !readBinary(file, formatId) || !readBinary(file, record.level) || !readBinary(file, record.thread) ||
+				!readBinary(file, record.argumentCount) || !readBinary(file, record.textUsed) ||
+				record.argumentCount > LogRecord::maxArguments || record.textUsed > LogRecord::textSize || formatId >= formats.size() || toUType(record.level) > toUType(LogLevel::eError))
+			{
+				return false;
+			}
+			file.read(reinterpret_cast<char*>(record.types.data()), record.argumentCount);
+			file.read(reinterpret_cast<char*>(record.arguments.data()), record.argumentCount * sizeof(uint64_t));
+			file.read(record.text.data(), record.textUsed);
+			if (!file)
+			{
+				return false;
+			}
+			record.text[LogRecord::textSize - 1] = '\0';
+			for (uint8_t i = 0; i < record.argumentCount; i++)
+			{
+				//a damaged text offset would read past the record
+				if (record.types[i] == LogArgumentType::eText && record.arguments[i] >= LogRecord::textSize)
+				{
+					return false;
+				}
+			}
+
+			char prefix[64];
+			snprintf(prefix, sizeof(prefix), "%12.6f %-7s thread %u: ", record.time / 1e9, levelNames[toUType(record.level)], (unsigned int)record.thread);
+			line = prefix;
+			formatRecord(line, formats[formatId].c_str(), record);
+			out << line << "\n";
+		}
+		else if (entry == BinaryLogEntry::eDropped)
+		{
+			uint32_t dropped;
+			if (!readBinary(file, dropped))
+			{
+				return false;
+			}
+			out << "dropped " << dropped << " log records, the ring was full\n";
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
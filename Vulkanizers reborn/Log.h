@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Constants.h"
+#include <array>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+
+//sites below this aren't compiled in, LOG_LEVEL filters the rest while running
+#ifdef NDEBUG
+constexpr LogLevel compiledLogLevel = LogLevel::eInfo;
+#else
+constexpr LogLevel compiledLogLevel = LogLevel::eTrace;
+#endif
+
+//format is a string literal with {} for each argument, it's only read when the record gets written
+//a site that's compiled in but filtered costs one load and one branch
+#define LOG_AT(level, ...) do { if constexpr (level >= compiledLogLevel) { if (Logger::enabled(level)) { Logger::write(level, __VA_ARGS__); } } } while (false)
+#define LOG_TRACE(...) LOG_AT(LogLevel::eTrace, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LogLevel::eDebug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::eInfo, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LogLevel::eWarning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::eError, __VA_ARGS__)
+
+enum class LogArgumentType : uint8_t
+{
+	eInt, eUnsigned, eFloat, eBool, eText
+};
+
+//one log call as the ring holds it, nothing is formatted until the writer thread or --format-log gets to it
+struct LogRecord
+{
+	static constexpr size_t maxArguments = 8;
+	static constexpr size_t textSize = 256;
+
+	uint64_t time;								//ns since the logger's clock started
+	char const* format;							//string literal, outlives the record
+	LogLevel level;
+	uint8_t thread;								//numbered in the order threads first logged
+	uint8_t argumentCount;
+	uint16_t textUsed;
+	std::array<LogArgumentType, maxArguments> types;
+	std::array<uint64_t, maxArguments> arguments;	//integers, double bits or the offset of a text argument
+	std::array<char, textSize> text;			//copies of text arguments, each 0 terminated, cut off where it's full
+};
+
+//log records of every thread go through one lock-free ring that a writer thread drains to the console and LOG_FILE
+//logging never waits, a record that doesn't fit in the ring is dropped and counted
+class Logger
+{
+public:
+	static constexpr size_t ringSize = 4096;
+
+	//start the writer thread, records logged before wait in the ring until then
+	static void start(LogLevel level, std::string const& binaryPath);
+	//write what's left in the ring and join the writer thread
+	static void stop();
+	//block until everything logged before the call was written, does nothing while the writer isn't running
+	static void flush();
+	//print a binary log written through LOG_FILE to out, false if it can't be read
+	static bool formatBinaryLog(std::string const& path, std::ostream& out);
+
+	static bool enabled(LogLevel level) noexcept { return level >= runtimeLevel.load(std::memory_order_relaxed); }
+
+	template<typename... Args>
+	static void write(LogLevel level, char const* format, Args const&... args)
+	{
+		static_assert(sizeof...(Args) <= LogRecord::maxArguments, "too many log arguments");
+		LogRecord record;
+		record.level = level;
+		record.format = format;
+		record.argumentCount = 0;
+		record.textUsed = 0;
+		(addArgument(record, args), ...);
+		push(record);
+	}
+
+private:
+	template<typename T>
+	static void addArgument(LogRecord& record, T const& value)
+	{
+		uint8_t index = record.argumentCount++;
+		if constexpr (std::is_same_v<T, bool>)
+		{
+			record.types[index] = LogArgumentType::eBool;
+			record.arguments[index] = value ? 1 : 0;
+		}
+		else if constexpr (std::is_enum_v<T>)
+		{
+			record.types[index] = LogArgumentType::eInt;
+			record.arguments[index] = (uint64_t)(int64_t)value;
+		}
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+		{
+			record.types[index] = LogArgumentType::eInt;
+			record.arguments[index] = (uint64_t)(int64_t)value;
+		}
+		else if constexpr (std::is_integral_v<T>)
+		{
+			record.types[index] = LogArgumentType::eUnsigned;
+			record.arguments[index] = (uint64_t)value;
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			double number = (double)value;
+			record.types[index] = LogArgumentType::eFloat;
+			memcpy(&record.arguments[index], &number, sizeof(double));
+		}
+		else if constexpr (std::is_convertible_v<T const&, char const*>)
+		{
+			//also vulkan.hpp's fixed size name arrays, which convert to a pointer and a string_view alike
+			addText(record, index, std::string_view(static_cast<char const*>(value)));
+		}
+		else if constexpr (std::is_convertible_v<T const&, std::string_view>)
+		{
+			addText(record, index, std::string_view(value));
+		}
+		else
+		{
+			static_assert(std::is_convertible_v<T const&, std::string>, "log arguments are numbers, bools, enums or text");
+			addText(record, index, std::string(value));
+		}
+	}
+	static void addText(LogRecord& record, uint8_t index, std::string_view text) noexcept;
+	static void push(LogRecord& record) noexcept;
+
+	static std::atomic<LogLevel> runtimeLevel;
+};
@@ -0,0 +1,250 @@
+#include "ReferenceOrbit.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+//same as the w.ab = vec2(c * w.a + s * w.b, c * w.b - s * w.a) rotations in the shader
+static void rotate(double c, double s, double& a, double& b)
+{
+	double newA = c * a + s * b;
+	b = c * b - s * a;
+	a = newA;
+}
+
+ReferenceOrbit::ReferenceOrbit()
+	:values((maxIterations + 2) * stride, 0.0f), cursor{ 0 }, length{ 0 }, fractalData0{ 0.0 }, fractalData1{ 0.0 }, juliaC{ 0.0 }
+{
+
+}
+
+void ReferenceOrbit::compute(int estimator, glm::dvec3 const& point, std::vector<float> const& fractalData, float iterations, glm::vec4 const& juliaC)
+{
+	fractalData0 = fractalData[0];
+	fractalData1 = fractalData[1];
+	this->juliaC = juliaC;
+	int iterationCount = std::min((int)iterations, maxIterations);
+	length = 0;
+
+	switch (estimator)
+	{
+	case 0:
+		computeSpheres(point);
+		break;
+	case 5:
+		//mandelbox adds the point, which the shader adds to delta itself
+		iterate(glm::dvec4(point, 1.0), iterationCount, [&](glm::dvec4& w)
+			{
+				boxFold(1.0, w);
+				w *= this->juliaC.w;
+				ballFold(fractalData1 * fractalData1, w);
+				w = glm::dvec4(fractalData0 * glm::dvec3(w) + point, w.w * std::abs(fractalData0) + 1.0);
+			});
+		break;
+	case 6:
+		iterate(glm::dvec4(point, 1.0), iterationCount, [&](glm::dvec4& w)
+			{
+				boxFold(1.0, w);
+				w = glm::dvec4(glm::dvec3(w) * this->juliaC.w, w.w * std::abs(this->juliaC.w));
+				ballFold(fractalData1 * fractalData1, w);
+				w = glm::dvec4(fractalData0 * glm::dvec3(w) + glm::dvec3(this->juliaC), w.w * std::abs(fractalData0));
+			});
+		break;
+	case 7:
+	{
+		double firstSin = std::sin(fractalData0), firstCos = std::cos(fractalData0);
+		double secondSin = std::sin(fractalData1), secondCos = std::cos(fractalData1);
+		iterate(glm::dvec4(point, 1.0), iterationCount, [&](glm::dvec4& w)
+			{
+				absFold(w);
+				scale(w);
+				rotate(firstCos, firstSin, w.y, w.z);
+				rotate(secondCos, secondSin, w.z, w.x);
+			});
+		break;
+	}
+	case 8:
+		iterate(glm::dvec4(point, 1.0) / 100.0, iterationCount, [&](glm::dvec4& w)
+			{
+				absFold(w);
+				mengerFold(w);
+				scale(w);
+				planeFold(fractalData0, w);
+			});
+		break;
+	case 9:
+	{
+		double firstSin = std::sin(fractalData1), firstCos = std::cos(fractalData1);
+		iterate(glm::dvec4(point, 1.0), iterationCount, [&](glm::dvec4& w)
+			{
+				boxFold(fractalData0, w);
+				mengerFold(w);
+				scale(w);
+				rotate(firstCos, firstSin, w.y, w.z);
+			});
+		break;
+	}
+	case 10:
+	{
+		double firstSin = std::sin(fractalData1), firstCos = std::cos(fractalData1);
+		iterate(glm::dvec4(point, 1.0), iterationCount, [&](glm::dvec4& w)
+			{
+				rotate(firstCos, firstSin, w.z, w.x);
+				absFold(w);
+				mengerFold(w);
+				scale(w);
+				planeFold(fractalData0, w);
+			});
+		break;
+	}
+	case 11:
+		iterate(glm::dvec4(point, 1.0), iterationCount, [&](glm::dvec4& w)
+			{
+				sierpinskiFold(w);
+				scale(w);
+			});
+		break;
+	case 12:
+	{
+		double firstSin = std::sin(fractalData0), firstCos = std::cos(fractalData0);
+		double secondSin = std::sin(fractalData1), secondCos = std::cos(fractalData1);
+		iterate(glm::dvec4(point, 1.0), iterationCount, [&](glm::dvec4& w)
+			{
+				rotate(firstCos, firstSin, w.z, w.x);
+				sierpinskiFold(w);
+				rotate(secondCos, secondSin, w.y, w.z);
+				mengerFold(w);
+				scale(w);
+			});
+		break;
+	}
+	case 13:
+	{
+		double firstSin = std::sin(fractalData0), firstCos = std::cos(fractalData0);
+		double secondSin = std::sin(fractalData1), secondCos = std::cos(fractalData1);
+		iterate(glm::dvec4(point, 1.0), iterationCount, [&](glm::dvec4& w)
+			{
+				sierpinskiFold(w);
+				mengerFold(w);
+				rotate(firstCos, firstSin, w.z, w.x);
+				absFold(w);
+				rotate(secondCos, secondSin, w.x, w.y);
+				scale(w);
+			});
+		break;
+	}
+	default:
+		//no perturbed DE, the shader only marches relative to the camera
+		break;
+	}
+}
+
+void ReferenceOrbit::copyTo(void* memory) const
+{
+	int32_t header[4] = { length, 0, 0, 0 };
+	memcpy(memory, header, headerSize);
+	memcpy(static_cast<char*>(memory) + headerSize, values.data(), length * stride * sizeof(float));
+}
+
+template<typename Step>
+void ReferenceOrbit::iterate(glm::dvec4 w, int iterationCount, Step step)
+{
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		beginEntry(glm::dvec3(w));
+		step(w);
+
+		if (glm::dot(glm::dvec3(w), glm::dvec3(w)) > 100000.0) break;
+	}
+	beginEntry(glm::dvec3(w));
+}
+
+void ReferenceOrbit::beginEntry(glm::dvec3 const& point)
+{
+	cursor = length * stride;
+	length++;
+	push(point.x);
+	push(point.y);
+	push(point.z);
+}
+
+void ReferenceOrbit::absFold(glm::dvec4& w)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		push(w[i]);
+		w[i] = std::abs(w[i]);
+	}
+}
+
+void ReferenceOrbit::boxFold(double r, glm::dvec4& w)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		push(w[i] - r);
+		push(w[i] + r);
+		w[i] = std::clamp(w[i], -r, r) * 2.0 - w[i];
+	}
+}
+
+void ReferenceOrbit::ballFold(double r2, glm::dvec4& w)
+{
+	double m2 = glm::dot(glm::dvec3(w), glm::dvec3(w));
+	push(w.x);
+	push(w.y);
+	push(w.z);
+	push(m2 - r2);
+	push(m2 - 1.0);
+	w /= std::clamp(std::max(r2, m2), 0.0, 1.0);
+}
+
+void ReferenceOrbit::mengerFold(glm::dvec4& w)
+{
+	push(w.x - w.y);
+	if (w.x < w.y) std::swap(w.x, w.y);
+	push(w.x - w.z);
+	if (w.x < w.z) std::swap(w.x, w.z);
+	push(w.y - w.z);
+	if (w.y < w.z) std::swap(w.y, w.z);
+}
+
+void ReferenceOrbit::sierpinskiFold(glm::dvec4& w)
+{
+	push(w.x + w.y);
+	if (w.x + w.y < 0.0) { double x = w.x; w.x = -w.y; w.y = -x; }
+	push(w.x + w.z);
+	if (w.x + w.z < 0.0) { double x = w.x; w.x = -w.z; w.z = -x; }
+	push(w.y + w.z);
+	if (w.y + w.z < 0.0) { double y = w.y; w.y = -w.z; w.z = -y; }
+}
+
+void ReferenceOrbit::planeFold(double d, glm::dvec4& w)
+{
+	push(w.z + d);
+	w.z = -std::abs(w.z + d) - d;
+}
+
+void ReferenceOrbit::scale(glm::dvec4& w) const
+{
+	w = glm::dvec4(glm::dvec3(w) * juliaC.w + glm::dvec3(juliaC), w.w * std::abs(juliaC.w));
+}
+
+void ReferenceOrbit::computeSpheres(glm::dvec3 const& point)
+{
+	//a single entry: offset q from the nearest sphere center, signs of the abs fold, |q|^2 - r^2, distance to the cell walls
+	cursor = 0;
+	length = 1;
+	glm::dvec3 cell = point - 1.0 - 2.0 * glm::floor((point - 1.0) / 2.0);
+	glm::dvec3 q = glm::abs(cell - 1.0) - 1.0;
+	double wall = 2.0;
+	for (int i = 0; i < 3; i++)
+	{
+		push(q[i]);
+		wall = std::min({ wall, cell[i], 2.0 - cell[i], std::abs(cell[i] - 1.0) });
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		push(cell[i] >= 1.0 ? 1.0 : -1.0);
+	}
+	push(glm::dot(q, q) - fractalData0 * fractalData0);
+	push(wall);
+}
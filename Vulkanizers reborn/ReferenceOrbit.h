@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+//orbit of the camera position through the scene's fractal, computed in double for the deep zoom perturbation
+//in fractal_deepzoom.glsl; every iteration stores its point followed by the decision values of its
+//nonlinear ops, in the order the shader reads them
+class ReferenceOrbit
+{
+public:
+	ReferenceOrbit();
+
+	static constexpr size_t stride = 16;	//floats per iteration, matches ORBIT_STRIDE
+	static constexpr int maxIterations = 256;	//the shader leaves the perturbation once the orbit runs out
+	static constexpr size_t headerSize = 4 * sizeof(int32_t);	//orbitLength and padding
+	static constexpr size_t bufferSize = headerSize + (maxIterations + 2) * stride * sizeof(float);
+
+	//fractalData and juliaC are the values the shader gets, so both iterate the same map
+	void compute(int estimator, glm::dvec3 const& point, std::vector<float> const& fractalData, float iterations, glm::vec4 const& juliaC);
+	//no orbit, the shader evaluates everything relative to the camera without perturbation
+	void clear() noexcept { length = 0; }
+	//writes header and entries to mapped memory of at least bufferSize
+	void copyTo(void* memory) const;
+
+private:
+	//runs step until the point escapes, recording the point before every iteration and the final one
+	template<typename Step>
+	void iterate(glm::dvec4 w, int iterationCount, Step step);
+
+	void beginEntry(glm::dvec3 const& point);
+	void push(double value) { values[cursor++] = (float)value; }
+
+	void absFold(glm::dvec4& w);
+	void boxFold(double r, glm::dvec4& w);
+	void ballFold(double r2, glm::dvec4& w);
+	void mengerFold(glm::dvec4& w);
+	void sierpinskiFold(glm::dvec4& w);
+	//w.z = -abs(w.z + d) - d
+	void planeFold(double d, glm::dvec4& w);
+	//scale by juliaC.w and translate by juliaC.xyz
+	void scale(glm::dvec4& w) const;
+
+	void computeSpheres(glm::dvec3 const& point);
+
+	std::vector<float> values;
+	size_t cursor;
+	int32_t length;
+
+	//shader parameters of the current compute
+	double fractalData0;
+	double fractalData1;
+	glm::dvec4 juliaC;
+};
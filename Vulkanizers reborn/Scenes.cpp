@@ -0,0 +1,175 @@
+#include "Scenes.h"
+#include "Log.h"
+#include <fstream>
+#include <stdexcept>
+#include <charconv>
+#include <iterator>
+#include <algorithm>
+
+//named like the DE_ functions in fractal_common.glsl, in the order of sceneDistance's cases
+static char const* const estimatorNames[] = { "spheres", "mandelbulb", "juliaExact", "juliaSquare", "juliaCube", "mandelbox",
+	"juliabox", "butterweedHills", "menger", "mausoleum", "treePlanet", "sierpinskiTetrahedron", "snowStadium", "cum" };
+
+//splits a line into words without copying them
+class Words
+{
+public:
+	explicit Words(std::string_view line) : rest{ line } {}
+
+	//empty once the line is used up
+	std::string_view next()
+	{
+		size_t start = rest.find_first_not_of(" \t\r");
+		if (start == std::string_view::npos)
+		{
+			rest = {};
+			return {};
+		}
+		rest.remove_prefix(start);
+		size_t end = std::min(rest.find_first_of(" \t\r"), rest.size());
+		std::string_view word = rest.substr(0, end);
+		rest.remove_prefix(end);
+		return word;
+	}
+
+	//fills values with the next count numbers, false if there are fewer or one doesn't parse
+	template<typename T>
+	bool numbers(T* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			std::string_view word = next();
+			if (word.empty() || std::from_chars(word.data(), word.data() + word.size(), values[i]).ptr != word.data() + word.size())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	std::string_view rest;
+};
+
+void SceneCatalog::load(std::string const& filename)
+{
+	std::ifstream file{ filename, std::ios::binary | std::ios::ate };
+	if (!file.is_open())
+	{
+		throw std::runtime_error("failed to open scene file " + filename);
+	}
+	std::error_code error;
+	auto writeTime = std::filesystem::last_write_time(filename, error);
+
+	std::vector<char> newText((size_t)file.tellg());
+	file.seekg(0);
+	file.read(newText.data(), newText.size());
+
+	//names point into newText, moving it into text later keeps its buffer
+	std::vector<SceneDescription> newScenes;
+	std::string_view remaining(newText.data(), newText.size());
+	int lineNumber = 0;
+	while (!remaining.empty())
+	{
+		size_t lineEnd = std::min(remaining.find('\n'), remaining.size());
+		Words words{ remaining.substr(0, lineEnd) };
+		remaining.remove_prefix(std::min(lineEnd + 1, remaining.size()));
+		lineNumber++;
+
+		std::string_view kind = words.next();
+		if (kind.empty() || kind.substr(0, 2) == "//")
+		{
+			continue;
+		}
+		auto badLine = [&]() { return std::runtime_error("bad scene line " + std::to_string(lineNumber) + " in " + filename); };
+
+		if (kind == "SCENE")
+		{
+			newScenes.emplace_back();
+			newScenes.back().name = words.next();
+			if (newScenes.back().name.empty())
+			{
+				throw badLine();
+			}
+			continue;
+		}
+		if (newScenes.empty())
+		{
+			throw badLine();
+		}
+
+		SceneDescription& scene = newScenes.back();
+		bool valid = false;
+		if (kind == "DE")
+		{
+			std::string_view name = words.next();
+			auto found = std::find_if(std::begin(estimatorNames), std::end(estimatorNames), [name](char const* estimatorName) { return name == estimatorName; });
+			scene.estimator = (int)(found - std::begin(estimatorNames));
+			valid = found != std::end(estimatorNames);
+		}
+		else if (kind == "DATA")
+		{
+			valid = words.numbers(scene.fractalData, 2);
+		}
+		else if (kind == "JULIA")
+		{
+			valid = words.numbers(&scene.juliaC.x, 4);
+		}
+		else if (kind == "BUDGET")
+		{
+			float budget[2] = {};
+			valid = words.numbers(budget, 2) && budget[0] >= 1.0f && budget[1] >= 1.0f;
+			scene.steps = budget[0];
+			scene.iterations = budget[1];
+		}
+		else if (kind == "BOUNDS")
+		{
+			valid = words.numbers(&scene.bounds.x, 4) && scene.bounds.w >= 0.0f;
+		}
+		else if (kind == "CAMERA")
+		{
+			double camera[6] = {};
+			valid = words.numbers(camera, 6);
+			scene.cameraPosition = glm::dvec3(camera[0], camera[1], camera[2]);
+			scene.cameraTarget = glm::dvec3(camera[3], camera[4], camera[5]);
+			scene.placesCamera = true;
+		}
+		if (!valid || !words.next().empty())
+		{
+			throw badLine();
+		}
+	}
+	if (newScenes.empty())
+	{
+		throw std::runtime_error("no scenes in " + filename);
+	}
+
+	this->filename = filename;
+	text = std::move(newText);
+	scenes = std::move(newScenes);
+	loadedTime = writeTime;
+	LOG_INFO("loaded {} scenes from {}", scenes.size(), filename);
+}
+
+bool SceneCatalog::reloadIfChanged()
+{
+	std::error_code error;
+	auto writeTime = std::filesystem::last_write_time(filename, error);
+	//editors can briefly remove the file while saving it
+	if (error || writeTime == loadedTime)
+	{
+		return false;
+	}
+
+	try
+	{
+		load(filename);
+		return true;
+	}
+	catch (std::exception const& e)
+	{
+		LOG_WARNING("{}, keeping the old scenes", e.what());
+		loadedTime = writeTime;
+		return false;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+//one entry of the scene catalog, everything loadScene sets
+struct SceneDescription
+{
+	std::string_view name;					//points into the catalog's text
+	int estimator = 0;						//distance estimator the fractal shaders run, a case of sceneDistance
+	float fractalData[2] = {};
+	glm::vec4 juliaC = glm::vec4(0.0f);
+	float steps = 50.0f;					//default quality budget, march steps
+	float iterations = 1.0f;				//and DE iterations
+	glm::vec4 bounds = glm::vec4(0.0f);		//bounding sphere center and radius, rays start where they enter it, 0 radius for unbounded scenes
+	bool placesCamera = false;				//scenes without a CAMERA line leave the camera where it is
+	glm::dvec3 cameraPosition = glm::dvec3(0.0);
+	glm::dvec3 cameraTarget = glm::dvec3(0.0);
+};
+
+//scenes read from a text file, reloaded when the file changes so presets can be tuned without rebuilding
+class SceneCatalog
+{
+public:
+	//SCENE name starts an entry, DE, DATA, JULIA, BUDGET, BOUNDS and CAMERA lines fill it in, // starts a comment line
+	//throws if the file can't be read, has a bad line or no scenes
+	void load(std::string const& filename);
+	//load the file again if it was written since the last load, a bad file keeps the old scenes
+	//true if the scenes changed
+	bool reloadIfChanged();
+
+	int size() const noexcept { return (int)scenes.size(); }
+	SceneDescription const& operator[](int id) const { return scenes[id]; }
+
+private:
+	std::string filename;
+	std::vector<char> text;					//the whole file, parsed in place
+	std::vector<SceneDescription> scenes;
+	std::filesystem::file_time_type loadedTime;
+};
@@ -0,0 +1,192 @@
+#include "ShaderReloader.h"
+#include "Constants.h"
+#include "Log.h"
+#include <chrono>
+#include <iterator>
+
+//sources in the watched directory and the spv file the program loads for each
+static std::pair<char const*, std::string const*> const fractalShaders[] = {
+	{ "fractal_shader.frag", &Settings::FRACTAL_FRAG_SHADER_PATH },
+	{ "fractal_composite.frag", &Settings::FRACTAL_COMPOSITE_FRAG_SHADER_PATH },
+	{ "fractal_shader.comp", &Settings::FRACTAL_COMP_SHADER_PATH },
+	{ "fractal_bake.comp", &Settings::FRACTAL_BAKE_SHADER_PATH },
+	{ "fractal_reproject.comp", &Settings::FRACTAL_REPROJECT_SHADER_PATH }
+};
+
+//glslc of the installed vulkan sdk, the one on the path otherwise
+static std::string findGlslc()
+{
+	std::string sdk;
+	readEnvironmentVariable("VULKAN_SDK", sdk);
+	return sdk.empty() ? "glslc" : sdk + "/Bin/glslc";
+}
+
+ShaderReloader::ShaderReloader(std::string directory, std::function<FractalPipelines()> build)
+	:directory{ std::move(directory) }, build{ std::move(build) }, glslc{ findGlslc() }, stopped{ false }, ready{ false }, readyPipelines{}
+{
+	//the shaders on disk are the ones just loaded
+	scan();
+	watcher = std::thread(&ShaderReloader::watch, this);
+	LOG_DEBUG("watching {} for shader edits", this->directory);
+}
+
+ShaderReloader::~ShaderReloader()
+{
+	stop();
+}
+
+void ShaderReloader::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopped = true;
+	}
+	stopping.notify_all();
+	if (watcher.joinable())
+	{
+		watcher.join();
+		LOG_DEBUG("stopped watching shaders");
+	}
+}
+
+bool ShaderReloader::takeReady(FractalPipelines& pipelines)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!ready)
+	{
+		return false;
+	}
+	pipelines = readyPipelines;
+	ready = false;
+	return true;
+}
+
+void ShaderReloader::watch()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		stopping.wait_for(lock, std::chrono::milliseconds(250), [this]() { return stopped; });
+		if (stopped)
+		{
+			return;
+		}
+		if (ready)
+		{
+			continue;
+		}
+
+		//compiling and building take long, the render thread can take older pipelines meanwhile
+		lock.unlock();
+		bool built = false;
+		FractalPipelines pipelines = {};
+		if (scan() && compile())
+		{
+			try
+			{
+				pipelines = build();
+				built = true;
+			}
+			catch (std::exception const& e)
+			{
+				LOG_WARNING("{}, keeping the old pipelines", e.what());
+			}
+		}
+		lock.lock();
+
+		if (built)
+		{
+			readyPipelines = pipelines;
+			ready = true;
+		}
+	}
+}
+
+bool ShaderReloader::scan()
+{
+	bool changed = false;
+	std::error_code error;
+	for (auto const& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		std::filesystem::path const& path = entry.path();
+		if (path.extension() != ".frag" && path.extension() != ".comp" && path.extension() != ".vert" && path.extension() != ".glsl")
+		{
+			continue;
+		}
+		//editors can briefly remove the file while saving it
+		auto writeTime = std::filesystem::last_write_time(path, error);
+		if (error)
+		{
+			continue;
+		}
+		auto found = writeTimes.find(path);
+		if (found == writeTimes.end() || found->second != writeTime)
+		{
+			writeTimes[path] = writeTime;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+//spv files a reload left next to the loaded ones
+static void removeShaderFiles(char const* suffix)
+{
+	std::error_code error;
+	for (auto const& shader : fractalShaders)
+	{
+		std::filesystem::remove(*shader.second + suffix, error);
+	}
+}
+
+bool ShaderReloader::compile()
+{
+	//all but the composite shader include fractal_common.glsl, rebuilding all of them is simpler than following includes
+	for (auto const& shader : fractalShaders)
+	{
+		std::string command = "\"" + glslc + "\" \"" + directory + "/" + shader.first + "\" -o \"" + *shader.second + ".new\"";
+#ifdef _WIN32
+		//cmd strips the outer quotes of a command that starts with one
+		command = "\"" + command + "\"";
+#endif
+		if (std::system(command.c_str()) != 0)
+		{
+			LOG_WARNING("couldn't compile {}, keeping the old pipelines", shader.first);
+			removeShaderFiles(".new");
+			return false;
+		}
+	}
+
+	//the loaded files move aside until every new one is in place, a failed rename puts all of them back
+	//so a swap chain rebuild never loads a mix of old and new shaders
+	removeShaderFiles(".old");
+	std::error_code error;
+	size_t replaced = 0;
+	for (; replaced < std::size(fractalShaders); replaced++)
+	{
+		std::string const& path = *fractalShaders[replaced].second;
+		std::filesystem::rename(path, path + ".old", error);
+		if (!error)
+		{
+			std::filesystem::rename(path + ".new", path, error);
+		}
+		if (error)
+		{
+			break;
+		}
+	}
+	if (error)
+	{
+		LOG_WARNING("couldn't replace {}: {}, keeping the old pipelines", *fractalShaders[replaced].second, error.message());
+		std::error_code ignored;
+		for (size_t i = 0; i <= replaced; i++)
+		{
+			std::filesystem::rename(*fractalShaders[i].second + ".old", *fractalShaders[i].second, ignored);
+		}
+		removeShaderFiles(".new");
+		return false;
+	}
+	removeShaderFiles(".old");
+	LOG_INFO("compiled {} fractal shaders", std::size(fractalShaders));
+	return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <string>
+#include <map>
+#include <functional>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//pipelines built from the fractal shaders, the ones worth editing while the program runs
+struct FractalPipelines
+{
+	vk::Pipeline fragment;
+	vk::Pipeline composite;
+	vk::Pipeline compute;
+	vk::Pipeline bake;
+	vk::Pipeline reproject;
+	uint64_t swapChainGeneration;	//render pass and extent the graphics pipelines were built for
+};
+
+//watches the shader sources for edits, compiles them with glslc and builds new pipelines on its own thread
+//the render thread picks them up between frames, the old pipelines keep drawing until then
+class ShaderReloader
+{
+public:
+	//build runs on the watcher thread after the spv files were rewritten, it throws if a pipeline can't be made
+	ShaderReloader(std::string directory, std::function<FractalPipelines()> build);
+	//stops watching, pipelines that were never taken have to be taken before
+	~ShaderReloader();
+
+	ShaderReloader(ShaderReloader const&) = delete;
+	ShaderReloader& operator=(ShaderReloader const&) = delete;
+
+	//joins the watcher thread, nothing gets built after this returns
+	void stop();
+	//move pipelines built since the last call into pipelines, false if there are none
+	bool takeReady(FractalPipelines& pipelines);
+
+private:
+	void watch();
+	//true if a source was written since the last scan
+	bool scan();
+	//compile every fractal shader next to its spv and replace the spv files once all of them compiled
+	bool compile();
+
+	std::string directory;
+	std::function<FractalPipelines()> build;
+	std::string glslc;
+	std::map<std::filesystem::path, std::filesystem::file_time_type> writeTimes;
+
+	std::thread watcher;
+	std::mutex mutex;
+	std::condition_variable stopping;
+	bool stopped;
+	bool ready;						//pipelines were built and not taken yet, nothing is built until they are
+	FractalPipelines readyPipelines;
+};
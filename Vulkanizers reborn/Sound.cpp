@@ -1,82 +1,452 @@
 #include "Sound.h"
-#include <thread>
+#include "Log.h"
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
 
-SoundEngine::SoundEngine()
+//frames decoded per read of a music file
+static constexpr size_t decodeFrames = 4096;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
 {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
+//sample at frame of data as stereo, mono files play on both sides
+static void sampleFrame(SampleData const& data, size_t frame, float& left, float& right)
+{
+	int16_t const* samples = data.samples.data() + frame * data.channelCount;
+	left = samples[0];
+	right = data.channelCount > 1 ? samples[1] : samples[0];
+}
+
+SoundEngine::SoundEngine()
+	:mix(mixFrames * 2), output(mixFrames * 2), decoded(decodeFrames * 2), created{ std::chrono::steady_clock::now() }
+{
+	initialize(2, mixRate);
+	streamer = std::thread(&SoundEngine::stream, this);
+	loader = std::thread(&SoundEngine::load, this);
+	play();
 }
 
 SoundEngine::~SoundEngine()
 {
-	for (auto sound : sounds)
-	{
-		sound->stop();
-		delete sound;
-	}
-	for (auto buffer : soundBuffers)
+	//onGetData has to be done before this object is gone, the base destructor would stop it too late
+	sf::SoundStream::stop();
 	{
-		delete buffer;
+		std::lock_guard<std::mutex> lock(threadMutex);
+		stopping = true;
 	}
-	for (auto melody : music)
-	{
-		melody->stop();
-	}
-	std::this_thread::sleep_for(std::chrono::milliseconds(100));
-	for (auto melody : music)
+	streamWake.notify_all();
+	loadWake.notify_all();
+	streamer.join();
+	loader.join();
+
+	uint32_t dropped = droppedSounds.load(std::memory_order_relaxed);
+	if (dropped)
 	{
-		delete melody;
+		LOG_WARNING("dropped {} sounds that found no voice or weren't loaded in time", dropped);
 	}
 }
 
-void SoundEngine::loadSound(std::string const& filename)
+int SoundEngine::loadSound(std::string const& filename)
 {
-	sf::SoundBuffer* buffer = new sf::SoundBuffer();
-	if (!(buffer->loadFromFile(filename)))
+	auto sound = std::make_unique<SoundSlot>();
+	sound->filename = filename;
 	{
-		throw std::runtime_error("couldn't load file " + filename);
+		std::lock_guard<std::mutex> lock(threadMutex);
+		loadJobs.push_back({ sound.get(), nullptr });
 	}
-	soundBuffers.push_back(buffer);
-	sf::Sound* sound = new sf::Sound();
-	sound->setBuffer(*buffer);
-	sounds.push_back(sound);
+	loadWake.notify_one();
+	sounds.push_back(std::move(sound));
+	return (int)sounds.size() - 1;
 }
 
-void SoundEngine::loadMusic(std::string const& filename)
+int SoundEngine::loadMusic(std::string const& filename)
 {
-	sf::Music* melody = new sf::Music();
-	if (!melody->openFromFile(filename))
+	size_t index = trackCount.load(std::memory_order_relaxed);
+	if (index == maxMusicTracks)
 	{
-		throw std::runtime_error("couldn't load file " + filename);
+		throw std::runtime_error("no room for music " + filename);
 	}
-	music.push_back(melody);
+	auto track = std::make_unique<MusicTrack>();
+	track->filename = filename;
+	{
+		std::lock_guard<std::mutex> lock(threadMutex);
+		loadJobs.push_back({ nullptr, track.get() });
+	}
+	loadWake.notify_one();
+	tracks[index] = std::move(track);
+	trackCount.store(index + 1, std::memory_order_release);
+	return (int)index;
 }
 
-void SoundEngine::playSound(int index)
+void SoundEngine::playSound(int index, int priority)
 {
-	sounds[index]->play();
+	SoundSlot const& sound = *sounds[index];
+	if (sound.failed.load(std::memory_order_relaxed) || !playRequests.push({ &sound, sound.volume / 100.0f, priority, pendingPlays == PendingPlays::eQueue, 0 }))
+	{
+		droppedSounds.fetch_add(1, std::memory_order_relaxed);
+	}
 }
 
 void SoundEngine::startMusic(int index)
 {
-	music[index]->play();
+	//starts from the beginning like sf::Music after a stop
+	tracks[index]->restartRequests.fetch_add(1, std::memory_order_release);
+	tracks[index]->playing.store(true, std::memory_order_relaxed);
+	streamWake.notify_all();
 }
 
 void SoundEngine::stopMusic(int index)
 {
-	music[index]->stop();
+	tracks[index]->playing.store(false, std::memory_order_relaxed);
 }
 
 void SoundEngine::loopMusic(int index, bool b)
 {
-	music[index]->setLoop(b);
+	tracks[index]->looping.store(b, std::memory_order_relaxed);
 }
 
 void SoundEngine::setSoundVolume(int index, float volume)
 {
-	sounds[index]->setVolume(volume);
+	//voices already playing keep the volume they started with
+	sounds[index]->volume = volume;
 }
 
 void SoundEngine::setMusicVolume(int index, float volume)
 {
-	music[index]->setVolume(volume);
-}
\ No newline at end of file
+	tracks[index]->volume.store(volume, std::memory_order_relaxed);
+}
+
+bool SoundEngine::onGetData(Chunk& data)
+{
+	takePlayRequests();
+
+	std::fill(mix.begin(), mix.end(), 0.0f);
+	for (auto& voice : voices)
+	{
+		if (voice.data)
+		{
+			mixVoice(voice);
+		}
+	}
+	size_t count = trackCount.load(std::memory_order_acquire);
+	for (size_t i = 0; i < count; i++)
+	{
+		mixMusic(*tracks[i]);
+	}
+
+	for (size_t i = 0; i < mix.size(); i++)
+	{
+		output[i] = (int16_t)std::clamp(mix[i], -32768.0f, 32767.0f);
+	}
+	mixedChunks++;
+
+	data.samples = output.data();
+	data.sampleCount = output.size();
+	return true;
+}
+
+void SoundEngine::onSeek(sf::Time timeOffset)
+{
+	//the mix is generated as it plays, there is nothing to seek
+}
+
+void SoundEngine::takePlayRequests()
+{
+	//queued plays whose sound finished loading start now
+	size_t kept = 0;
+	for (size_t i = 0; i < queuedPlayCount; i++)
+	{
+		PlayRequest const& request = queuedPlays[i];
+		if (request.sound->ready.load(std::memory_order_acquire))
+		{
+			startVoice(request);
+		}
+		else if (request.sound->failed.load(std::memory_order_relaxed) || mixedChunks - request.received > maxQueuedChunks)
+		{
+			droppedSounds.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			queuedPlays[kept++] = request;
+		}
+	}
+	queuedPlayCount = kept;
+
+	PlayRequest request;
+	while (playRequests.pop(request))
+	{
+		if (request.sound->ready.load(std::memory_order_acquire))
+		{
+			startVoice(request);
+		}
+		else if (request.queue && queuedPlayCount < maxQueuedPlays && !request.sound->failed.load(std::memory_order_relaxed))
+		{
+			request.received = mixedChunks;
+			queuedPlays[queuedPlayCount++] = request;
+		}
+		else
+		{
+			droppedSounds.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+void SoundEngine::startVoice(PlayRequest const& request)
+{
+	Voice* chosen = nullptr;
+	for (auto& voice : voices)
+	{
+		if (!voice.data)
+		{
+			chosen = &voice;
+			break;
+		}
+		if (!chosen || voice.priority < chosen->priority || (voice.priority == chosen->priority && voice.started < chosen->started))
+		{
+			chosen = &voice;
+		}
+	}
+	if (chosen->data && chosen->priority > request.priority)
+	{
+		droppedSounds.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	chosen->data = request.sound->data.get();
+	chosen->position = 0.0;
+	chosen->gain = request.gain;
+	chosen->priority = request.priority;
+	chosen->started = mixedChunks;
+}
+
+void SoundEngine::mixVoice(Voice& voice)
+{
+	SampleData const& data = *voice.data;
+	size_t frameCount = data.samples.size() / data.channelCount;
+	double step = (double)data.sampleRate / mixRate;
+	for (size_t i = 0; i < mixFrames; i++)
+	{
+		size_t frame = (size_t)voice.position;
+		if (frame >= frameCount)
+		{
+			voice.data = nullptr;
+			return;
+		}
+		float fraction = (float)(voice.position - frame);
+		float left, right, nextLeft, nextRight;
+		sampleFrame(data, frame, left, right);
+		sampleFrame(data, std::min(frame + 1, frameCount - 1), nextLeft, nextRight);
+		mix[i * 2] += (left + (nextLeft - left) * fraction) * voice.gain;
+		mix[i * 2 + 1] += (right + (nextRight - right) * fraction) * voice.gain;
+		voice.position += step;
+	}
+}
+
+void SoundEngine::mixMusic(MusicTrack& track)
+{
+	uint32_t requested = track.restartRequests.load(std::memory_order_acquire);
+	if (track.drainedEpoch.load(std::memory_order_relaxed) != requested)
+	{
+		//frames from before the restart are stale, nothing plays until the streaming thread rewound
+		StereoFrame stale;
+		bool rewound = track.epoch.load(std::memory_order_acquire) == requested;
+		while (track.frames.pop(stale));
+		if (!rewound)
+		{
+			return;
+		}
+		track.primed = false;
+		track.drainedEpoch.store(requested, std::memory_order_release);
+	}
+	if (!track.playing.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	float gain = track.volume.load(std::memory_order_relaxed) / 100.0f;
+	double step = (double)track.sampleRate / mixRate;
+	if (!track.primed)
+	{
+		if (!track.frames.pop(track.next))
+		{
+			return;
+		}
+		track.current = track.next;
+		track.fraction = 0.0;
+		track.primed = true;
+	}
+	for (size_t i = 0; i < mixFrames; i++)
+	{
+		while (track.fraction >= 1.0)
+		{
+			StereoFrame frame;
+			if (!track.frames.pop(frame))
+			{
+				//the streaming thread fell behind or the file ended, the rest of the chunk stays silent
+				track.primed = false;
+				return;
+			}
+			track.current = track.next;
+			track.next = frame;
+			track.fraction -= 1.0;
+		}
+		float fraction = (float)track.fraction;
+		mix[i * 2] += (track.current.left + (track.next.left - track.current.left) * fraction) * gain;
+		mix[i * 2 + 1] += (track.current.right + (track.next.right - track.current.right) * fraction) * gain;
+		track.fraction += step;
+	}
+}
+
+void SoundEngine::stream()
+{
+	std::unique_lock<std::mutex> lock(threadMutex);
+	while (!stopping)
+	{
+		lock.unlock();
+		size_t count = trackCount.load(std::memory_order_acquire);
+		for (size_t i = 0; i < count; i++)
+		{
+			MusicTrack& track = *tracks[i];
+			if (!track.ready.load(std::memory_order_acquire))
+			{
+				continue;
+			}
+			uint32_t requested = track.restartRequests.load(std::memory_order_acquire);
+			if (track.epoch.load(std::memory_order_relaxed) != requested)
+			{
+				track.file.seek(0);
+				track.pending.clear();
+				track.epoch.store(requested, std::memory_order_release);
+			}
+			//the mixer still has to drop the frames from before the rewind
+			if (track.drainedEpoch.load(std::memory_order_acquire) == requested)
+			{
+				decode(track);
+			}
+		}
+		lock.lock();
+
+		//the queues hold a third of a second, refilling them a few times as often is plenty
+		streamWake.wait_for(lock, std::chrono::milliseconds(50), [this]() { return stopping; });
+	}
+}
+
+void SoundEngine::decode(MusicTrack& track)
+{
+	//frames that didn't fit last time go first
+	size_t pushed = 0;
+	while (pushed < track.pending.size() && track.frames.push(track.pending[pushed]))
+	{
+		pushed++;
+	}
+	track.pending.erase(track.pending.begin(), track.pending.begin() + pushed);
+	if (!track.pending.empty())
+	{
+		return;
+	}
+
+	unsigned int channelCount = track.file.getChannelCount();
+	size_t readSize = decodeFrames * channelCount;
+	if (decoded.size() < readSize)
+	{
+		decoded.resize(readSize);
+	}
+	while (true)
+	{
+		size_t frameCount = (size_t)track.file.read(decoded.data(), readSize) / channelCount;
+		if (frameCount == 0)
+		{
+			if (!track.looping.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+			track.file.seek(0);
+			continue;
+		}
+
+		for (size_t i = 0; i < frameCount; i++)
+		{
+			int16_t const* samples = decoded.data() + i * channelCount;
+			StereoFrame frame = { samples[0], channelCount > 1 ? samples[1] : samples[0] };
+			if (!track.pending.empty() || !track.frames.push(frame))
+			{
+				track.pending.push_back(frame);
+			}
+		}
+		if (!track.pending.empty())
+		{
+			return;
+		}
+	}
+}
+
+void SoundEngine::load()
+{
+	std::unique_lock<std::mutex> lock(threadMutex);
+	while (true)
+	{
+		loadWake.wait(lock, [this]() { return stopping || !loadJobs.empty(); });
+		if (stopping)
+		{
+			return;
+		}
+		LoadJob job = loadJobs.front();
+		loadJobs.pop_front();
+		lock.unlock();
+
+		auto start = std::chrono::steady_clock::now();
+		if (job.sound)
+		{
+			loadSamples(*job.sound);
+		}
+		else if (job.track->file.openFromFile(job.track->filename) && job.track->file.getSampleCount() != 0)
+		{
+			job.track->sampleRate = job.track->file.getSampleRate();
+			job.track->ready.store(true, std::memory_order_release);
+			LOG_INFO("opened {} in {} ms", job.track->filename, millisecondsSince(start));
+		}
+		else
+		{
+			LOG_WARNING("couldn't load file {}, the music stays silent", job.track->filename);
+		}
+
+		lock.lock();
+		if (loadJobs.empty())
+		{
+			LOG_INFO("sound files loaded {} ms after the sound engine started", millisecondsSince(created));
+		}
+	}
+}
+
+void SoundEngine::loadSamples(SoundSlot& sound)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto cached = sampleCache.find(sound.filename);
+	if (cached != sampleCache.end())
+	{
+		sound.data = cached->second;
+		sound.ready.store(true, std::memory_order_release);
+		return;
+	}
+
+	sf::InputSoundFile file;
+	if (!file.openFromFile(sound.filename) || file.getSampleCount() < file.getChannelCount())
+	{
+		LOG_WARNING("couldn't load file {}, its sounds are dropped", sound.filename);
+		sound.failed.store(true, std::memory_order_relaxed);
+		return;
+	}
+	auto data = std::make_shared<SampleData>();
+	data->channelCount = file.getChannelCount();
+	data->sampleRate = file.getSampleRate();
+	data->samples.resize((size_t)file.getSampleCount());
+	data->samples.resize((size_t)file.read(data->samples.data(), data->samples.size()));
+
+	sampleCache[sound.filename] = data;
+	sound.data = data;
+	sound.ready.store(true, std::memory_order_release);
+	LOG_INFO("decoded {} in {} ms", sound.filename, millisecondsSince(start));
+}
@@ -1,23 +1,174 @@
 #pragma once
 
+#include "SpscQueue.h"
 #include <SFML/Audio.hpp>
+#include <vector>
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <cstdint>
 
-class SoundEngine
+//decoded samples of a sound file, shared by every voice playing it
+struct SampleData
+{
+	std::vector<int16_t> samples;	//interleaved
+	unsigned int channelCount;
+	unsigned int sampleRate;
+};
+
+//what playSound does with a sound whose file is still loading
+enum class PendingPlays
+{
+	eQueue,		//start it once the file is decoded, unless that takes longer than maxQueuedChunks
+	eDrop
+};
+
+//a loaded sound, the handle loadSound returns indexes these
+struct SoundSlot
+{
+	std::string filename;
+	std::shared_ptr<SampleData const> data;	//written by the loader thread before ready
+	std::atomic<bool> ready{ false };
+	std::atomic<bool> failed{ false };			//the file couldn't be decoded, plays are dropped
+	float volume = 100.0f;
+};
+
+struct StereoFrame
+{
+	int16_t left;
+	int16_t right;
+};
+
+//music file decoded a piece at a time by the streaming thread
+struct MusicTrack
+{
+	std::string filename;
+	std::atomic<bool> ready{ false };				//the loader thread opened the file
+	sf::InputSoundFile file;						//streaming thread only once ready
+	unsigned int sampleRate = 0;
+	SpscQueue<StereoFrame, 16384> frames;			//decoded ahead of the mixer, about a third of a second
+	std::vector<StereoFrame> pending;				//decoded frames that didn't fit yet, streaming thread only
+	std::atomic<bool> playing{ false };
+	std::atomic<bool> looping{ false };
+	std::atomic<float> volume{ 100.0f };
+	std::atomic<uint32_t> restartRequests{ 0 };		//counts startMusic calls, the mixer stays silent until the restart reached it
+	std::atomic<uint32_t> epoch{ 0 };				//restart the streaming thread rewound the file for
+	std::atomic<uint32_t> drainedEpoch{ 0 };		//restart the mixer dropped the older frames for, decoding waits for it
+	StereoFrame current = {};						//mixer only, frames around the read position
+	StereoFrame next = {};
+	double fraction = 0.0;
+	bool primed = false;
+};
+
+//preallocated voices mixed on sfml's streaming thread together with the music tracks
+//a sound never gets a source of its own, so the same effect can overlap itself
+class SoundEngine : private sf::SoundStream
 {
 public:
+	static constexpr unsigned int mixRate = 48000;
+	static constexpr size_t voiceCount = 32;
+	static constexpr size_t maxMusicTracks = 4;
+	static constexpr size_t mixFrames = 1024;		//frames per chunk handed to sfml, about 21 ms
+	static constexpr size_t maxQueuedPlays = 16;
+	static constexpr uint64_t maxQueuedChunks = 24;	//a queued play older than half a second is dropped, it would come too late
+
 	SoundEngine();
+	//stops the mixer and joins the streaming and loader threads, a file being decoded is finished first
 	~SoundEngine();
 
-	void loadSound(std::string const& filename);
-	void loadMusic(std::string const& filename);
-	void playSound(int index);
+	SoundEngine(SoundEngine const&) = delete;
+	SoundEngine& operator=(SoundEngine const&) = delete;
+
+	//both return the handle right away and the file is read on the loader thread, a file that can't be read is reported there
+	//files that were loaded before share their samples
+	int loadSound(std::string const& filename);
+	//music starts once its file is open if startMusic was called before
+	int loadMusic(std::string const& filename);
+	//takes a free voice, or the lowest priority one playing if it's not above priority, dropped otherwise
+	//sounds that are still loading are queued or dropped by pendingPlays
+	void playSound(int index, int priority = 0);
+	void setPendingPlays(PendingPlays policy) noexcept { pendingPlays = policy; }
 	void startMusic(int index);
 	void stopMusic(int index);
 	void loopMusic(int index, bool b);
 	void setSoundVolume(int index, float volume);
 	void setMusicVolume(int index, float volume);
 
-	std::vector<sf::Sound*> sounds;
-	std::vector<sf::SoundBuffer*> soundBuffers;
-	std::vector<sf::Music*> music;
-};
\ No newline at end of file
+private:
+	struct Voice
+	{
+		SampleData const* data = nullptr;	//nullptr if free
+		double position = 0.0;				//in source frames
+		float gain = 0.0f;
+		int priority = 0;
+		uint64_t started = 0;				//mix chunk it started in, older voices are stolen first
+	};
+
+	struct PlayRequest
+	{
+		SoundSlot const* sound;
+		float gain;
+		int priority;
+		bool queue;			//wait for the sound if it's still loading
+		uint64_t received;	//mix chunk it was queued in
+	};
+
+	struct LoadJob
+	{
+		SoundSlot* sound;	//one of the two is set
+		MusicTrack* track;
+	};
+
+	bool onGetData(Chunk& data) override;
+	void onSeek(sf::Time timeOffset) override;
+
+	//start, queue or drop the play requests
+	void takePlayRequests();
+	void startVoice(PlayRequest const& request);
+	void mixVoice(Voice& voice);
+	void mixMusic(MusicTrack& track);
+	//decode music ahead of the mixer until the engine is destroyed
+	void stream();
+	//decode until the track's queue is full or its file ended without looping
+	void decode(MusicTrack& track);
+	//decode sound files and open music files until the engine is destroyed
+	void load();
+	void loadSamples(SoundSlot& sound);
+
+	std::vector<std::unique_ptr<SoundSlot>> sounds;
+	PendingPlays pendingPlays = PendingPlays::eQueue;
+
+	std::array<std::unique_ptr<MusicTrack>, maxMusicTracks> tracks;
+	std::atomic<size_t> trackCount{ 0 };			//tracks below it are ready for both threads
+
+	//mixer thread only
+	SpscQueue<PlayRequest, 64> playRequests;
+	std::atomic<uint32_t> droppedSounds{ 0 };
+	std::array<PlayRequest, maxQueuedPlays> queuedPlays;
+	size_t queuedPlayCount = 0;
+	std::array<Voice, voiceCount> voices;
+	uint64_t mixedChunks = 0;
+	std::vector<float> mix;
+	std::vector<int16_t> output;
+
+	std::vector<int16_t> decoded;					//streaming thread only
+	std::thread streamer;
+
+	//loader thread only
+	std::map<std::string, std::shared_ptr<SampleData const>> sampleCache;
+	std::chrono::steady_clock::time_point created;
+	std::thread loader;
+
+	std::mutex threadMutex;							//guards loadJobs and stopping
+	std::condition_variable streamWake;
+	std::condition_variable loadWake;
+	std::deque<LoadJob> loadJobs;
+	bool stopping = false;
+};
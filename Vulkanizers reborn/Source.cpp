@@ -1,20 +1,65 @@
 #include "Game.h"
+#include "SpriteBenchmark.h"
+#include "Log.h"
 
 #include <iostream>
+#include <cstring>
 
-int main()
+int main(int argc, char* argv[])
 {
+	//draws a fixed number of frames in a hidden window with every frame wait checked, exits with 1 if frames retire out of order
+	//settings after it override the test's like they would the config
+	bool frameOrderTest = argc > 1 && std::strcmp(argv[1], "--frame-order-test") == 0;
 	try
 	{
+		if (argc > 1 && std::strcmp(argv[1], "--sprite-benchmark") == 0)
+		{
+			benchmarkSpriteUpdate();
+			return 0;
+		}
+		//the program doesn't have to be able to start for its logs to be read
+		if (argc > 2 && std::strcmp(argv[1], "--format-log") == 0)
+		{
+			if (!Logger::formatBinaryLog(argv[2], std::cout))
+			{
+				throw std::runtime_error(std::string("couldn't read the rest of log file ") + argv[2]);
+			}
+			return 0;
+		}
+
 		loadConfig("configs/config.txt");
+		if (frameOrderTest)
+		{
+			//software devices like lavapipe let it run without a gpu, most frames in flight retire the most out of step
+			Settings::CHECK_FRAME_ORDER = true;
+			Settings::ALLOW_SOFTWARE_DEVICE = true;
+			Settings::HIDE_WINDOW = true;
+			Settings::RENDER_ON_DEMAND = false;
+			Settings::FRAMES_IN_FLIGHT = Settings::MAX_FRAMES_IN_FLIGHT;
+			Settings::EXIT_AFTER_FRAMES = 1000;
+			argc--;
+			argv++;
+		}
+		applySettingOverrides(argc, argv);
+		printSettings();
+		Logger::start(Settings::LOG_LEVEL, Settings::LOG_FILE);
+
+		{
+			Game game;
 
-		Game game;
-		
-		game.start();
+			game.start();
+		}
+		Logger::stop();
 	}
 	catch (const std::exception& e)
 	{
+		//whatever led up to the error gets written first
+		Logger::stop();
 		std::cout << e.what() << "\n";
+		if (frameOrderTest)
+		{
+			return 1;
+		}
 		int n;
 		std::cin >> n;
 		return -1;
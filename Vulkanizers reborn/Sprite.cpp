@@ -1,200 +1,452 @@
 #include "Sprite.h"
 #include "VulkanResources.h"
 #include "Game.h"
+#include "Log.h"
 
-SpritePool::Sprite::Sprite()
-	:remainingUpdates{ 0 }, isRemoved{ true }, object{ nullptr }, posX{ 0.0f }, posY{ 0.0f }, layer{ SpriteLayers::eGUI }, sizeX{ -1.0f }, sizeY{ -1.0f }, rotation{ 0.0f }, texture{ nullptr }
-{}
+void SpriteArrays::push_back(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
+	vk::Sampler sampler, Texture* texture, uint32_t version)
+{
+	this->posX.push_back(posX);
+	this->posY.push_back(posY);
+	this->sizeX.push_back(sizeX);
+	this->sizeY.push_back(sizeY);
+	this->rotation.push_back(rotation);
+	layers.push_back(layer);
+	textures.push_back(texture);
+	samplers.push_back(sampler);
+	versions.push_back(version);
+}
+
+void SpriteArrays::pop_back()
+{
+	posX.pop_back();
+	posY.pop_back();
+	sizeX.pop_back();
+	sizeY.pop_back();
+	rotation.pop_back();
+	layers.pop_back();
+	textures.pop_back();
+	samplers.pop_back();
+	versions.pop_back();
+}
+
+void SpriteArrays::copy(uint32_t from, uint32_t to)
+{
+	posX[to] = posX[from];
+	posY[to] = posY[from];
+	sizeX[to] = sizeX[from];
+	sizeY[to] = sizeY[from];
+	rotation[to] = rotation[from];
+	layers[to] = layers[from];
+	textures[to] = textures[from];
+	samplers[to] = samplers[from];
+	versions[to] = versions[from];
+}
 
-SpritePool::Sprite::Sprite(VulkanResources* vulkan)
-	:object{ nullptr }, texture{ nullptr }
+void SpriteBatch::computeMvps(SpriteArrays const& sprites)
 {
-	uniformBuffers.resize(vulkan->swapChainImages.size());
-	uniformBuffersMemory.resize(vulkan->swapChainImages.size());
-	mapped.resize(vulkan->swapChainImages.size());
+	static glm::mat4 const projection = glm::ortho(-1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f);
+	size_t count = indices.size();
+	angles.resize(count);
+	sine.resize(count);
+	cosine.resize(count);
+	mvps.resize(count * 16);
 
-	for (size_t i = 0; i < vulkan->swapChainImages.size(); i++)
+	//gather first so the trigonometry runs over contiguous floats
+	for (size_t i = 0; i < count; i++)
+	{
+		angles[i] = sprites.rotation[indices[i]];
+	}
+	for (size_t i = 0; i < count; i++)
 	{
-		vulkan->createBuffer(sizeof(UniformBufferObject), vk::BufferUsageFlagBits::eUniformBuffer,
-			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-			uniformBuffers[i], uniformBuffersMemory[i]);
-		mapped[i] = vulkan->device.mapMemory(uniformBuffersMemory[i], 0, sizeof(UniformBufferObject));
+		sine[i] = std::sin(angles[i]);
+		cosine[i] = std::cos(angles[i]);
 	}
 
-	std::vector<vk::DescriptorSetLayout> layouts(vulkan->swapChainImages.size(), vulkan->graphicsPipelinesData[0].descriptorSetLayout);
-	vk::DescriptorSetAllocateInfo allocInfo(vulkan->descriptorPool, (uint32_t)vulkan->swapChainImages.size(), layouts.data());
+	//projection * translate * rotate around z * scale, written out since only the first two columns and the origin vary
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t sprite = indices[i];
+		float sizeX = sprites.sizeX[sprite];
+		float sizeY = sprites.sizeY[sprite];
+		glm::vec4 right = projection[0] * (cosine[i] * sizeX) + projection[1] * (sine[i] * sizeX);
+		glm::vec4 up = projection[0] * (-sine[i] * sizeY) + projection[1] * (cosine[i] * sizeY);
+		glm::vec4 origin = projection[0] * sprites.posX[sprite] + projection[1] * sprites.posY[sprite] +
+			projection[2] * spriteDepth(sprites.layers[sprite]) + projection[3];
+		glm::mat4 mvp(right, up, projection[2], origin);
+		memcpy(&mvps[i * 16], &mvp, sizeof(mvp));
+	}
+}
+
+SpriteChanges::SpriteChanges(uint32_t imageCount)
+	:dirty(imageCount)
+{
 
-	descriptorSets = vulkan->device.allocateDescriptorSets(allocInfo);
 }
 
-void SpritePool::Sprite::instantiate(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
-	VulkanResources* vk, vk::Sampler sampler, Texture* texture, GraphicsComponent* object)
+void SpriteChanges::markChanged(SpriteArrays const& sprites)
 {
-	this->posX = posX;
-	this->posY = posY;
-	this->layer = layer;
-	this->sizeX = sizeX;
-	this->sizeY = sizeY;
-	this->rotation = rotation;
-	this->textureSampler = sampler;
-	this->texture = texture;
-	this->object = object;
-	this->isRemoved = false;
-	this->remainingUpdates = 0;
+	uint32_t count = sprites.size();
+	//bits past the end after sprites were removed are skipped, a sprite added there later has a new version
+	seenVersions.resize(count, 0);
+	for (auto& bits : dirty)
+	{
+		bits.resize((count + 63) / 64, 0);
+	}
 
-	for (size_t i = 0; i < vk->swapChainImages.size(); i++)
+	for (uint32_t i = 0; i < count; i++)
 	{
-		UniformBufferObject ubo = {};
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(posX, posY, toUType(layer) / 10.0f));
-		model = glm::rotate(model, rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-		model = glm::scale(model, glm::vec3(sizeX, sizeY, 1.0f));
-		ubo.mvp = glm::ortho(-1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f) * model;
-		memcpy(mapped[i], &ubo, sizeof(ubo));
+		if (seenVersions[i] == sprites.versions[i])
+		{
+			continue;
+		}
+		seenVersions[i] = sprites.versions[i];
+		for (auto& bits : dirty)
+		{
+			bits[i / 64] |= 1ull << (i % 64);
+		}
 	}
+}
 
-	for (size_t i = 0; i < vk->swapChainImages.size(); i++)
+//words without dirty sprites are skipped whole, most of them when only a few sprites move
+void SpriteChanges::collect(uint32_t imageIndex, uint32_t count, std::vector<uint32_t>& indices)
+{
+	indices.clear();
+	auto& bits = dirty[imageIndex];
+	for (uint32_t word = 0; word < (uint32_t)bits.size(); word++)
 	{
-		vk::DescriptorBufferInfo bufferInfo(uniformBuffers[i], 0, sizeof(UniformBufferObject));
+		uint64_t remaining = bits[word];
+		bits[word] = 0;
+		while (remaining)
+		{
+			uint32_t index = word * 64 + lowestSetBit(remaining);
+			remaining &= remaining - 1;
+			if (index < count)
+			{
+				indices.push_back(index);
+			}
+		}
+	}
+}
 
-		vk::DescriptorImageInfo imageInfo(textureSampler, texture->imageView, vk::ImageLayout::eShaderReadOnlyOptimal);
+SpritePool::SpritePool()
+	:nextVersion{ 1 }, freeSlot{ 0 }
+{
 
-		std::array<vk::WriteDescriptorSet, 2> descriptorWrites = {};
-		descriptorWrites[0] = vk::WriteDescriptorSet(descriptorSets[i], 0, 0, 1,
-			vk::DescriptorType::eUniformBuffer, nullptr, &bufferInfo, nullptr);
-		descriptorWrites[1] = vk::WriteDescriptorSet(descriptorSets[i], 1, 0, 1,
-			vk::DescriptorType::eCombinedImageSampler, &imageInfo, nullptr, nullptr);
+}
 
-		vk->device.updateDescriptorSets(descriptorWrites, nullptr);
+SpriteHandle SpritePool::addSprite(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
+	vk::Sampler sampler, Texture* texture)
+{
+	if (Settings::MAX_SPRITES != 0 && sprites.size() == Settings::MAX_SPRITES)
+	{
+		throw std::runtime_error("can't add more than " + std::to_string(Settings::MAX_SPRITES) + " sprites");
 	}
+	if (freeSlot == slots.size())
+	{
+		slots.push_back({ (uint32_t)slots.size() + 1, 1 });
+	}
+	uint32_t slot = freeSlot;
+	freeSlot = slots[slot].index;
+	slots[slot].index = sprites.size();
+
+	sprites.push_back(posX, posY, layer, sizeX, sizeY, rotation, sampler, texture, nextVersion++);
+	spriteSlots.push_back(slot);
+	LOG_TRACE("instantiated sprite at {} index", sprites.size() - 1);
+	return { slot, slots[slot].generation };
 }
 
-//free sprite resources
-void SpritePool::Sprite::destroy(VulkanResources* vulkan)
+//swap removed sprite with last valid sprite, only the moved sprite's slot learns its new index
+//the render thread sees a new version at both indices and rewrites them, so nothing has to wait for the gpu here
+void SpritePool::removeSprite(SpriteHandle handle)
 {
-	for (size_t i = 0; i < vulkan->swapChainImages.size(); i++)
+	if (!contains(handle))
+	{
+		throw std::exception("tried removing already deleted sprite");
+	}
+	uint32_t index = slots[handle.slot].index;
+	LOG_TRACE("removed sprite at {} index", index);
+
+	uint32_t last = sprites.size() - 1;
+	if (index != last)
 	{
-		vulkan->device.destroyBuffer(uniformBuffers[i]);
-		vulkan->device.freeMemory(uniformBuffersMemory[i]);
+		sprites.copy(last, index);
+		sprites.versions[index] = nextVersion++;
+		spriteSlots[index] = spriteSlots[last];
+		slots[spriteSlots[index]].index = index;
+		LOG_TRACE("swapped sprites at indices {} and {}", last, index);
 	}
-	vulkan->device.freeDescriptorSets(vulkan->descriptorPool, descriptorSets);
+	else
+	{
+		//no sprite got a new version, the pool's still has to change
+		nextVersion++;
+	}
+	sprites.pop_back();
+	spriteSlots.pop_back();
+
+	//generation 0 marks empty handles, skip it when wrapping around
+	slots[handle.slot].generation = (handle.generation == UINT32_MAX) ? 1 : handle.generation + 1;
+	slots[handle.slot].index = freeSlot;
+	freeSlot = handle.slot;
 }
 
-void SpritePool::Sprite::update(uint32_t imageIndex)
+void SpritePool::moveSprite(SpriteHandle handle, float newX, float newY)
 {
-	updateUniformBuffers(imageIndex);
+	uint32_t index = resolve(handle);
+	sprites.posX[index] = newX;
+	sprites.posY[index] = newY;
+	sprites.versions[index] = nextVersion++;
 }
 
-void SpritePool::Sprite::movePosition(float newX, float newY)
+bool SpritePool::contains(SpriteHandle handle) const noexcept
 {
-	posX = newX;
-	posY = newY;
-	remainingUpdates = (unsigned char)uniformBuffers.size();
+	return !handle.isEmpty() && handle.slot < slots.size() && slots[handle.slot].generation == handle.generation;
 }
 
-void SpritePool::Sprite::updateUniformBuffers(uint32_t imageIndex)
+uint32_t SpritePool::resolve(SpriteHandle handle) const
 {
-	remainingUpdates--;
-	UniformBufferObject ubo = {};
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(posX, posY, toUType(layer) / 10.0f));
-	model = glm::rotate(model, rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-	model = glm::scale(model, glm::vec3(sizeX, sizeY, 1.0f));
-	ubo.mvp = glm::ortho(-1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f) * model;
-	memcpy(mapped[imageIndex], &ubo, sizeof(ubo));
+	//a stale handle's slot may belong to another sprite by now, writing through it would move the wrong one
+	if (!contains(handle))
+	{
+		throw std::exception("used stale sprite handle");
+	}
+	return slots[handle.slot].index;
 }
 
-SpritePool::SpritePool(VulkanResources* vulkan)
-	:spriteCount{ 0 }, vulkan{ vulkan }
+//reuses the snapshot's capacity, so this only allocates when the pool grew past every earlier snapshot
+void SpritePool::copyTo(FrameSnapshot& frame) const
 {
-	//allocate vulkan buffers preemptively
-	for (auto& sprite : sprites)
+	frame.sprites = sprites;
+}
+
+//image regions are 4096 bytes apart, a multiple of every allowed minStorageBufferOffsetAlignment
+SpriteResources::Page::Page(VulkanResources* vulkan)
+	:vulkan{ vulkan }
+{
+	uint32_t imageCount = (uint32_t)vulkan->swapChainImages.size();
+	vk::DeviceSize regionSize = pageSize * 16 * sizeof(float);
+
+	vulkan->createBuffer(regionSize * imageCount, vk::BufferUsageFlagBits::eStorageBuffer,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+		mvpBuffer, mvpBufferMemory);
+	mapped = vulkan->device.mapMemory(mvpBufferMemory, 0, regionSize * imageCount);
+
+	vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, imageCount);
+	vk::DescriptorPoolCreateInfo poolInfo({}, imageCount, 1, &poolSize);
+	descriptorPool = vulkan->device.createDescriptorPool(poolInfo);
+
+	std::vector<vk::DescriptorSetLayout> layouts(imageCount, vulkan->graphicsPipelinesData[0].descriptorSetLayout);
+	vk::DescriptorSetAllocateInfo allocInfo(descriptorPool, imageCount, layouts.data());
+	descriptorSets = vulkan->device.allocateDescriptorSets(allocInfo);
+
+	for (uint32_t i = 0; i < imageCount; i++)
 	{
-		sprite = Sprite(vulkan);
+		vk::DescriptorBufferInfo bufferInfo(mvpBuffer, i * regionSize, regionSize);
+		vk::WriteDescriptorSet descriptorWrite(descriptorSets[i], 0, 0, 1,
+			vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfo, nullptr);
+		vulkan->device.updateDescriptorSets(descriptorWrite, nullptr);
 	}
+}
 
+//destroying the pool frees its sets
+SpriteResources::Page::~Page()
+{
+	vulkan->device.destroyDescriptorPool(descriptorPool);
+	vulkan->device.unmapMemory(mvpBufferMemory);
+	vulkan->device.destroyBuffer(mvpBuffer);
+	vulkan->device.freeMemory(mvpBufferMemory);
 }
 
-SpritePool::~SpritePool()
+void SpriteResources::Page::writeMvp(uint32_t slot, uint32_t imageIndex, float const* mvp)
 {
-	clear();
+	memcpy(static_cast<float*>(mapped) + (imageIndex * pageSize + slot) * 16, mvp, 16 * sizeof(float));
 }
 
-short SpritePool::addSprite(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
-	vk::Sampler sampler, Texture* texture, GraphicsComponent* object)
+SpriteResources::SpriteResources(VulkanResources* vulkan)
+	:vulkan{ vulkan }, seenSequence{ 0 }, changes{ (uint32_t)vulkan->swapChainImages.size() }
 {
-	if (spriteCount == Settings::MAX_SPRITES)
+
+}
+
+SpriteResources::~SpriteResources()
+{
+	//wait until gpu is done
+	vulkan->device.waitIdle();
+	pages.clear();
+	for (auto pool : texturePools)
 	{
-		throw std::exception("exceeded sprite limit");
+		vulkan->device.destroyDescriptorPool(pool);
 	}
-
-	sprites[spriteCount].instantiate(posX, posY, layer, sizeX, sizeY, rotation, vulkan, sampler, texture, object);
-	std::cout << "instantiated sprite at " << spriteCount << " index\n";
-	spriteCount++;
-	return spriteCount - 1;
+	LOG_DEBUG("destroyed all sprites");
 }
 
-//mark sprite for removal and detach graphics component
-void SpritePool::removeSprite(unsigned short index)
+void SpriteResources::update(FrameSnapshot const& frame, uint32_t imageIndex)
 {
-	if (index >= spriteCount)
+	SpriteArrays const& sprites = frame.sprites;
+	uint32_t count = sprites.size();
+
+	//new pages aren't referenced by any command buffer yet, no need to wait for the gpu
+	while (pages.size() * pageSize < count)
 	{
-		throw std::exception("tried removing already deleted sprite");
+		pages.push_back(std::make_unique<Page>(vulkan));
+		LOG_DEBUG("allocated sprite page {}, room for {} sprites", pages.size(), pages.size() * pageSize);
+	}
+
+	//the same snapshot can be drawn more than once, only compare versions and sort when a new one arrived
+	if (frame.sequence != seenSequence)
+	{
+		changes.markChanged(sprites);
+		sort(sprites);
+		seenSequence = frame.sequence;
+	}
+
+	changes.collect(imageIndex, count, batch.indices);
+	if (batch.indices.empty())
+	{
+		return;
+	}
+
+	batch.computeMvps(sprites);
+
+	for (size_t i = 0; i < batch.indices.size(); i++)
+	{
+		uint32_t sprite = batch.indices[i];
+		pages[sprite / pageSize]->writeMvp(sprite % pageSize, imageIndex, &batch.mvps[i * 16]);
 	}
-	sprites[index].isRemoved = true;
-	sprites[index].object = nullptr;
-	std::cout << "removed sprite at " << index << " index\n";
 }
 
-//swap removed sprite with last valid sprite and free resources
-void SpritePool::deleteSprite(unsigned short index)
+uint32_t SpriteResources::getTextureSet(Texture* texture, vk::Sampler sampler)
 {
-	std::swap(sprites[spriteCount - 1], sprites[index]);
-	std::swap(frameCounts[spriteCount - 1], frameCounts[index]);
-	spriteCount--;
-	std::cout << "swapped sprites at indices " << spriteCount << " and " << index << "\n";
-	//update the moved sprite's object
-	if (!sprites[index].isRemoved)
+	auto found = textureSetIds.find({ texture, (VkSampler)sampler });
+	if (found != textureSetIds.end())
 	{
-		sprites[index].object->spriteIndex = index;
+		return found->second;
 	}
+	if (textureSets.size() == maxTextureSets)
+	{
+		throw std::runtime_error("too many texture and sampler combinations for the sprite sort key");
+	}
+
+	if (textureSets.size() % texturePoolSize == 0)
+	{
+		vk::DescriptorPoolSize poolSize(vk::DescriptorType::eCombinedImageSampler, texturePoolSize);
+		vk::DescriptorPoolCreateInfo poolInfo({}, texturePoolSize, 1, &poolSize);
+		texturePools.push_back(vulkan->device.createDescriptorPool(poolInfo));
+	}
+	vk::DescriptorSetAllocateInfo allocInfo(texturePools.back(), 1, &vulkan->spriteTextureSetLayout);
+	vk::DescriptorSet set = vulkan->device.allocateDescriptorSets(allocInfo)[0];
+
+	vk::DescriptorImageInfo imageInfo(sampler, texture->imageView, vk::ImageLayout::eShaderReadOnlyOptimal);
+	vk::WriteDescriptorSet descriptorWrite(set, 0, 0, 1,
+		vk::DescriptorType::eCombinedImageSampler, &imageInfo, nullptr, nullptr);
+	vulkan->device.updateDescriptorSets(descriptorWrite, nullptr);
 
-	frameCounts[spriteCount] = 0;
+	uint32_t id = (uint32_t)textureSets.size();
+	textureSets.push_back(set);
+	textureSetIds.emplace(std::make_pair(texture, (VkSampler)sampler), id);
+	return id;
 }
 
-void SpritePool::clear()
+//lsd radix sort on the upper half of the keys, stable so the sprite indices in the lower half stay ascending
+void radixSortUpperHalf(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch)
 {
-	//wait until gpu is done
-	vulkan->device.waitIdle();
-	for (int i = 0; i < sprites.size(); i++)
+	if (keys.empty())
+	{
+		return;
+	}
+	scratch.resize(keys.size());
+	for (uint32_t shift = 32; shift < 64; shift += 8)
 	{
-		//make objects forget about their sprites
-		if (sprites[i].object)
+		std::array<uint32_t, 256> offsets = {};
+		for (uint64_t key : keys)
+		{
+			offsets[(key >> shift) & 0xff]++;
+		}
+		//every key has the same byte here, the pass wouldn't move anything
+		if (offsets[(keys[0] >> shift) & 0xff] == keys.size())
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (auto& bucket : offsets)
+		{
+			uint32_t bucketSize = bucket;
+			bucket = offset;
+			offset += bucketSize;
+		}
+		for (uint64_t key : keys)
 		{
-			sprites[i].object->spriteIndex = -1;
+			scratch[offsets[(key >> shift) & 0xff]++] = key;
 		}
-		sprites[i].destroy(vulkan);
+		keys.swap(scratch);
 	}
-	std::cout << "destroyed all sprites\n";
-	spriteCount = 0;
 }
 
-void SpritePool::update(uint32_t imageIndex)
+//key from the top: 2 bits layer, then 16 bits depth and 14 bits texture set, the sprite index below
+//opaque layers group by texture first, transparent ones go back to front first and only group sprites at the same depth
+void SpriteResources::sort(SpriteArrays const& sprites)
 {
-	for (int i = 0; i < spriteCount; i++)
+	uint32_t count = sprites.size();
+	sortKeys.resize(count);
+	spriteTextureSets.resize(count);
+
+	Texture* lastTexture = nullptr;
+	vk::Sampler lastSampler;
+	uint32_t lastSet = 0;
+	for (uint32_t i = 0; i < count; i++)
 	{
-		if (sprites[i].isRemoved)
+		//neighbouring sprites mostly share a texture, skip the lookup for them
+		if (sprites.textures[i] != lastTexture || sprites.samplers[i] != lastSampler || i == 0)
 		{
-			frameCounts[i]++;
-			if (frameCounts[i] == vulkan->swapChainImages.size())
-			{
-				deleteSprite(i);
-				i--;
-			}
+			lastTexture = sprites.textures[i];
+			lastSampler = sprites.samplers[i];
+			lastSet = getTextureSet(lastTexture, lastSampler);
 		}
-		else if (sprites[i].remainingUpdates > 0)
+		spriteTextureSets[i] = lastSet;
+
+		SpriteLayers layer = sprites.layers[i];
+		uint64_t depth = (uint64_t)std::min(spriteDepth(layer) * 65535.0f, 65535.0f);
+		uint64_t upper = (uint64_t)toUType(layer) << 30;
+		if (isTransparentLayer(layer))
+		{
+			upper |= (depth << 14) | lastSet;
+		}
+		else
 		{
-			sprites[i].update(imageIndex);
+			upper |= ((uint64_t)lastSet << 16) | depth;
 		}
+		sortKeys[i] = (upper << 32) | i;
+	}
+
+	radixSortUpperHalf(sortKeys, sortScratch);
+
+	for (auto& draws : layerDraws)
+	{
+		draws.clear();
+		//a layer never has more draws than sprites, so only a higher sprite count makes it grow
+		draws.reserve(count);
 	}
-}
\ No newline at end of file
+	stats = { count, 0, 0 };
+	for (uint64_t key : sortKeys)
+	{
+		uint32_t sprite = (uint32_t)key;
+		uint32_t page = sprite / pageSize;
+		uint32_t slot = sprite % pageSize;
+		uint32_t textureSet = spriteTextureSets[sprite];
+		auto& draws = layerDraws[toUType(sprites.layers[sprite])];
+
+		//consecutive slots of a page with one texture are one instanced draw
+		if (!draws.empty() && draws.back().page == page && draws.back().textureSet == textureSet &&
+			draws.back().firstSlot + draws.back().count == slot)
+		{
+			draws.back().count++;
+			continue;
+		}
+		//each layer is its own command buffer and starts with nothing bound
+		stats.binds += (draws.empty() || draws.back().page != page) ? 1 : 0;
+		stats.binds += (draws.empty() || draws.back().textureSet != textureSet) ? 1 : 0;
+		draws.push_back({ page, textureSet, slot, 1 });
+		stats.draws++;
+	}
+}
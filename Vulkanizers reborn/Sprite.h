@@ -3,78 +3,220 @@
 #include "Constants.h"
 #include "Texture.h"
 #include <vulkan/vulkan.hpp>
+#include <map>
+#include <array>
 
 class VulkanResources;
 class Object;
-class GraphicsComponent;
+struct FrameSnapshot;
 
+//sprites as parallel arrays, index i of every array is sprite i
+//the render thread's per-frame pass only reads the arrays it needs, copied into every frame snapshot
+struct SpriteArrays
+{
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> sizeX;
+	std::vector<float> sizeY;
+	std::vector<float> rotation;
+	std::vector<SpriteLayers> layers;
+	std::vector<Texture*> textures;
+	std::vector<vk::Sampler> samplers;
+	std::vector<uint32_t> versions;	//unique for every sprite state, sprites whose version changed get rewritten
+
+	uint32_t size() const { return (uint32_t)versions.size(); }
+	void push_back(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
+		vk::Sampler sampler, Texture* texture, uint32_t version);
+	void pop_back();
+	//copy sprite from into index to, from stays valid
+	void copy(uint32_t from, uint32_t to);
+};
+
+//dirty sprites gathered for one batched mvp update, kept between frames so batches don't allocate
+struct SpriteBatch
+{
+	std::vector<uint32_t> indices;	//sprites to update
+	std::vector<float> angles;
+	std::vector<float> sine;
+	std::vector<float> cosine;
+	std::vector<float> mvps;		//16 floats per sprite in indices, column major
+
+	//recompute the mvp of every sprite in indices, one pass per stage over contiguous arrays so the loops vectorise
+	void computeMvps(SpriteArrays const& sprites);
+};
+
+//which sprites every swap chain image has to rewrite, images only catch up when they are drawn
+class SpriteChanges
+{
+public:
+	explicit SpriteChanges(uint32_t imageCount);
+
+	//mark sprites whose version differs from the last snapshot's dirty in every image
+	void markChanged(SpriteArrays const& sprites);
+	//move the dirty sprites of an image below count into indices and clear them
+	void collect(uint32_t imageIndex, uint32_t count, std::vector<uint32_t>& indices);
+
+private:
+	std::vector<uint32_t> seenVersions;
+	std::vector<std::vector<uint64_t>> dirty;	//[image] bit per sprite whose copy in that image is out of date
+};
+
+//names a sprite of a SpritePool, stays valid while sprites around it move and goes stale once it's removed
+struct SpriteHandle
+{
+	uint32_t slot = 0;
+	uint32_t generation = 0;	//0 is never handed out, default handles are empty
+
+	bool isEmpty() const noexcept { return generation == 0; }
+};
+
+//sprites of the simulation, only used by the update thread
+//sprites stay packed for the snapshots, handles go through a slot map so removal never touches the owners
 class SpritePool
 {
-	class Sprite
+public:
+	SpritePool();
+	~SpritePool() = default;
+
+	SpritePool(SpritePool const&) = delete;
+	SpritePool& operator=(SpritePool const&) = delete;
+
+	//throws if the pool already has MAX_SPRITES sprites
+	SpriteHandle addSprite(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
+		 vk::Sampler sampler, Texture* texture);
+	void removeSprite(SpriteHandle handle);	//moves the last sprite into the gap
+	void moveSprite(SpriteHandle handle, float newX, float newY);	//throws on stale handles like removeSprite
+	bool contains(SpriteHandle handle) const noexcept;
+	//copy the sprites into the snapshot that gets published next
+	void copyTo(FrameSnapshot& frame) const;
+
+	uint32_t size() const { return sprites.size(); }
+	//changes whenever a sprite is added, moved or removed
+	uint32_t version() const noexcept { return nextVersion; }
+private:
+	struct Slot
 	{
-	public:
-		Sprite();
-		~Sprite() = default;
+		uint32_t index;			//into sprites while in use, next free slot otherwise
+		uint32_t generation;	//bumped on removal so old handles stop resolving
+	};
+
+	uint32_t resolve(SpriteHandle handle) const;
 
-		//allocate all vulkan resources preemptively
-		explicit Sprite(VulkanResources* vulkan);
+	uint32_t nextVersion;
+	SpriteArrays sprites;				//keep their capacity when sprites are removed
+	std::vector<uint32_t> spriteSlots;	//slot of every sprite, follows it when it's moved into a gap
+	std::vector<Slot> slots;
+	uint32_t freeSlot;					//head of the free list, slots.size() if empty
+};
 
-		//can only move sprites, can't copy
-		Sprite(Sprite&&) = default;
-		Sprite& operator=(Sprite&&) = default;
-		Sprite(Sprite const&) = delete;
-		Sprite& operator= (Sprite const&) = delete;
+//instanced draw of consecutive slots of one page that share a texture
+struct SpriteDraw
+{
+	uint32_t page;
+	uint32_t textureSet;
+	uint32_t firstSlot;	//first instance, indexes the page's mvps
+	uint32_t count;
+
+	bool operator==(SpriteDraw const& other) const noexcept
+	{
+		return page == other.page && textureSet == other.textureSet && firstSlot == other.firstSlot && count == other.count;
+	}
+	bool operator!=(SpriteDraw const& other) const noexcept { return !(*this == other); }
+};
 
-		//create sprite on the gpu
-		void instantiate(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
-			VulkanResources* vk, vk::Sampler sampler, Texture* texture, GraphicsComponent* object);
-		//free resources
-		void destroy(VulkanResources* vk);
+//draws and descriptor set binds of one frame's sprites, unsorted every sprite took one of each
+struct SpriteDrawStats
+{
+	uint32_t sprites = 0;
+	uint32_t draws = 0;
+	uint32_t binds = 0;
 
-		void update(uint32_t imageIndex);
-		void movePosition(float newX, float newY);
+	bool operator==(SpriteDrawStats const& other) const noexcept
+	{
+		return sprites == other.sprites && draws == other.draws && binds == other.binds;
+	}
+	bool operator!=(SpriteDrawStats const& other) const noexcept { return !(*this == other); }
+};
 
-		unsigned char remainingUpdates;	//how many images in swap chain
-		bool isRemoved; //if sprite is marked for deletion
-		std::vector<vk::DescriptorSet> descriptorSets;
-		//pointer to owner object
-		GraphicsComponent* object;
+//z of a layer, the sprite pipeline's depth test keeps higher layers in front
+inline float spriteDepth(SpriteLayers layer) noexcept
+{
+	return toUType(layer) / 10.0f;
+}
 
-	private:
-		std::vector<vk::Buffer> uniformBuffers;
-		std::vector<vk::DeviceMemory> uniformBuffersMemory;
+//blended without depth writes, drawn after the fractal back to front
+inline bool isTransparentLayer(SpriteLayers layer) noexcept
+{
+	return layer == SpriteLayers::eAir || layer == SpriteLayers::eGUI;
+}
 
-		float posX;
-		float posY;
-		SpriteLayers layer;
-		float sizeX;
-		float sizeY;
-		float rotation;
+//mvp storage buffers and descriptor sets for the sprites of a snapshot, only used by the render thread
+//allocated a page at a time as the sprite count grows, startup only pays for the first page
+class SpriteResources
+{
+	//gpu backing of pageSize sprites, one storage buffer with a region and a descriptor set per image
+	class Page
+	{
+	public:
+		explicit Page(VulkanResources* vulkan);
+		~Page();
+
+		Page(Page const&) = delete;
+		Page& operator=(Page const&) = delete;
 
-		void updateUniformBuffers(uint32_t imageIndex);
+		//the image's previous submission has to be done before writing its copy of a sprite
+		void writeMvp(uint32_t slot, uint32_t imageIndex, float const* mvp);
+		vk::DescriptorSet getDescriptorSet(uint32_t imageIndex) const { return descriptorSets[imageIndex]; }
 
-		std::vector<void*> mapped;
-		vk::Sampler textureSampler;
-		Texture* texture;
+	private:
+		VulkanResources* vulkan;
+		vk::Buffer mvpBuffer;							//[image][sprite] mvps
+		vk::DeviceMemory mvpBufferMemory;
+		void* mapped;
+		vk::DescriptorPool descriptorPool;
+		std::vector<vk::DescriptorSet> descriptorSets;	//[image], written once
 	};
 
 public:
-	SpritePool(VulkanResources* vulkan);
-	~SpritePool();
+	static constexpr uint32_t pageSize = 64;
+	static constexpr uint32_t texturePoolSize = 64;	//texture sets per descriptor pool
+	static constexpr uint32_t maxTextureSets = 1 << 14;	//texture bits of the sort key
+
+	explicit SpriteResources(VulkanResources* vulkan);
+	~SpriteResources();
+
+	SpriteResources(SpriteResources const&) = delete;
+	SpriteResources& operator=(SpriteResources const&) = delete;
+
+	//rewrite the mvps of this image for every sprite that changed since the image was last drawn and sort new snapshots
+	//adds pages if the snapshot has more sprites than ever before
+	void update(FrameSnapshot const& frame, uint32_t imageIndex);
 
-	short addSprite(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
-		 vk::Sampler sampler, Texture* texture, GraphicsComponent* object); //return index of sprite in array
-	void removeSprite(unsigned short index);	//marks sprite for deletion
-	void update(uint32_t imageIndex);
+	vk::DescriptorSet getPageDescriptorSet(uint32_t page, uint32_t imageIndex) const { return pages[page]->getDescriptorSet(imageIndex); }
+	vk::DescriptorSet getTextureDescriptorSet(uint32_t textureSet) const { return textureSets[textureSet]; }
+	//draws of the last sorted snapshot, in the order they have to be recorded
+	std::vector<SpriteDraw> const& getDraws(SpriteLayers layer) const { return layerDraws[toUType(layer)]; }
+	SpriteDrawStats const& getStats() const noexcept { return stats; }
 
-	unsigned short size() const { return spriteCount; }
-	auto& getSprites() { return sprites; }
 private:
-	void deleteSprite(unsigned short index);	//frees the sprites resources
-	void clear();								//immediately destroys all sprites
+	//radix sort the sprites by layer, depth and texture and merge runs into instanced draws
+	void sort(SpriteArrays const& sprites);
+	//texture set showing texture through sampler, allocated on first use and never rewritten
+	uint32_t getTextureSet(Texture* texture, vk::Sampler sampler);
 
 	VulkanResources* vulkan;
-	short spriteCount;
-	std::array<Sprite, Settings::MAX_SPRITES> sprites;
-	std::array<unsigned char, Settings::MAX_SPRITES> frameCounts; //counts frames since sprite was removed
-};
\ No newline at end of file
+	std::vector<std::unique_ptr<Page>> pages;
+	uint64_t seenSequence;			//last snapshot passed to changes and sorted
+	SpriteChanges changes;
+	SpriteBatch batch;
+
+	std::map<std::pair<Texture*, VkSampler>, uint32_t> textureSetIds;
+	std::vector<vk::DescriptorSet> textureSets;
+	std::vector<vk::DescriptorPool> texturePools;	//last one has room if textureSets isn't a multiple of texturePoolSize
+
+	std::vector<uint64_t> sortKeys;			//layer, depth and texture above the sprite index
+	std::vector<uint64_t> sortScratch;
+	std::vector<uint32_t> spriteTextureSets;	//texture set of every sprite of the sorted snapshot
+	std::array<std::vector<SpriteDraw>, toUType(SpriteLayers::eGUI) + 1> layerDraws;
+	SpriteDrawStats stats;
+};
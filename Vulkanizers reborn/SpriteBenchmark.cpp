@@ -0,0 +1,109 @@
+#include "SpriteBenchmark.h"
+#include "VulkanResources.h"
+#include <random>
+#include <iomanip>
+
+namespace
+{
+	constexpr uint32_t spriteCount = 100000;
+	constexpr uint32_t imageCount = 3;
+	constexpr int measuredFrames = 100;
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//what every changed sprite went through before the batch, one glm transform chain per sprite
+	void computeMvpsPerSprite(SpriteArrays const& sprites, std::vector<uint32_t> const& indices, std::vector<float>& mvps)
+	{
+		mvps.resize(indices.size() * 16);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			uint32_t sprite = indices[i];
+			glm::mat4 model = glm::mat4(1.0f);
+			model = glm::translate(model, glm::vec3(sprites.posX[sprite], sprites.posY[sprite], spriteDepth(sprites.layers[sprite])));
+			model = glm::rotate(model, sprites.rotation[sprite], glm::vec3(0.0f, 0.0f, 1.0f));
+			model = glm::scale(model, glm::vec3(sprites.sizeX[sprite], sprites.sizeY[sprite], 1.0f));
+			glm::mat4 mvp = glm::ortho(-1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f) * model;
+			memcpy(&mvps[i * 16], &mvp, sizeof(mvp));
+		}
+	}
+}
+
+void benchmarkSpriteUpdate()
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+
+	SpriteArrays sprites;
+	for (uint32_t i = 0; i < spriteCount; i++)
+	{
+		sprites.push_back(position(random), position(random), static_cast<SpriteLayers>(i % (toUType(SpriteLayers::eGUI) + 1)),
+			0.05f, 0.05f, position(random) * pi, vk::Sampler(), nullptr, i + 1);
+	}
+	uint32_t nextVersion = spriteCount + 1;
+
+	//stands in for the mapped uniform buffers
+	std::vector<float> mapped((size_t)spriteCount * imageCount * 16);
+
+	std::cout << "sprite update benchmark, " << spriteCount << " sprites, " << imageCount << " images, average ms per frame\n";
+	std::cout << "moved\tsnapshot\tscan\tbatch mvps\tper sprite mvps\tspeedup\n";
+
+	for (uint32_t moved : { 10u, 100u, 1000u, 10000u, spriteCount })
+	{
+		FrameSnapshot frame;
+		SpriteChanges changes(imageCount);
+		SpriteBatch batch;
+		std::vector<float> perSpriteMvps;
+		//every sprite starts dirty, settle that before measuring
+		frame.sprites = sprites;
+		changes.markChanged(frame.sprites);
+		for (uint32_t image = 0; image < imageCount; image++)
+		{
+			changes.collect(image, spriteCount, batch.indices);
+		}
+
+		double snapshotTime = 0.0;
+		double scanTime = 0.0;
+		double batchTime = 0.0;
+		double perSpriteTime = 0.0;
+		uint32_t stride = spriteCount / moved;
+		for (int frameIndex = 0; frameIndex < measuredFrames; frameIndex++)
+		{
+			for (uint32_t i = 0; i < moved; i++)
+			{
+				uint32_t sprite = (i * stride + frameIndex) % spriteCount;
+				sprites.posX[sprite] = position(random);
+				sprites.posY[sprite] = position(random);
+				sprites.versions[sprite] = nextVersion++;
+			}
+			uint32_t imageIndex = frameIndex % imageCount;
+
+			auto start = std::chrono::steady_clock::now();
+			frame.sprites = sprites;
+			snapshotTime += millisecondsSince(start);
+
+			start = std::chrono::steady_clock::now();
+			changes.markChanged(frame.sprites);
+			changes.collect(imageIndex, spriteCount, batch.indices);
+			scanTime += millisecondsSince(start);
+
+			start = std::chrono::steady_clock::now();
+			batch.computeMvps(frame.sprites);
+			for (size_t i = 0; i < batch.indices.size(); i++)
+			{
+				memcpy(&mapped[((size_t)batch.indices[i] * imageCount + imageIndex) * 16], &batch.mvps[i * 16], 16 * sizeof(float));
+			}
+			batchTime += millisecondsSince(start);
+
+			start = std::chrono::steady_clock::now();
+			computeMvpsPerSprite(frame.sprites, batch.indices, perSpriteMvps);
+			perSpriteTime += millisecondsSince(start);
+		}
+
+		std::cout << moved << "\t" << std::fixed << std::setprecision(4) << snapshotTime / measuredFrames << "\t\t"
+			<< scanTime / measuredFrames << "\t" << batchTime / measuredFrames << "\t\t" << perSpriteTime / measuredFrames << "\t\t"
+			<< std::setprecision(2) << perSpriteTime / batchTime << "x" << std::defaultfloat << "\n";
+	}
+}
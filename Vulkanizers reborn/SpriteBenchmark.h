@@ -0,0 +1,5 @@
+#pragma once
+
+//times the per-frame sprite work of the render thread with many sprites on the cpu, needs no window or device
+//run with --sprite-benchmark
+void benchmarkSpriteUpdate();
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+//fixed capacity ring between one producer thread and one consumer thread, neither side ever waits
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
+public:
+	SpscQueue() = default;
+
+	SpscQueue(SpscQueue const&) = delete;
+	SpscQueue& operator=(SpscQueue const&) = delete;
+
+	//producer side, false if the queue is full
+	bool push(T const& value) noexcept
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead - tail.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+		items[currentHead & (Capacity - 1)] = value;
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	//consumer side, false if the queue is empty
+	bool pop(T& value) noexcept
+	{
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail == head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		value = items[currentTail & (Capacity - 1)];
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::array<T, Capacity> items;
+	alignas(64) std::atomic<size_t> head{ 0 };	//next slot to write, only stored by the producer
+	alignas(64) std::atomic<size_t> tail{ 0 };	//next slot to read, only stored by the consumer
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+//one writer thread and one reader thread share the newest value without locks
+//the writer never waits for the reader, the reader skips values it was too slow to see
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(TripleBuffer const&) = delete;
+	TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+	//writer side, fill this one completely and publish it
+	T& writeBuffer() noexcept { return buffers[writeIndex]; }
+	//hand the written buffer to the reader, the writer gets the spare one back
+	void publish() noexcept
+	{
+		writeIndex = spare.exchange(writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+	}
+
+	//reader side, swap in the newest published buffer, false if nothing was published since the last call
+	bool update() noexcept
+	{
+		if (!(spare.load(std::memory_order_relaxed) & freshBit))
+		{
+			return false;
+		}
+		readIndex = spare.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+	T const& readBuffer() const noexcept { return buffers[readIndex]; }
+
+private:
+	static constexpr uint8_t indexMask = 0x3;
+	static constexpr uint8_t freshBit = 0x4;	//spare holds a buffer the reader hasn't seen
+
+	std::array<T, 3> buffers;
+	std::atomic<uint8_t> spare{ 1 };
+	uint8_t writeIndex = 0;		//only touched by the writer
+	uint8_t readIndex = 2;		//only touched by the reader
+};
@@ -4,6 +4,7 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "VulkanResources.h"
 #include "Game.h"
+#include "Log.h"
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
 
@@ -20,12 +21,15 @@ QueueFamilyIndices		findQueueFamilies(vk::PhysicalDevice device, vk::SurfaceKHR
 bool					checkDeviceExtensionSupport(vk::PhysicalDevice device);
 SwapChainSupportDetails querySwapChainSupport(vk::PhysicalDevice device, vk::SurfaceKHR surface);
 vk::SurfaceFormatKHR	chooseSwapSurfaceFormat(std::vector<vk::SurfaceFormatKHR> const& availableFormats);
-vk::PresentModeKHR		chooseSwapPresentMode(std::vector<vk::PresentModeKHR> const& availablePresentModes);
-vk::Extent2D			chooseSwapExtent(vk::SurfaceCapabilitiesKHR const& capabilities, GLFWwindow* window);
+vk::PresentModeKHR		chooseSwapPresentMode(std::vector<vk::PresentModeKHR> const& availablePresentModes, vk::PresentModeKHR preferred);
+vk::Extent2D			chooseSwapExtent(vk::SurfaceCapabilitiesKHR const& capabilities, vk::Extent2D framebufferSize);
 vk::Format				findDepthFormat(vk::PhysicalDevice physicalDevice);
 vk::Format				findSupportedFormat(std::vector<vk::Format> const& candidates, vk::ImageTiling tiling,
 	vk::FormatFeatureFlags features, vk::PhysicalDevice physicalDevice);
 vk::SampleCountFlagBits getMaxUsableSampleCount(vk::PhysicalDevice physicalDevice);
+DeviceCapabilities		queryDeviceCapabilities(vk::PhysicalDevice device);
+uint64_t				scoreDevice(DeviceCapabilities const& capabilities);
+void					reportDeviceCapabilities(vk::PhysicalDeviceProperties const& properties, DeviceCapabilities const& capabilities);
 vk::ShaderModule		createShaderModule(std::vector<char> const& code, vk::Device device);
 uint32_t				findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties, vk::PhysicalDevice physicalDevice);
 vk::CommandBuffer		beginSingleTimeCommands(vk::Device device, vk::CommandPool commandPool);
@@ -61,56 +65,84 @@ VulkanResources::VulkanResources(Game* game)
 
 VulkanResources::~VulkanResources()
 {
+	//only still running if something else threw first, that error is the one main reports
+	try
+	{
+		stopRendering();
+	}
+	catch (...)
+	{
+
+	}
+	//nothing is in flight anymore, every pipeline that was built can go
+	shaderReloader->stop();
+	FractalPipelines pipelines;
+	if (shaderReloader->takeReady(pipelines))
+	{
+		destroyFractalPipelines(pipelines);
+	}
+	for (auto const& retired : retiredPipelines)
+	{
+		destroyFractalPipelines(retired.pipelines);
+	}
+	retiredPipelines.clear();
 	cleanupSwapChain();
-	std::cout << "finished cleaning up swapchain\n";
+	LOG_DEBUG("finished cleaning up swapchain");
+
+	device.destroyBuffer(cacheCells);
+	device.freeMemory(cacheCellsMemory);
+	device.destroyBuffer(cacheBricks);
+	device.freeMemory(cacheBricksMemory);
+	device.unmapMemory(cacheStateMemory);
+	device.destroyBuffer(cacheState);
+	device.freeMemory(cacheStateMemory);
+	LOG_DEBUG("destroyed distance cache buffers and freed memory");
 
 	device.destroySampler(textureSampler);
-	std::cout << "destroyed texture sampler\n";
+	LOG_DEBUG("destroyed texture sampler");
 
 	device.destroyBuffer(indexBuffer);
 	device.freeMemory(indexBufferMemory);
-	std::cout << "destroyed index buffer and freed memory\n";
+	LOG_DEBUG("destroyed index buffer and freed memory");
 
 	device.destroyBuffer(vertexBuffer);
 	device.freeMemory(vertexBufferMemory);
-	std::cout << "destroyed vertex buffer and freed memory\n";
+	LOG_DEBUG("destroyed vertex buffer and freed memory");
+
+	destroySyncObjects();
 
-	for (size_t i = 0; i < Settings::MAX_FRAMES_IN_FLIGHT; i++)
+	recordJobs.reset(nullptr);
+	for (auto pool : recordPools)
 	{
-		device.destroySemaphore(renderFinishedSemaphores[i]);
-		device.destroySemaphore(imageAvailableSemaphores[i]);
-		device.destroyFence(inFlightFences[i]);
+		device.destroyCommandPool(pool);
 	}
-	std::cout << "destroyed " << Settings::MAX_FRAMES_IN_FLIGHT << " image available semaphores, render finished semaphores and in flight fences\n";
+	LOG_DEBUG("destroyed {} secondary command pools", recordPools.size());
 
 	device.destroyCommandPool(commandPool, nullptr);
-	std::cout << "destroyed command pool\n";
+	LOG_DEBUG("destroyed command pool");
 
-	for (auto i = 0; i < textures.size(); i++)
-	{
-		textures[i] = Texture();
-	}
-	std::cout << "cleared texture array\n";
+	textures.clear();
+	LOG_DEBUG("cleared textures");
 
 	device.destroy();
-	std::cout << "destroyed device\n";
+	LOG_DEBUG("destroyed device");
 
-	if (enableValidationLayers)
+	if (Settings::VALIDATION_LAYERS)
 	{
 		instance.destroyDebugUtilsMessengerEXT(debugMessenger, nullptr);
-		std::cout << "destroyed debug messenger\n";
+		LOG_DEBUG("destroyed debug messenger");
 	}
 
 	instance.destroySurfaceKHR(surface);
-	std::cout << "destroyed surface\n";
+	LOG_DEBUG("destroyed surface");
 	instance.destroy();
-	std::cout << "destroyed instance\n";
+	LOG_DEBUG("destroyed instance");
 
 	glfwDestroyWindow(window);
-	std::cout << "destroyed glfw window\n";
+	LOG_DEBUG("destroyed glfw window");
 
 	glfwTerminate();
-	std::cout << "terminated glfw\n";
+	LOG_DEBUG("terminated glfw");
 }
 
 void VulkanResources::initWindow()
@@ -119,6 +151,7 @@ void VulkanResources::initWindow()
 
 	//do not create an opengl context
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	glfwWindowHint(GLFW_VISIBLE, Settings::HIDE_WINDOW ? GLFW_FALSE : GLFW_TRUE);
 
 	window = glfwCreateWindow(Settings::WINDOW_WIDTH, Settings::WINDOW_HEIGHT, "Vulkaners: Rebirth",
 		nullptr, nullptr);
@@ -133,9 +166,16 @@ void VulkanResources::initWindow()
 		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	}
 
-	//sets bool in game that window was resized
+	int width = 0, height = 0;
+	glfwGetFramebufferSize(window, &width, &height);
+	framebufferWidth = (uint32_t)width;
+	framebufferHeight = (uint32_t)height;
+
+	//tells the render thread that the window was resized
 	glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
 	glfwSetScrollCallback(window, mouseWheelMoveCallback);
+	glfwSetKeyCallback(window, keyCallback);
+	glfwSetMouseButtonCallback(window, mouseButtonCallback);
 }
 
 //loader for vulkan functions
@@ -161,25 +201,29 @@ void VulkanResources::initVulkan()
 	createImageViews();
 	createRenderPass();
 	createGraphicsPipelines();
+	createComputePipelines();
 	createCommandPool();
 	createColorResources();
 	createDepthResources();
 	createFramebuffers();
+	createDistanceCache();
+	createFractalResources();
+	createQueryPool();
 	createTextures();
 	createTextureSampler();
 	loadModel(vertices, indices);
 	createVertexBuffer();
 	createIndexBuffer();
-	createDescriptorPool();
-	spritesToRender = std::make_unique<SpritePool>(this);
+	spritesToRender = std::make_unique<SpritePool>();
+	spriteResources = std::make_unique<SpriteResources>(this);
 	createCommandBuffers();
 	createSyncObjects();
+	shaderReloader = std::make_unique<ShaderReloader>("shaders", [this]() { return buildFractalPipelines(); });
 }
 
 void VulkanResources::createInstance()
 {
-#pragma warning(suppress : 6237)
-	if (enableValidationLayers && !checkValidationLayerSupport())
+	if (Settings::VALIDATION_LAYERS && !checkValidationLayerSupport())
 	{
 		throw std::runtime_error("validation layers requested, but not available");
 	}
@@ -195,7 +239,7 @@ void VulkanResources::createInstance()
 	vk::DebugUtilsMessengerCreateInfoEXT debugCreateInfo;
 
 	//whether or not to create a debug messenger
-	if (enableValidationLayers)
+	if (Settings::VALIDATION_LAYERS)
 	{
 		instanceInfo.enabledLayerCount = (uint32_t)validationLayers.size();
 		instanceInfo.ppEnabledLayerNames = validationLayers.data();
@@ -219,12 +263,12 @@ void VulkanResources::createInstance()
 		throw std::runtime_error("failed to create Vulkan instance");
 	}
 
-	std::cout << "created Vulkan instance\n";
+	LOG_DEBUG("created Vulkan instance");
 }
 
 void VulkanResources::setupDebugMessenger()
 {
-	if (!enableValidationLayers)
+	if (!Settings::VALIDATION_LAYERS)
 	{
 		return;
 	}
@@ -238,7 +282,7 @@ void VulkanResources::setupDebugMessenger()
 		throw std::runtime_error("failed to create debug utils messenger");
 	}
 
-	std::cout << "created debug messenger\n";
+	LOG_DEBUG("created debug messenger");
 }
 
 void VulkanResources::createSurface()
@@ -249,7 +293,7 @@ void VulkanResources::createSurface()
 		throw std::runtime_error("couldn't create window surface");
 	}
 	surface = vk::SurfaceKHR(createdSurface);
-	std::cout << "created window surface\n";
+	LOG_DEBUG("created window surface");
 }
 
 void VulkanResources::pickPhysicalDevice()
@@ -263,30 +307,53 @@ void VulkanResources::pickPhysicalDevice()
 		throw std::runtime_error("Couldn't find GPUs with Vulkan support");
 	}
 
-	std::cout << "devices with vulkan support: \n";
+	LOG_DEBUG("devices with vulkan support: ");
 	for (auto const& device : devices)
 	{
 		vk::PhysicalDeviceProperties deviceProperties = device.getProperties();
-		std::cout << "\t" << deviceProperties.deviceName << "\n";
+		LOG_DEBUG("\t{}", deviceProperties.deviceName);
 	}
 
+	//highest score of the suitable devices wins, not the first one listed
+	uint64_t bestScore = 0;
+	bool skippedSoftware = false;
 	for (auto const& device : devices)
 	{
 		QueueFamilyIndices indices = findQueueFamilies(device, surface);
-		if (isDeviceSuitable(device, surface, indices))
+		if (!isDeviceSuitable(device, surface, indices))
+		{
+			continue;
+		}
+
+		DeviceCapabilities capabilities = queryDeviceCapabilities(device);
+		uint64_t score = scoreDevice(capabilities);
+		LOG_DEBUG("{} scores {}", device.getProperties().deviceName, score);
+		if (score == 0)
+		{
+			skippedSoftware = true;
+		}
+		else if (score > bestScore)
 		{
+			bestScore = score;
 			physicalDevice = device;
 			queueIndices = indices;
-			std::cout << "multisampling is disabled\n";
-			msaaSamples = vk::SampleCountFlagBits::e1;
-			break;
+			deviceCapabilities = capabilities;
 		}
 	}
 
 	if (!physicalDevice)
 	{
-		throw std::runtime_error("failed to find a suitable GPU");
+		throw std::runtime_error(skippedSoftware ? "failed to find a suitable GPU, set ALLOW_SOFTWARE_DEVICE to use a software device" :
+			"failed to find a suitable GPU");
 	}
+
+	vk::PhysicalDeviceProperties deviceProperties = physicalDevice.getProperties();
+	LOG_INFO("{} was picked as the GPU", deviceProperties.deviceName);
+	reportDeviceCapabilities(deviceProperties, deviceCapabilities);
+
+	//the render pass has no resolve attachment, more samples would need one before presenting
+	LOG_DEBUG("multisampling is disabled");
+	msaaSamples = vk::SampleCountFlagBits::e1;
 }
 
 void VulkanResources::createLogicalDevice()
@@ -311,28 +378,45 @@ void VulkanResources::createLogicalDevice()
 	if (physicalDeviceFeatures.samplerAnisotropy)
 	{
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
-		std::cout << "sampler anisotropy is enabled\n";
+		LOG_DEBUG("sampler anisotropy is enabled");
 	}
 	else
 	{
-		std::cout << "sampler anisotropy is disabled\n";
+		LOG_DEBUG("sampler anisotropy is disabled");
 	}
 
 	if (msaaSamples != vk::SampleCountFlagBits::e1)
 	{
 		deviceFeatures.sampleRateShading = VK_TRUE;
-		std::cout << "sample rate shading is enabled\n";
+		LOG_DEBUG("sample rate shading is enabled");
 	}
 	else
 	{
-		std::cout << "sample rate shading is disabled\n";
+		LOG_DEBUG("sample rate shading is disabled");
 	}
 
+	//fractal fragment shader records hit distances for temporal reprojection, checked when picking physical device
+	deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
+
 	vk::DeviceCreateInfo createInfo({}, (uint32_t)queueCreateInfos.size(), queueCreateInfos.data(),
 		{}, {}, (uint32_t)deviceExtensions.size(), deviceExtensions.data(), &deviceFeatures);
 
+	//frames fall back to fences without timeline semaphores
+	vk::PhysicalDeviceVulkan12Features vulkan12Features;
+	timelineSemaphores = deviceCapabilities.timelineSemaphores;
+	if (timelineSemaphores)
+	{
+		vulkan12Features.timelineSemaphore = VK_TRUE;
+		createInfo.pNext = &vulkan12Features;
+		LOG_INFO("timeline semaphores are enabled");
+	}
+	else
+	{
+		LOG_WARNING("timeline semaphores are disabled, frames are tracked with fences");
+	}
+
 	//add debug info layers (for compatibility)
-	if (enableValidationLayers)
+	if (Settings::VALIDATION_LAYERS)
 	{
 		createInfo.enabledLayerCount = (uint32_t)(validationLayers.size());
 		createInfo.ppEnabledLayerNames = validationLayers.data();
@@ -344,12 +428,12 @@ void VulkanResources::createLogicalDevice()
 
 	device = physicalDevice.createDevice(createInfo, nullptr);
 
-	std::cout << "created logical device\n";
+	LOG_DEBUG("created logical device");
 
 	graphicsQueue = device.getQueue(queueIndices.graphicsFamily.value(), 0);
-	std::cout << "created graphics queue\n";
+	LOG_DEBUG("created graphics queue");
 	presentQueue = device.getQueue(queueIndices.presentFamily.value(), 0);
-	std::cout << "created present queue\n";
+	LOG_DEBUG("created present queue");
 }
 
 void VulkanResources::createSwapChain()
@@ -357,16 +441,16 @@ void VulkanResources::createSwapChain()
 	SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, surface);
 
 	vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-	vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
-	vk::Extent2D extent = chooseSwapExtent(swapChainSupport.capabilities, window);
+	vk::PresentModeKHR chosenPresentMode = chooseSwapPresentMode(swapChainSupport.presentModes, presentMode);
+	vk::Extent2D extent = chooseSwapExtent(swapChainSupport.capabilities, { framebufferWidth, framebufferHeight });
 
 	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
 	if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
 	{
 		imageCount = swapChainSupport.capabilities.maxImageCount;
 	}
-	std::cout << "maximum swap chain images: " << swapChainSupport.capabilities.maxImageCount << "\n";
-	std::cout << "chosen swap chain image count: " << imageCount << "\n";
+	LOG_DEBUG("maximum swap chain images: {}", swapChainSupport.capabilities.maxImageCount);
+	LOG_DEBUG("chosen swap chain image count: {}", imageCount);
 
 	vk::SwapchainCreateInfoKHR createInfo({}, surface, imageCount, surfaceFormat.format,
 		surfaceFormat.colorSpace, extent, 1, vk::ImageUsageFlagBits::eColorAttachment);
@@ -377,31 +461,37 @@ void VulkanResources::createSwapChain()
 		createInfo.imageSharingMode = vk::SharingMode::eConcurrent;
 		createInfo.queueFamilyIndexCount = 2;
 		createInfo.pQueueFamilyIndices = queueFamilyIndices;
-		std::cout << "image sharing mode between queue families is concurrent\n";
+		LOG_DEBUG("image sharing mode between queue families is concurrent");
 	}
 	else
 	{
 		createInfo.imageSharingMode = vk::SharingMode::eExclusive;
 		createInfo.queueFamilyIndexCount = 0;
 		createInfo.pQueueFamilyIndices = nullptr;
-		std::cout << "image sharing mode between queue families is exclusive (graphics and present families are the same)\n";
+		LOG_DEBUG("image sharing mode between queue families is exclusive (graphics and present families are the same)");
 	}
 
 	createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
 	createInfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
-	createInfo.presentMode = presentMode;
+	createInfo.presentMode = chosenPresentMode;
 	createInfo.clipped = VK_TRUE;
 
 	createInfo.oldSwapchain = nullptr;
 
 	swapChain = device.createSwapchainKHR(createInfo, nullptr);
-	std::cout << "created swap chain\n";
+	LOG_DEBUG("created swap chain");
 
 	swapChainImages = device.getSwapchainImagesKHR(swapChain);
-	std::cout << "created " << swapChainImages.size() << " swap chain images\n";
+	LOG_DEBUG("created {} swap chain images", swapChainImages.size());
 
 	swapChainImageFormat = surfaceFormat.format;
 	swapChainExtent = extent;
+	fractalExtent = vk::Extent2D(std::max(1u, (uint32_t)(extent.width * Settings::RESOLUTION_SCALE + 0.5f)),
+		std::max(1u, (uint32_t)(extent.height * Settings::RESOLUTION_SCALE + 0.5f)));
+	if (Settings::RESOLUTION_SCALE != 1.0f)
+	{
+		LOG_INFO("compute fractal paths march {}x{} pixels", fractalExtent.width, fractalExtent.height);
+	}
 }
 
 void VulkanResources::createImageViews()
@@ -412,7 +502,7 @@ void VulkanResources::createImageViews()
 	{
 		swapChainImageViews[i] = createImageView(swapChainImages[i], swapChainImageFormat, vk::ImageAspectFlagBits::eColor, 1);
 	}
-	std::cout << "created " << swapChainImageViews.size() << " swap chain image views\n";
+	LOG_DEBUG("created {} swap chain image views", swapChainImageViews.size());
 }
 
 vk::ImageView VulkanResources::createImageView(vk::Image image, vk::Format format,
@@ -439,16 +529,16 @@ void VulkanResources::createRenderPass()
 	switch (depthFormat)
 	{
 	case vk::Format::eD32Sfloat:
-		std::cout << "render pass depth format is D32Sfloat\n";
+		LOG_DEBUG("render pass depth format is D32Sfloat");
 		break;
 	case vk::Format::eD32SfloatS8Uint:
-		std::cout << "render pass depth format is D32SfloatS8Uint\n";
+		LOG_DEBUG("render pass depth format is D32SfloatS8Uint");
 		break;
 	case vk::Format::eD24UnormS8Uint:
-		std::cout << "render pass depth format is D24UnormS8Uint\n";
+		LOG_DEBUG("render pass depth format is D24UnormS8Uint");
 		break;
 	default:
-		std::cout << "render pass depth format is unknown\n";
+		LOG_WARNING("render pass depth format is unknown");
 		break;
 	}
 	vk::AttachmentDescription depthAttachment({}, depthFormat,
@@ -477,23 +567,19 @@ void VulkanResources::createRenderPass()
 	renderPassInfo.pDependencies = &dependency;
 
 	renderPass = device.createRenderPass(renderPassInfo);
-	std::cout << "created render pass\n";
+	LOG_DEBUG("created render pass");
 }
 
+//mvps of a sprite page, indexed by instance
 [[nodiscard]] vk::DescriptorSetLayout createDescriptorSetLayout(vk::Device device)
 {
-	vk::DescriptorSetLayoutBinding uboLayoutBinding(0, vk::DescriptorType::eUniformBuffer,
+	vk::DescriptorSetLayoutBinding mvpLayoutBinding(0, vk::DescriptorType::eStorageBuffer,
 		1, vk::ShaderStageFlagBits::eVertex, nullptr);
 
-	vk::DescriptorSetLayoutBinding samplerLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler,
-		1, vk::ShaderStageFlagBits::eFragment, nullptr);
-
-	std::array<vk::DescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
-
-	vk::DescriptorSetLayoutCreateInfo layoutInfo({}, bindings);
+	vk::DescriptorSetLayoutCreateInfo layoutInfo({}, mvpLayoutBinding);
 
 	auto result = device.createDescriptorSetLayout(layoutInfo);
-	std::cout << "created descriptor set layout\n";
+	LOG_DEBUG("created descriptor set layout");
 
 	return result;
 }
@@ -535,23 +621,30 @@ void populateGraphicsPipelineCreateData(PipelineCreateData& result, vk::Device d
 void VulkanResources::createGraphicsPipelines()
 {
 	graphicsPipelinesData.clear();
-	graphicsPipelinesData.resize(2);
+	graphicsPipelinesData.resize(3);
 
 	std::vector<vk::GraphicsPipelineCreateInfo> pipelineCreateInfos;
 	std::vector<PipelineCreateData> pipelineCreationData;
-	pipelineCreationData.resize(2);
+	pipelineCreationData.resize(1);
 
 	auto bindingDescription = Vertex::getBindingDescription();
 	auto attributeDescriptions = Vertex::getAttributeDescriptions();
 
 	graphicsPipelinesData[0].descriptorSetLayout = createDescriptorSetLayout(device);
 
+	//sprites bind their page as set 0 and their texture as set 1, so a batch only rebinds what changed
+	vk::DescriptorSetLayoutBinding samplerLayoutBinding(0, vk::DescriptorType::eCombinedImageSampler,
+		1, vk::ShaderStageFlagBits::eFragment, nullptr);
+	spriteTextureSetLayout = device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, samplerLayoutBinding));
+	LOG_DEBUG("created descriptor set layout");
+
 	vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eFragment, 0, 2 * sizeof(float));
 
-	vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, graphicsPipelinesData[0].descriptorSetLayout, nullptr);
+	std::array<vk::DescriptorSetLayout, 2> spriteSetLayouts = { graphicsPipelinesData[0].descriptorSetLayout, spriteTextureSetLayout };
+	vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, spriteSetLayouts, nullptr);
 
 	graphicsPipelinesData[0].layout = device.createPipelineLayout(pipelineLayoutInfo);
-	std::cout << "created pipeline layout\n";
+	LOG_DEBUG("created pipeline layout");
 
 	populateGraphicsPipelineCreateData(pipelineCreationData[0], device, Settings::SPRITE_VERT_SHADER_PATH, Settings::SPRITE_FRAG_SHADER_PATH, bindingDescription, attributeDescriptions,
 		vk::PrimitiveTopology::eTriangleList, swapChainExtent, msaaSamples);
@@ -563,21 +656,54 @@ void VulkanResources::createGraphicsPipelines()
 	pipelineCreateInfos.push_back(pipelineCreateInfo);
 
 
-	graphicsPipelinesData[1].descriptorSetLayout = nullptr;
+	//deep zoom reference orbit, distance cache cells and bricks, the bake's brick counter,
+	//temporal state, history and reprojection; shared with the compute pipeline as its set 1 and with the bake and reproject pipelines
+	std::array<vk::DescriptorSetLayoutBinding, 7> fractalBindings = {};
+	for (uint32_t i = 0; i < fractalBindings.size(); i++)
+	{
+		fractalBindings[i] = vk::DescriptorSetLayoutBinding(i, vk::DescriptorType::eStorageBuffer,
+			1, vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute, nullptr);
+	}
+	fractalBindings[3].stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+	graphicsPipelinesData[1].descriptorSetLayout = device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, fractalBindings));
+	LOG_DEBUG("created descriptor set layout");
 
-	pushConstantRange = vk::PushConstantRange(vk::ShaderStageFlagBits::eFragment, 0, 24 * sizeof(float));
+	pushConstantRange = vk::PushConstantRange(vk::ShaderStageFlagBits::eFragment, 0, sizeof(FractalPushConstants));
 
-	pipelineLayoutInfo = vk::PipelineLayoutCreateInfo({}, nullptr, pushConstantRange);
+	pipelineLayoutInfo = vk::PipelineLayoutCreateInfo({}, graphicsPipelinesData[1].descriptorSetLayout, pushConstantRange);
 
 	graphicsPipelinesData[1].layout = device.createPipelineLayout(pipelineLayoutInfo);
-	std::cout << "created pipeline layout\n";
+	LOG_DEBUG("created pipeline layout");
 
-	populateGraphicsPipelineCreateData(pipelineCreationData[1], device, Settings::FRACTAL_VERT_SHADER_PATH, Settings::FRACTAL_FRAG_SHADER_PATH, nullptr, nullptr,
-		vk::PrimitiveTopology::eTriangleStrip, swapChainExtent, msaaSamples);
+	//built on its own so the shader reloader can build it again
+	graphicsPipelinesData[1].pipeline = createFractalPipeline();
+
+
+	//draws the storage image written by the compute fractal path
+	vk::DescriptorSetLayoutBinding fractalImageBinding(0, vk::DescriptorType::eStorageImage,
+		1, vk::ShaderStageFlagBits::eFragment, nullptr);
 
-	pipelineCreateInfo = vk::GraphicsPipelineCreateInfo({}, pipelineCreationData[1].shaderModules.shaderStages, &pipelineCreationData[1].vertexInputInfo, &pipelineCreationData[1].inputAssembly, nullptr,
-		&pipelineCreationData[1].viewportState, &pipelineCreationData[1].rasterizer, &pipelineCreationData[1].multisampling, &pipelineCreationData[1].depthStencil,
-		&pipelineCreationData[1].colorBlending, nullptr, graphicsPipelinesData[1].layout, renderPass, 0, vk::Pipeline(nullptr), -1);
+	graphicsPipelinesData[2].descriptorSetLayout = device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, fractalImageBinding));
+	LOG_DEBUG("created descriptor set layout");
+
+	//scale from framebuffer pixels to fractal image pixels
+	vk::PushConstantRange compositePushConstantRange(vk::ShaderStageFlagBits::eFragment, 0, sizeof(glm::vec2));
+	pipelineLayoutInfo = vk::PipelineLayoutCreateInfo({}, graphicsPipelinesData[2].descriptorSetLayout, compositePushConstantRange);
+
+	graphicsPipelinesData[2].layout = device.createPipelineLayout(pipelineLayoutInfo);
+	LOG_DEBUG("created pipeline layout");
+
+	//built on its own so the shader reloader can build it again
+	graphicsPipelinesData[2].pipeline = createCompositePipeline();
+
+
+	//transparent sprite layers are drawn back to front after everything else, they don't have to write depth
+	vk::PipelineDepthStencilStateCreateInfo spriteBlendDepthStencil = pipelineCreationData[0].depthStencil;
+	spriteBlendDepthStencil.depthWriteEnable = VK_FALSE;
+
+	pipelineCreateInfo = pipelineCreateInfos[0];
+	pipelineCreateInfo.pDepthStencilState = &spriteBlendDepthStencil;
 
 	pipelineCreateInfos.push_back(pipelineCreateInfo);
 
@@ -586,11 +712,112 @@ void VulkanResources::createGraphicsPipelines()
 	{
 		throw std::runtime_error("error creating pipelines");
 	}
-	for (int i = 0; i < valueResult.value.size(); i++)
+	graphicsPipelinesData[0].pipeline = valueResult.value[0];
+	spriteBlendPipeline = valueResult.value[1];
+	LOG_DEBUG("created graphics pipelines");
+}
+
+vk::Pipeline VulkanResources::createFractalPipeline()
+{
+	PipelineCreateData creationData;
+	populateGraphicsPipelineCreateData(creationData, device, Settings::FRACTAL_VERT_SHADER_PATH, Settings::FRACTAL_FRAG_SHADER_PATH, nullptr, nullptr,
+		vk::PrimitiveTopology::eTriangleStrip, swapChainExtent, msaaSamples);
+
+	vk::GraphicsPipelineCreateInfo pipelineCreateInfo({}, creationData.shaderModules.shaderStages, &creationData.vertexInputInfo, &creationData.inputAssembly, nullptr,
+		&creationData.viewportState, &creationData.rasterizer, &creationData.multisampling, &creationData.depthStencil,
+		&creationData.colorBlending, nullptr, graphicsPipelinesData[1].layout, renderPass, 0, vk::Pipeline(nullptr), -1);
+
+	auto valueResult = device.createGraphicsPipeline(vk::PipelineCache(nullptr), pipelineCreateInfo);
+	if (valueResult.result != vk::Result::eSuccess)
+	{
+		throw std::runtime_error("error creating fractal pipeline");
+	}
+	LOG_DEBUG("created fractal pipeline");
+	return valueResult.value;
+}
+
+vk::Pipeline VulkanResources::createCompositePipeline()
+{
+	PipelineCreateData creationData;
+	populateGraphicsPipelineCreateData(creationData, device, Settings::FRACTAL_VERT_SHADER_PATH, Settings::FRACTAL_COMPOSITE_FRAG_SHADER_PATH, nullptr, nullptr,
+		vk::PrimitiveTopology::eTriangleStrip, swapChainExtent, msaaSamples);
+
+	vk::GraphicsPipelineCreateInfo pipelineCreateInfo({}, creationData.shaderModules.shaderStages, &creationData.vertexInputInfo, &creationData.inputAssembly, nullptr,
+		&creationData.viewportState, &creationData.rasterizer, &creationData.multisampling, &creationData.depthStencil,
+		&creationData.colorBlending, nullptr, graphicsPipelinesData[2].layout, renderPass, 0, vk::Pipeline(nullptr), -1);
+
+	auto valueResult = device.createGraphicsPipeline(vk::PipelineCache(nullptr), pipelineCreateInfo);
+	if (valueResult.result != vk::Result::eSuccess)
+	{
+		throw std::runtime_error("error creating fractal composite pipeline");
+	}
+	LOG_DEBUG("created fractal composite pipeline");
+	return valueResult.value;
+}
+
+void VulkanResources::createComputePipelines()
+{
+	//storage image, input and output ray queues, input and output queue states
+	std::array<vk::DescriptorSetLayoutBinding, 5> bindings = {};
+	bindings[0] = vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eStorageImage,
+		1, vk::ShaderStageFlagBits::eCompute, nullptr);
+	for (uint32_t i = 1; i < bindings.size(); i++)
+	{
+		bindings[i] = vk::DescriptorSetLayoutBinding(i, vk::DescriptorType::eStorageBuffer,
+			1, vk::ShaderStageFlagBits::eCompute, nullptr);
+	}
+
+	computePipelineData.descriptorSetLayout = device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, bindings));
+	LOG_DEBUG("created compute descriptor set layout");
+
+	vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(FractalPushConstants));
+
+	std::array<vk::DescriptorSetLayout, 2> setLayouts = { computePipelineData.descriptorSetLayout, graphicsPipelinesData[1].descriptorSetLayout };
+	vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, setLayouts, pushConstantRange);
+
+	computePipelineData.layout = device.createPipelineLayout(pipelineLayoutInfo);
+	LOG_DEBUG("created compute pipeline layout");
+
+	computePipelineData.pipeline = createComputePipeline(Settings::FRACTAL_COMP_SHADER_PATH, computePipelineData.layout);
+	LOG_DEBUG("created compute pipeline");
+
+	bakePipelineData.descriptorSetLayout = nullptr;
+
+	pipelineLayoutInfo = vk::PipelineLayoutCreateInfo({}, graphicsPipelinesData[1].descriptorSetLayout, pushConstantRange);
+
+	bakePipelineData.layout = device.createPipelineLayout(pipelineLayoutInfo);
+	LOG_DEBUG("created bake pipeline layout");
+
+	bakePipelineData.pipeline = createComputePipeline(Settings::FRACTAL_BAKE_SHADER_PATH, bakePipelineData.layout);
+	LOG_DEBUG("created bake pipeline");
+
+	reprojectPipelineData.descriptorSetLayout = nullptr;
+
+	reprojectPipelineData.layout = device.createPipelineLayout(pipelineLayoutInfo);
+	LOG_DEBUG("created reproject pipeline layout");
+
+	reprojectPipelineData.pipeline = createComputePipeline(Settings::FRACTAL_REPROJECT_SHADER_PATH, reprojectPipelineData.layout);
+	LOG_DEBUG("created reproject pipeline");
+}
+
+vk::Pipeline VulkanResources::createComputePipeline(std::string const& shaderFilename, vk::PipelineLayout layout)
+{
+	vk::ShaderModule shaderModule = createShaderModule(readFile(shaderFilename), device);
+	LOG_DEBUG("created compute shader module");
+
+	vk::PipelineShaderStageCreateInfo shaderStageInfo({}, vk::ShaderStageFlagBits::eCompute, shaderModule, "main");
+	vk::ComputePipelineCreateInfo pipelineCreateInfo({}, shaderStageInfo, layout);
+
+	auto valueResult = device.createComputePipeline(vk::PipelineCache(nullptr), pipelineCreateInfo);
+
+	device.destroyShaderModule(shaderModule);
+	LOG_DEBUG("destroyed compute shader module");
+
+	if (valueResult.result != vk::Result::eSuccess)
 	{
-		graphicsPipelinesData[i].pipeline = valueResult.value[i];
+		throw std::runtime_error("error creating compute pipeline from " + shaderFilename);
 	}
-	std::cout << "created graphics pipelines\n";
+	return valueResult.value;
 }
 
 void VulkanResources::createCommandPool()
@@ -598,7 +825,20 @@ void VulkanResources::createCommandPool()
 	vk::CommandPoolCreateInfo poolInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient,
 		queueIndices.graphicsFamily.value());
 	commandPool = device.createCommandPool(poolInfo);
-	std::cout << "created command pool\n";
+	LOG_DEBUG("created command pool");
+
+	//the render thread and the update thread have their own cores, the passes get the rest
+	unsigned int cores = std::thread::hardware_concurrency();
+	unsigned int jobCount = std::min(renderPassCount, (cores > 3) ? cores - 2 : 1u);
+	recordJobs = std::make_unique<JobSystem>(jobCount);
+
+	//a pool can't be used by two threads at once, each job records from its own
+	vk::CommandPoolCreateInfo recordPoolInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueIndices.graphicsFamily.value());
+	for (unsigned int i = 0; i < jobCount; i++)
+	{
+		recordPools.push_back(device.createCommandPool(recordPoolInfo));
+	}
+	LOG_DEBUG("created {} secondary command pools", recordPools.size());
 }
 
 void VulkanResources::createColorResources()
@@ -610,7 +850,7 @@ void VulkanResources::createColorResources()
 		vk::ImageUsageFlagBits::eColorAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal,
 		colorImage, colorImageMemory);
 	colorImageView = createImageView(colorImage, colorFormat, vk::ImageAspectFlagBits::eColor, 1);
-	std::cout << "created color resources\n";
+	LOG_DEBUG("created color resources");
 }
 
 void VulkanResources::createDepthResources()
@@ -621,11 +861,11 @@ void VulkanResources::createDepthResources()
 		vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment,
 		vk::MemoryPropertyFlagBits::eDeviceLocal, depthImage, depthImageMemory);
 	depthImageView = createImageView(depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth, 1);
-	std::cout << "created depth resources\n";
+	LOG_DEBUG("created depth resources");
 
 	transitionImageLayout(depthImage, depthFormat, vk::ImageLayout::eUndefined,
 		vk::ImageLayout::eDepthStencilAttachmentOptimal, 1);
-	std::cout << "transitioned depth image layout from \"undefined\" to \"depth stencil attachment optimal\"\n";
+	LOG_DEBUG("transitioned depth image layout from \"undefined\" to \"depth stencil attachment optimal\"");
 }
 
 void VulkanResources::createFramebuffers()
@@ -644,29 +884,200 @@ void VulkanResources::createFramebuffers()
 		swapChainFramebuffers[i] = device.createFramebuffer(framebufferInfo);
 	}
 
-	std::cout << "created " << swapChainImageViews.size() << " framebuffers\n";
+	LOG_DEBUG("created {} framebuffers", swapChainImageViews.size());
+}
+
+void VulkanResources::createDistanceCache()
+{
+	vk::DeviceSize cellCount = (vk::DeviceSize)Settings::FRACTAL_CACHE_GRID * Settings::FRACTAL_CACHE_GRID * Settings::FRACTAL_CACHE_GRID;
+	vk::DeviceSize brickSize = (vk::DeviceSize)Settings::FRACTAL_CACHE_BRICK * Settings::FRACTAL_CACHE_BRICK * Settings::FRACTAL_CACHE_BRICK * sizeof(float);
+
+	//distance and brick index of every cell
+	createBuffer(cellCount * 2 * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer,
+		vk::MemoryPropertyFlagBits::eDeviceLocal, cacheCells, cacheCellsMemory);
+	createBuffer(Settings::FRACTAL_CACHE_MAX_BRICKS * brickSize, vk::BufferUsageFlagBits::eStorageBuffer,
+		vk::MemoryPropertyFlagBits::eDeviceLocal, cacheBricks, cacheBricksMemory);
+	createBuffer(4 * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, cacheState, cacheStateMemory);
+	cacheStateMapped = device.mapMemory(cacheStateMemory, 0, 4 * sizeof(uint32_t));
+	LOG_DEBUG("created distance cache buffers");
+}
+
+void VulkanResources::createFractalResources()
+{
+	createImage(fractalExtent.width, fractalExtent.height, 1, vk::SampleCountFlagBits::e1,
+		vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eDeviceLocal, fractalImage, fractalImageMemory);
+	fractalImageView = createImageView(fractalImage, vk::Format::eR8G8B8A8Unorm, vk::ImageAspectFlagBits::eColor, 1);
+	//compute writes and composite reads it in general layout, it never changes after this
+	transitionImageLayout(fractalImage, vk::Format::eR8G8B8A8Unorm, vk::ImageLayout::eUndefined,
+		vk::ImageLayout::eGeneral, 1);
+	//reduced shading reconstructs from its old contents, which a new image doesn't have
+	shadingHistoryValid = false;
+	LOG_DEBUG("created fractal storage image");
+
+	vk::DeviceSize captureSize = (vk::DeviceSize)fractalExtent.width * fractalExtent.height * 4;
+	createBuffer(captureSize, vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, captureBuffer, captureBufferMemory);
+	captureBufferMapped = device.mapMemory(captureBufferMemory, 0, captureSize);
+	LOG_DEBUG("created fractal capture buffer");
+
+	//pixel index, total distance, steps and carried steps of every ray that survives a pass
+	vk::DeviceSize rayQueueSize = (vk::DeviceSize)fractalExtent.width * fractalExtent.height * 4 * sizeof(uint32_t);
+	for (size_t i = 0; i < rayQueues.size(); i++)
+	{
+		createBuffer(rayQueueSize, vk::BufferUsageFlagBits::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eDeviceLocal, rayQueues[i], rayQueuesMemory[i]);
+		createBuffer(4 * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+			vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, rayQueueStates[i], rayQueueStatesMemory[i]);
+	}
+	LOG_DEBUG("created {} ray queues", rayQueues.size());
+
+	//written by the cpu every frame, so every image in flight gets its own
+	orbitBuffers.resize(swapChainImages.size());
+	orbitBuffersMemory.resize(swapChainImages.size());
+	orbitBuffersMapped.resize(swapChainImages.size());
+	for (size_t i = 0; i < orbitBuffers.size(); i++)
+	{
+		createBuffer(ReferenceOrbit::bufferSize, vk::BufferUsageFlagBits::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, orbitBuffers[i], orbitBuffersMemory[i]);
+		orbitBuffersMapped[i] = device.mapMemory(orbitBuffersMemory[i], 0, ReferenceOrbit::bufferSize);
+		referenceOrbit.clear();
+		referenceOrbit.copyTo(orbitBuffersMapped[i]);
+	}
+	LOG_DEBUG("created {} reference orbit buffers", orbitBuffers.size());
+
+	frameStateBuffers.resize(swapChainImages.size());
+	frameStateBuffersMemory.resize(swapChainImages.size());
+	frameStateBuffersMapped.resize(swapChainImages.size());
+	for (size_t i = 0; i < frameStateBuffers.size(); i++)
+	{
+		createBuffer(sizeof(FrameState), vk::BufferUsageFlagBits::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, frameStateBuffers[i], frameStateBuffersMemory[i]);
+		frameStateBuffersMapped[i] = device.mapMemory(frameStateBuffersMemory[i], 0, sizeof(FrameState));
+	}
+	LOG_DEBUG("created {} frame state buffers", frameStateBuffers.size());
+
+	//the fragment path's extent, the compute paths use less of it
+	vk::DeviceSize pixelCount = (vk::DeviceSize)swapChainExtent.width * swapChainExtent.height;
+	createBuffer(2 * pixelCount * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer,
+		vk::MemoryPropertyFlagBits::eDeviceLocal, temporalHistory, temporalHistoryMemory);
+	createBuffer(pixelCount * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eDeviceLocal, temporalReprojection, temporalReprojectionMemory);
+	//new buffers hold garbage, the first frame only records
+	historyValid = false;
+	LOG_DEBUG("created temporal reprojection buffers");
+
+	uint32_t setCount = (uint32_t)(fractalComputeSets.size() + 1 + orbitBuffers.size());
+	std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, (uint32_t)fractalComputeSets.size() + 1),
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, (uint32_t)(fractalComputeSets.size() * 4 + orbitBuffers.size() * 7))
+	};
+	vk::DescriptorPoolCreateInfo poolInfo({}, setCount, (uint32_t)poolSizes.size(), poolSizes.data());
+
+	fractalDescriptorPool = device.createDescriptorPool(poolInfo);
+	LOG_DEBUG("created fractal descriptor pool");
+
+	std::vector<vk::DescriptorSetLayout> layouts(fractalComputeSets.size(), computePipelineData.descriptorSetLayout);
+	vk::DescriptorSetAllocateInfo allocInfo(fractalDescriptorPool, (uint32_t)layouts.size(), layouts.data());
+	auto computeSets = device.allocateDescriptorSets(allocInfo);
+	std::copy(computeSets.begin(), computeSets.end(), fractalComputeSets.begin());
+
+	allocInfo = vk::DescriptorSetAllocateInfo(fractalDescriptorPool, 1, &graphicsPipelinesData[2].descriptorSetLayout);
+	fractalCompositeSet = device.allocateDescriptorSets(allocInfo)[0];
+
+	layouts.assign(orbitBuffers.size(), graphicsPipelinesData[1].descriptorSetLayout);
+	allocInfo = vk::DescriptorSetAllocateInfo(fractalDescriptorPool, (uint32_t)layouts.size(), layouts.data());
+	fractalSets = device.allocateDescriptorSets(allocInfo);
+	for (size_t i = 0; i < fractalSets.size(); i++)
+	{
+		std::array<vk::DescriptorBufferInfo, 7> bufferInfos = {
+			vk::DescriptorBufferInfo(orbitBuffers[i], 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(cacheCells, 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(cacheBricks, 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(cacheState, 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(frameStateBuffers[i], 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(temporalHistory, 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(temporalReprojection, 0, VK_WHOLE_SIZE)
+		};
+
+		std::array<vk::WriteDescriptorSet, 7> descriptorWrites = {};
+		for (uint32_t j = 0; j < bufferInfos.size(); j++)
+		{
+			descriptorWrites[j] = vk::WriteDescriptorSet(fractalSets[i], j, 0, 1,
+				vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfos[j], nullptr);
+		}
+
+		device.updateDescriptorSets(descriptorWrites, nullptr);
+	}
+
+	vk::DescriptorImageInfo imageInfo(nullptr, fractalImageView, vk::ImageLayout::eGeneral);
+	for (size_t i = 0; i < fractalComputeSets.size(); i++)
+	{
+		std::array<vk::DescriptorBufferInfo, 4> bufferInfos = {
+			vk::DescriptorBufferInfo(rayQueues[i], 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(rayQueues[1 - i], 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(rayQueueStates[i], 0, VK_WHOLE_SIZE),
+			vk::DescriptorBufferInfo(rayQueueStates[1 - i], 0, VK_WHOLE_SIZE)
+		};
+
+		std::array<vk::WriteDescriptorSet, 5> descriptorWrites = {};
+		descriptorWrites[0] = vk::WriteDescriptorSet(fractalComputeSets[i], 0, 0, 1,
+			vk::DescriptorType::eStorageImage, &imageInfo, nullptr, nullptr);
+		for (uint32_t j = 0; j < bufferInfos.size(); j++)
+		{
+			descriptorWrites[j + 1] = vk::WriteDescriptorSet(fractalComputeSets[i], j + 1, 0, 1,
+				vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfos[j], nullptr);
+		}
+
+		device.updateDescriptorSets(descriptorWrites, nullptr);
+	}
+
+	vk::WriteDescriptorSet compositeWrite(fractalCompositeSet, 0, 0, 1,
+		vk::DescriptorType::eStorageImage, &imageInfo, nullptr, nullptr);
+	device.updateDescriptorSets(compositeWrite, nullptr);
+	LOG_DEBUG("allocated and updated {} fractal descriptor sets", setCount);
+}
+
+void VulkanResources::createQueryPool()
+{
+	auto queueFamilies = physicalDevice.getQueueFamilyProperties();
+	if (queueFamilies[queueIndices.graphicsFamily.value()].timestampValidBits == 0)
+	{
+		timestampPeriod = 0.0f;
+		fractalTime = -1.0f;
+		LOG_WARNING("graphics queue doesn't support timestamps, fractal time isn't measured");
+		return;
+	}
+	timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+
+	//start and end of the fractal work for every swap chain image
+	vk::QueryPoolCreateInfo poolInfo({}, vk::QueryType::eTimestamp, 2 * (uint32_t)swapChainImages.size());
+	queryPool = device.createQueryPool(poolInfo);
+	LOG_DEBUG("created timestamp query pool");
 }
 
 void VulkanResources::createTextures()
 {
-	textures[0] = Texture("textures/chess.png", this);
-	textures[1] = Texture("textures/white pawn.png", this);
-	textures[2] = Texture("textures/black pawn.png", this);
-	textures[3] = Texture("textures/white rook.png", this);
-	textures[4] = Texture("textures/black rook.png", this);
-	textures[5] = Texture("textures/white knight.png", this);
-	textures[6] = Texture("textures/black knight.png", this);
-	textures[7] = Texture("textures/white bishop.png", this);
-	textures[8] = Texture("textures/black bishop.png", this);
-	textures[9] = Texture("textures/white queen.png", this);
-	textures[10] = Texture("textures/black queen.png", this);
-	textures[11] = Texture("textures/white king.png", this);
-	textures[12] = Texture("textures/black king.png", this);
-	textures[13] = Texture("textures/cursor.png", this);
-	textures[14] = Texture("textures/outline_blue.png", this);
-	textures[15] = Texture("textures/outline_green.png", this);
-	textures[16] = Texture("textures/highlight_green.png", this);
-	textures[17] = Texture("textures/highlight_red.png", this);
+	//cursor and board refer to textures by index, keep the order
+	textures.emplace_back("textures/chess.png", this);
+	textures.emplace_back("textures/white pawn.png", this);
+	textures.emplace_back("textures/black pawn.png", this);
+	textures.emplace_back("textures/white rook.png", this);
+	textures.emplace_back("textures/black rook.png", this);
+	textures.emplace_back("textures/white knight.png", this);
+	textures.emplace_back("textures/black knight.png", this);
+	textures.emplace_back("textures/white bishop.png", this);
+	textures.emplace_back("textures/black bishop.png", this);
+	textures.emplace_back("textures/white queen.png", this);
+	textures.emplace_back("textures/black queen.png", this);
+	textures.emplace_back("textures/white king.png", this);
+	textures.emplace_back("textures/black king.png", this);
+	textures.emplace_back("textures/cursor.png", this);
+	textures.emplace_back("textures/outline_blue.png", this);
+	textures.emplace_back("textures/outline_green.png", this);
+	textures.emplace_back("textures/highlight_green.png", this);
+	textures.emplace_back("textures/highlight_red.png", this);
 }
 
 void VulkanResources::createTextureSampler()
@@ -677,7 +1088,7 @@ void VulkanResources::createTextureSampler()
 		0.0f, 1.0f, vk::BorderColor::eFloatTransparentBlack, VK_FALSE);
 
 	textureSampler = device.createSampler(samplerInfo);
-	std::cout << "created texture sampler\n";
+	LOG_DEBUG("created texture sampler");
 }
 
 void VulkanResources::createVertexBuffer()
@@ -689,24 +1100,24 @@ void VulkanResources::createVertexBuffer()
 	createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc,
 		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
 		stagingBuffer, stagingBufferMemory);
-	std::cout << "created staging buffer for vertex data\n";
+	LOG_DEBUG("created staging buffer for vertex data");
 
 	void* data;
 	data = device.mapMemory(stagingBufferMemory, 0, bufferSize, {});
 	memcpy(data, vertices.data(), (size_t)bufferSize);
 	device.unmapMemory(stagingBufferMemory);
-	std::cout << "copied vertex data to staging buffer\n";
+	LOG_DEBUG("copied vertex data to staging buffer");
 
 	createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
 		vk::MemoryPropertyFlagBits::eDeviceLocal, vertexBuffer, vertexBufferMemory);
-	std::cout << "created vertex buffer\n";
+	LOG_DEBUG("created vertex buffer");
 
 	copyBuffer(stagingBuffer, vertexBuffer, bufferSize, device, commandPool, graphicsQueue);
-	std::cout << "copied data from staging buffer to vertex buffer\n";
+	LOG_DEBUG("copied data from staging buffer to vertex buffer");
 
 	device.destroyBuffer(stagingBuffer);
 	device.freeMemory(stagingBufferMemory);
-	std::cout << "destroyed staging buffer and freed memory\n";
+	LOG_DEBUG("destroyed staging buffer and freed memory");
 }
 
 void VulkanResources::createIndexBuffer()
@@ -718,37 +1129,24 @@ void VulkanResources::createIndexBuffer()
 	createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc,
 		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
 		stagingBuffer, stagingBufferMemory);
-	std::cout << "created staging buffer for index data\n";
+	LOG_DEBUG("created staging buffer for index data");
 
 	void* data;
 	data = device.mapMemory(stagingBufferMemory, 0, bufferSize, {});
 	memcpy(data, indices.data(), (size_t)bufferSize);
 	device.unmapMemory(stagingBufferMemory);
-	std::cout << "copied index data to staging buffer\n";
+	LOG_DEBUG("copied index data to staging buffer");
 
 	createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
 		vk::MemoryPropertyFlagBits::eDeviceLocal, indexBuffer, indexBufferMemory);
-	std::cout << "created index buffer\n";
+	LOG_DEBUG("created index buffer");
 
 	copyBuffer(stagingBuffer, indexBuffer, bufferSize, device, commandPool, graphicsQueue);
-	std::cout << "copied data from staging buffer to index buffer\n";
+	LOG_DEBUG("copied data from staging buffer to index buffer");
 
 	device.destroyBuffer(stagingBuffer);
 	device.freeMemory(stagingBufferMemory);
-	std::cout << "destroyed staging buffer and freed memory\n";
-}
-
-void VulkanResources::createDescriptorPool()
-{
-	std::array<vk::DescriptorPoolSize, 2> poolSizes = {};
-	poolSizes[0].descriptorCount = (uint32_t)swapChainImages.size() * 512;
-	poolSizes[1].descriptorCount = (uint32_t)swapChainImages.size() * 512;
-
-	vk::DescriptorPoolCreateInfo poolInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
-		(uint32_t)swapChainImages.size() * 512, (uint32_t)poolSizes.size(), poolSizes.data());
-
-	descriptorPool = device.createDescriptorPool(poolInfo);
-	std::cout << "created descriptor pool\n";
+	LOG_DEBUG("destroyed staging buffer and freed memory");
 }
 
 
@@ -760,192 +1158,710 @@ void VulkanResources::createCommandBuffers()
 		(uint32_t)commandBuffers.size());
 
 	commandBuffers = device.allocateCommandBuffers(allocInfo);
-	std::cout << "allocated " << commandBuffers.size() << " command buffers\n";
+	LOG_DEBUG("allocated {} command buffers", commandBuffers.size());
 
-	for (uint32_t i = 0; i < commandBuffers.size(); i++)
+	//pipelines, framebuffers and descriptor sets are new, nothing recorded before can be reused
+	secondaryCommandBuffers.resize(commandBuffers.size());
+	recordedPasses.assign(commandBuffers.size(), {});
+	for (uint32_t pass = 0; pass < renderPassCount; pass++)
 	{
-		updateCommandBuffer(i);
+		vk::CommandBufferAllocateInfo secondaryInfo(recordPools[pass % recordPools.size()], vk::CommandBufferLevel::eSecondary,
+			(uint32_t)commandBuffers.size());
+		std::vector<vk::CommandBuffer> passBuffers = device.allocateCommandBuffers(secondaryInfo);
+		for (size_t i = 0; i < passBuffers.size(); i++)
+		{
+			secondaryCommandBuffers[i][pass] = passBuffers[i];
+		}
 	}
-	std::cout << "recorded " << commandBuffers.size() << " command buffers\n";
+	LOG_DEBUG("allocated {} secondary command buffers", commandBuffers.size() * renderPassCount);
+	//recorded every frame by drawFrame
 }
 
 void VulkanResources::createSyncObjects()
 {
-	imageAvailableSemaphores.resize(Settings::MAX_FRAMES_IN_FLIGHT);
-	renderFinishedSemaphores.resize(Settings::MAX_FRAMES_IN_FLIGHT);
-	inFlightFences.resize(Settings::MAX_FRAMES_IN_FLIGHT);
-	imagesInFlight.resize(swapChainImages.size(), nullptr);
+	//acquire and present only take binary semaphores, so those stay per frame either way
+	imageAvailableSemaphores.resize(framesInFlight);
+	renderFinishedSemaphores.resize(framesInFlight);
 
 	vk::SemaphoreCreateInfo semaphoreInfo{};
 
-	vk::FenceCreateInfo fenceInfo(vk::FenceCreateFlagBits::eSignaled);
-
-	for (size_t i = 0; i < Settings::MAX_FRAMES_IN_FLIGHT; i++)
+	for (size_t i = 0; i < framesInFlight; i++)
 	{
 		imageAvailableSemaphores[i] = device.createSemaphore(semaphoreInfo);
 		renderFinishedSemaphores[i] = device.createSemaphore(semaphoreInfo);
-		inFlightFences[i] = device.createFence(fenceInfo);
 	}
-	std::cout << "created " << Settings::MAX_FRAMES_IN_FLIGHT << " image available semaphores, render finished semaphores and in flight fences\n";
-}
+	LOG_DEBUG("created {} image available and render finished semaphores", framesInFlight);
 
-void VulkanResources::drawFrame()
-{
-	auto result = device.waitForFences(inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-
-	uint32_t imageIndex;
-	vk::ResultValue<uint32_t> resultValue(vk::Result::eSuccess, 0);
-	try
+	if (timelineSemaphores)
 	{
-		resultValue = device.acquireNextImageKHR(swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], nullptr);
-		imageIndex = resultValue.value;
+		//frames drawn before a recreation are done, the new timeline starts where the old one ended
+		vk::SemaphoreTypeCreateInfo typeInfo(vk::SemaphoreType::eTimeline, framesDrawn);
+		vk::SemaphoreCreateInfo timelineInfo{};
+		timelineInfo.pNext = &typeInfo;
+		frameTimeline = device.createSemaphore(timelineInfo);
+		completedFrame = framesDrawn;
+		imageFrames.resize(swapChainImages.size(), 0);
+		LOG_DEBUG("created frame timeline semaphore at frame {}", framesDrawn);
+		return;
 	}
-	catch (std::exception const& e)
+
+	inFlightFences.resize(framesInFlight);
+	imagesInFlight.resize(swapChainImages.size(), nullptr);
+
+	vk::FenceCreateInfo fenceInfo(vk::FenceCreateFlagBits::eSignaled);
+
+	for (size_t i = 0; i < framesInFlight; i++)
 	{
-		if (strcmp(e.what(), "vk::Device::acquireNextImageKHR: ErrorOutOfDateKHR"))
-		{
-			recreateSwapChain();
-			return;
-		}
-		else
-		{
-			throw std::runtime_error("couldn't acquire swap chain image\n");
-		}
+		inFlightFences[i] = device.createFence(fenceInfo);
 	}
+	LOG_DEBUG("created {} in flight fences", framesInFlight);
+}
 
-	if (imagesInFlight[imageIndex])
+void VulkanResources::destroySyncObjects()
+{
+	for (size_t i = 0; i < imageAvailableSemaphores.size(); i++)
 	{
-		result = device.waitForFences(imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+		device.destroySemaphore(renderFinishedSemaphores[i]);
+		device.destroySemaphore(imageAvailableSemaphores[i]);
 	}
+	LOG_DEBUG("destroyed {} image available and render finished semaphores", imageAvailableSemaphores.size());
+	imageAvailableSemaphores.clear();
+	renderFinishedSemaphores.clear();
 
-	imagesInFlight[imageIndex] = inFlightFences[currentFrame];
-
-	updateSprites(imageIndex);
-
-	updateCommandBuffer(imageIndex);
-
-	std::vector<vk::Semaphore> waitSemaphores = { imageAvailableSemaphores[currentFrame] };
-	std::vector<vk::PipelineStageFlags> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
-	std::vector<vk::Semaphore> signalSemaphores = { renderFinishedSemaphores[currentFrame] };
-
-	vk::SubmitInfo submitInfo(1, waitSemaphores.data(), waitStages.data(), 1,
-		&commandBuffers[imageIndex], 1, signalSemaphores.data());
-
-	result = device.resetFences(1, &inFlightFences[currentFrame]);
-
-	graphicsQueue.submit(submitInfo, inFlightFences[currentFrame]);
-
-	std::vector<vk::SwapchainKHR> swapChains = { swapChain };
-	vk::PresentInfoKHR presentInfo(1, signalSemaphores.data(), 1, swapChains.data(),
-		&imageIndex, nullptr);
-
-	try
+	if (frameTimeline)
 	{
-		resultValue.result = presentQueue.presentKHR(presentInfo);
+		device.destroySemaphore(frameTimeline);
+		frameTimeline = nullptr;
+		LOG_DEBUG("destroyed frame timeline semaphore");
 	}
-	catch (std::exception const& e)
+
+	for (auto fence : inFlightFences)
 	{
-		if (strcmp(e.what(), "vk::Queue::presentKHR: ErrorOutOfDateKHR") == 0)
-		{
-			recreateSwapChain();
-		}
-		else
-		{
-			throw std::runtime_error("couldn't present swap chain image\n");
-		}
+		device.destroyFence(fence);
 	}
-	if (resultValue.result == vk::Result::eSuboptimalKHR)
+	if (!inFlightFences.empty())
 	{
-		recreateSwapChain();
+		LOG_DEBUG("destroyed {} in flight fences", inFlightFences.size());
 	}
-
-	currentFrame = (currentFrame + 1) % Settings::MAX_FRAMES_IN_FLIGHT;
+	inFlightFences.clear();
 }
 
-void VulkanResources::cleanupSwapChain()
+void VulkanResources::waitForFrame(uint64_t frameNumber)
 {
-	for (auto i = 0; i < commandBuffers.size(); i++)
+	vk::SemaphoreWaitInfo waitInfo({}, 1, &frameTimeline, &frameNumber);
+	//errors throw, only a timeout comes back
+	if (device.waitSemaphores(waitInfo, UINT64_MAX) != vk::Result::eSuccess)
 	{
-		device.freeCommandBuffers(commandPool, commandBuffers[i]);
+		throw std::runtime_error("timed out waiting for frame " + std::to_string(frameNumber));
 	}
-	std::cout << "freed command buffers\n";
-
-	device.destroyImageView(colorImageView);
-	device.destroyImage(colorImage);
-	device.freeMemory(colorImageMemory);
-	std::cout << "destroyed color image, view, and freed memory\n";
-
-	device.destroyImageView(depthImageView);
-	device.destroyImage(depthImage);
-	device.freeMemory(depthImageMemory);
-	std::cout << "destroyed depth image, view, and freed memory\n";
-
-	for (size_t i = 0; i < swapChainFramebuffers.size(); i++)
+	if (Settings::CHECK_FRAME_ORDER)
 	{
-		device.destroyFramebuffer(swapChainFramebuffers[i]);
+		checkFrameOrder(frameNumber);
 	}
-	std::cout << "destroyed " << swapChainFramebuffers.size() << " framebuffers\n";
+}
 
-	for (auto i = 0; i < graphicsPipelinesData.size(); i++)
+void VulkanResources::checkFrameOrder(uint64_t waitedFrame)
+{
+	uint64_t counter = device.getSemaphoreCounterValue(frameTimeline);
+	if (counter < waitedFrame || counter < completedFrame || counter > framesDrawn)
 	{
-		device.destroyPipeline(graphicsPipelinesData[i].pipeline);
-		device.destroyPipelineLayout(graphicsPipelinesData[i].layout);
-		device.destroyDescriptorSetLayout(graphicsPipelinesData[i].descriptorSetLayout);
-		std::cout << "destroyed pipeline, and pipeline and descriptor set layouts number " << i << "\n";
+		throw std::runtime_error("frames retired out of order, timeline at " + std::to_string(counter) + " after waiting for frame " + std::to_string(waitedFrame)
+			+ ", it was at " + std::to_string(completedFrame) + " before and " + std::to_string(framesDrawn) + " frames were submitted");
 	}
+	completedFrame = counter;
+}
 
-	device.destroyRenderPass(renderPass, nullptr);
-	std::cout << "destroyed render pass\n";
-
-	for (size_t i = 0; i < swapChainImageViews.size(); i++)
+bool VulkanResources::applyPresentationSettings()
+{
+	if (frame->framesInFlight != framesInFlight)
 	{
-		device.destroyImageView(swapChainImageViews[i], nullptr);
+		//every fence and semaphore in use has to be done before they go
+		device.waitIdle();
+		frameAllocations.rewarm();
+		for (uint32_t i = 0; i < swapChainImages.size(); i++)
+		{
+			if (timelineSemaphores ? imageFrames[i] != 0 : (bool)imagesInFlight[i])
+			{
+				collectImageResults(i);
+			}
+		}
+		destroySyncObjects();
+		framesInFlight = frame->framesInFlight;
+		imagesInFlight.assign(timelineSemaphores ? 0 : swapChainImages.size(), nullptr);
+		imageFrames.assign(timelineSemaphores ? swapChainImages.size() : 0, 0);
+		createSyncObjects();
+		currentFrame = 0;
 	}
-	std::cout << "destroyed " << swapChainImageViews.size() << " swap chain image views\n";
-
-	device.destroySwapchainKHR(swapChain, nullptr);
-	std::cout << "destroyed swapchain\n";
-
-	spritesToRender.reset(nullptr);
+	if (frame->presentMode != presentMode)
+	{
+		presentMode = frame->presentMode;
+		recreateSwapChain();
+		return false;
+	}
+	return true;
+}
 
-	device.destroyDescriptorPool(descriptorPool);
-	std::cout << "destroyed descriptor pool\n";
+void VulkanResources::startRendering()
+{
+	rendering = true;
+	renderThread = std::thread(&VulkanResources::renderLoop, this);
+	LOG_DEBUG("started render thread");
 }
 
-void VulkanResources::recreateSwapChain()
+void VulkanResources::stopRendering()
 {
-	int width = 0, height = 0;
-	glfwGetFramebufferSize(window, &width, &height);
-	while (width == 0 || height == 0)
+	rendering = false;
+	wakeRenderThread();
+	if (renderThread.joinable())
 	{
-		glfwGetFramebufferSize(window, &width, &height);
-		glfwWaitEvents();
+		renderThread.join();
+		LOG_DEBUG("stopped render thread");
 	}
-	device.waitIdle();
 
-	cleanupSwapChain();
+	if (renderError)
+	{
+		//frames submitted before the error can still be running, the destructor frees what they use
+		try
+		{
+			device.waitIdle();
+		}
+		catch (vk::SystemError const&)
+		{
 
-	createSwapChain();
-	createImageViews();
-	createRenderPass();
-	createGraphicsPipelines();
-	createColorResources();
-	createDepthResources();
-	createFramebuffers();
-	createDescriptorPool();
-	spritesToRender = std::make_unique<SpritePool>(this);
-	createSprites();
-	createCommandBuffers();
+		}
+		std::rethrow_exception(std::exchange(renderError, nullptr));
+	}
 }
 
-void VulkanResources::createSprites()
+void VulkanResources::wakeRenderThread()
 {
-	game->recreateSprites();
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		wakeRequested = true;
+	}
+	wakeCondition.notify_one();
 }
 
-void VulkanResources::updateSprites(uint32_t imageIndex)
+void VulkanResources::renderLoop()
 {
-	spritesToRender->update(imageIndex);
+	try
+	{
+		renderFrames();
+	}
+	catch (...)
+	{
+		//the update thread ends its loop once the window should close, then stopRendering rethrows this
+		renderError = std::current_exception();
+		rendering = false;
+		glfwSetWindowShouldClose(window, GLFW_TRUE);
+		glfwPostEmptyEvent();
+	}
+}
+
+void VulkanResources::renderFrames()
+{
+	double lastFrameTime = glfwGetTime();
+	uint64_t drawnVersion = 0;
+	while (rendering)
+	{
+		frames.update();
+		frame = &frames.readBuffer();
+		if (frame->sequence == 0)
+		{
+			//nothing published yet
+			std::this_thread::yield();
+			continue;
+		}
+
+		if (frame->sceneVersion != drawnVersion)
+		{
+			drawnVersion = frame->sceneVersion;
+			framesToRefine = std::max(framesToRefine, refinementFrames());
+		}
+		//another frame would look like the last one, wait for a change instead of keeping the gpu busy
+		if (frame->renderOnDemand && framesToRefine == 0 && !framebufferResized && !readbackPending())
+		{
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			//the timeout only matters if a wake-up raced the checks above
+			wakeCondition.wait_for(lock, std::chrono::milliseconds(100), [this]() { return wakeRequested; });
+			wakeRequested = false;
+			continue;
+		}
+
+		frameAllocations.begin();
+		bool drawn = drawFrame();
+		frameAllocations.end();
+		if (!drawn)
+		{
+			continue;
+		}
+		frameAllocations.endFrame();
+		if (framesToRefine > 0)
+		{
+			framesToRefine--;
+		}
+		if (Settings::EXIT_AFTER_FRAMES != 0 && framesDrawn >= Settings::EXIT_AFTER_FRAMES)
+		{
+			glfwSetWindowShouldClose(window, GLFW_TRUE);
+			glfwPostEmptyEvent();
+		}
+
+		double currentTime = glfwGetTime();
+		FrameResult result = { frame->sequence, fractalTime, (float)((currentTime - lastFrameTime) * 1000.0), spriteResources->getStats(), inputLatency };
+		lastFrameTime = currentTime;
+
+		std::lock_guard<std::mutex> lock(resultsMutex);
+		frameResults.push_back(result);
+	}
+
+	if (Settings::CHECK_FRAME_ORDER)
+	{
+		if (timelineSemaphores)
+		{
+			LOG_INFO("frames retired in order, {} of {} checked", completedFrame, framesDrawn);
+		}
+		else
+		{
+			LOG_WARNING("frame order wasn't checked, the device has no timeline semaphores");
+		}
+	}
+}
+
+uint32_t VulkanResources::refinementFrames() const
+{
+	uint32_t shadingCycle = 1;
+	if (frame->fractalPath != FractalPaths::eFragment)
+	{
+		if (frame->fractalShading == FractalShading::eCheckerboard)
+		{
+			shadingCycle = 2;
+		}
+		else if (frame->fractalShading == FractalShading::eQuarter)
+		{
+			shadingCycle = 4;
+		}
+	}
+	//every pixel of a 4x4 tile gets its refresh march once per 16 shading cycles
+	return frame->temporal ? 16 * shadingCycle : shadingCycle;
+}
+
+bool VulkanResources::readbackPending() const
+{
+	//a bake is only scheduled on the frame after the parameters settled, results are read when the image comes around again
+	bool bakeWaiting = frame->distanceCache && !frame->deepZoom && !cacheValid;
+	return bakeWaiting || cacheReportImage.has_value() || captureImage.has_value() || frame->captureRequests != captureRequestsSeen;
+}
+
+void VulkanResources::takeFrameResults(std::vector<FrameResult>& results)
+{
+	results.clear();
+	std::lock_guard<std::mutex> lock(resultsMutex);
+	std::swap(results, frameResults);
+}
+
+bool VulkanResources::drawFrame()
+{
+	if (framebufferResized)
+	{
+		recreateSwapChain();
+		return false;
+	}
+
+	if (!applyPresentationSettings())
+	{
+		return false;
+	}
+
+	swapReloadedPipelines();
+
+	frameArena.reset();
+
+	//this frame's number on the timeline, it reuses the semaphores of the frame framesInFlight before it
+	uint64_t frameNumber = framesDrawn + 1;
+	vk::Result result = vk::Result::eSuccess;
+	if (timelineSemaphores)
+	{
+		if (frameNumber > framesInFlight)
+		{
+			waitForFrame(frameNumber - framesInFlight);
+		}
+	}
+	else
+	{
+		result = device.waitForFences(inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+	}
+
+	uint32_t imageIndex;
+	vk::ResultValue<uint32_t> resultValue(vk::Result::eSuccess, 0);
+	try
+	{
+		resultValue = device.acquireNextImageKHR(swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], nullptr);
+		imageIndex = resultValue.value;
+	}
+	catch (std::exception const& e)
+	{
+		if (strcmp(e.what(), "vk::Device::acquireNextImageKHR: ErrorOutOfDateKHR"))
+		{
+			recreateSwapChain();
+			return false;
+		}
+		else
+		{
+			throw std::runtime_error("couldn't acquire swap chain image\n");
+		}
+	}
+
+	//the image's command buffer gets rerecorded, the frame that last used it has to be done
+	if (timelineSemaphores)
+	{
+		if (imageFrames[imageIndex] != 0)
+		{
+			//usually retired already by the wait above, only out of order images block here
+			waitForFrame(imageFrames[imageIndex]);
+			collectImageResults(imageIndex);
+		}
+		imageFrames[imageIndex] = frameNumber;
+	}
+	else
+	{
+		if (imagesInFlight[imageIndex])
+		{
+			result = device.waitForFences(imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+			collectImageResults(imageIndex);
+		}
+		imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+	}
+
+	//a request can arrive in a snapshot this thread skipped, the count still changed
+	if (frame->captureRequests != captureRequestsSeen)
+	{
+		captureRequestsSeen = frame->captureRequests;
+		capturePending = true;
+	}
+
+	updateSprites(imageIndex);
+
+	updateReferenceOrbit(imageIndex);
+
+	updateDistanceCache();
+
+	updateFrameState(imageIndex);
+
+	updateCommandBuffer(imageIndex);
+
+	vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+	//present waits on the binary semaphore, the timeline one tells the cpu when the frame retired
+	vk::Semaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame], frameTimeline };
+	uint64_t waitValue = 0;									//ignored for binary semaphores
+	uint64_t signalValues[] = { 0, frameNumber };
+
+	vk::SubmitInfo submitInfo(1, &imageAvailableSemaphores[currentFrame], &waitStage, 1,
+		&commandBuffers[imageIndex], timelineSemaphores ? 2 : 1, signalSemaphores);
+
+	if (timelineSemaphores)
+	{
+		vk::TimelineSemaphoreSubmitInfo timelineInfo(1, &waitValue, 2, signalValues);
+		submitInfo.pNext = &timelineInfo;
+		graphicsQueue.submit(submitInfo, nullptr);
+	}
+	else
+	{
+		result = device.resetFences(1, &inFlightFences[currentFrame]);
+		graphicsQueue.submit(submitInfo, inFlightFences[currentFrame]);
+	}
+
+	vk::PresentInfoKHR presentInfo(1, &renderFinishedSemaphores[currentFrame], 1, &swapChain,
+		&imageIndex, nullptr);
+
+	try
+	{
+		resultValue.result = presentQueue.presentKHR(presentInfo);
+	}
+	catch (std::exception const& e)
+	{
+		if (strcmp(e.what(), "vk::Queue::presentKHR: ErrorOutOfDateKHR") == 0)
+		{
+			recreateSwapChain();
+		}
+		else
+		{
+			throw std::runtime_error("couldn't present swap chain image\n");
+		}
+	}
+	if (resultValue.result == vk::Result::eSuboptimalKHR)
+	{
+		recreateSwapChain();
+	}
+
+	//the first frame showing new input, the time until the present call includes every wait for frames ahead of it
+	inputLatency = -1.0f;
+	if (frame->measureLatency && frame->inputTime > measuredInputTime)
+	{
+		inputLatency = (float)((glfwGetTime() - frame->inputTime) * 1000.0);
+		measuredInputTime = frame->inputTime;
+	}
+
+	currentFrame = (currentFrame + 1) % framesInFlight;
+	framesDrawn++;
+	return true;
+}
+
+FractalPipelines VulkanResources::buildFractalPipelines()
+{
+	std::lock_guard<std::mutex> lock(pipelineMutex);
+	FractalPipelines pipelines = {};
+	pipelines.swapChainGeneration = swapChainGeneration;
+	try
+	{
+		pipelines.fragment = createFractalPipeline();
+		pipelines.composite = createCompositePipeline();
+		pipelines.compute = createComputePipeline(Settings::FRACTAL_COMP_SHADER_PATH, computePipelineData.layout);
+		pipelines.bake = createComputePipeline(Settings::FRACTAL_BAKE_SHADER_PATH, bakePipelineData.layout);
+		pipelines.reproject = createComputePipeline(Settings::FRACTAL_REPROJECT_SHADER_PATH, reprojectPipelineData.layout);
+	}
+	catch (...)
+	{
+		destroyFractalPipelines(pipelines);
+		throw;
+	}
+	return pipelines;
+}
+
+void VulkanResources::swapReloadedPipelines()
+{
+	//every frame submitted before a swap has waited on its fence once FRAMES_IN_FLIGHT frames followed it
+	//the timeline tells exactly which frames retired
+	uint64_t retiredFrame = framesDrawn >= framesInFlight ? framesDrawn - framesInFlight : 0;
+	if (timelineSemaphores && !retiredPipelines.empty())
+	{
+		retiredFrame = device.getSemaphoreCounterValue(frameTimeline);
+	}
+	while (!retiredPipelines.empty() && retiredFrame >= retiredPipelines.front().frame)
+	{
+		destroyFractalPipelines(retiredPipelines.front().pipelines);
+		retiredPipelines.erase(retiredPipelines.begin());
+	}
+
+	FractalPipelines pipelines;
+	if (!shaderReloader->takeReady(pipelines))
+	{
+		return;
+	}
+	if (pipelines.swapChainGeneration != swapChainGeneration)
+	{
+		destroyFractalPipelines(pipelines);
+		return;
+	}
+
+	FractalPipelines replaced = { graphicsPipelinesData[1].pipeline, graphicsPipelinesData[2].pipeline, computePipelineData.pipeline,
+		bakePipelineData.pipeline, reprojectPipelineData.pipeline, swapChainGeneration };
+	retiredPipelines.push_back({ replaced, framesDrawn });
+	frameAllocations.rewarm();
+	graphicsPipelinesData[1].pipeline = pipelines.fragment;
+	graphicsPipelinesData[2].pipeline = pipelines.composite;
+	computePipelineData.pipeline = pipelines.compute;
+	bakePipelineData.pipeline = pipelines.bake;
+	reprojectPipelineData.pipeline = pipelines.reproject;
+
+	//the primary command buffers are recorded every frame, only the fractal passes bound the old pipeline
+	for (auto& passes : recordedPasses)
+	{
+		passes[spritePassCount].valid = false;
+	}
+	//the distance field may have changed, rebake the cache and don't reproject hits of the old one
+	cacheValid = false;
+	historyValid = false;
+	LOG_INFO("swapped in reloaded fractal pipelines");
+}
+
+void VulkanResources::destroyFractalPipelines(FractalPipelines const& pipelines)
+{
+	device.destroyPipeline(pipelines.fragment);
+	device.destroyPipeline(pipelines.composite);
+	device.destroyPipeline(pipelines.compute);
+	device.destroyPipeline(pipelines.bake);
+	device.destroyPipeline(pipelines.reproject);
+}
+
+void VulkanResources::cleanupSwapChain()
+{
+	for (auto i = 0; i < commandBuffers.size(); i++)
+	{
+		device.freeCommandBuffers(commandPool, commandBuffers[i]);
+	}
+	for (auto const& imageBuffers : secondaryCommandBuffers)
+	{
+		for (uint32_t pass = 0; pass < renderPassCount; pass++)
+		{
+			device.freeCommandBuffers(recordPools[pass % recordPools.size()], imageBuffers[pass]);
+		}
+	}
+	secondaryCommandBuffers.clear();
+	LOG_DEBUG("freed command buffers");
+
+	device.destroyImageView(colorImageView);
+	device.destroyImage(colorImage);
+	device.freeMemory(colorImageMemory);
+	LOG_DEBUG("destroyed color image, view, and freed memory");
+
+	device.destroyImageView(depthImageView);
+	device.destroyImage(depthImage);
+	device.freeMemory(depthImageMemory);
+	LOG_DEBUG("destroyed depth image, view, and freed memory");
+
+	for (size_t i = 0; i < swapChainFramebuffers.size(); i++)
+	{
+		device.destroyFramebuffer(swapChainFramebuffers[i]);
+	}
+	LOG_DEBUG("destroyed {} framebuffers", swapChainFramebuffers.size());
+
+	for (auto i = 0; i < graphicsPipelinesData.size(); i++)
+	{
+		device.destroyPipeline(graphicsPipelinesData[i].pipeline);
+		device.destroyPipelineLayout(graphicsPipelinesData[i].layout);
+		device.destroyDescriptorSetLayout(graphicsPipelinesData[i].descriptorSetLayout);
+		LOG_DEBUG("destroyed pipeline, and pipeline and descriptor set layouts number {}", i);
+	}
+	device.destroyPipeline(spriteBlendPipeline);
+	device.destroyDescriptorSetLayout(spriteTextureSetLayout);
+	LOG_DEBUG("destroyed transparent sprite pipeline and texture set layout");
+
+	device.destroyPipeline(computePipelineData.pipeline);
+	device.destroyPipelineLayout(computePipelineData.layout);
+	device.destroyDescriptorSetLayout(computePipelineData.descriptorSetLayout);
+	LOG_DEBUG("destroyed compute pipeline, and pipeline and descriptor set layouts");
+
+	device.destroyPipeline(bakePipelineData.pipeline);
+	device.destroyPipelineLayout(bakePipelineData.layout);
+	LOG_DEBUG("destroyed bake pipeline and pipeline layout");
+
+	device.destroyPipeline(reprojectPipelineData.pipeline);
+	device.destroyPipelineLayout(reprojectPipelineData.layout);
+	LOG_DEBUG("destroyed reproject pipeline and pipeline layout");
+
+	device.destroyDescriptorPool(fractalDescriptorPool);
+	LOG_DEBUG("destroyed fractal descriptor pool");
+
+	device.destroyImageView(fractalImageView);
+	device.destroyImage(fractalImage);
+	device.unmapMemory(captureBufferMemory);
+	device.destroyBuffer(captureBuffer);
+	device.freeMemory(captureBufferMemory);
+	//a copy still waiting to be read went away with the buffer
+	captureImage.reset();
+	device.freeMemory(fractalImageMemory);
+	LOG_DEBUG("destroyed fractal storage image, view, and freed memory");
+
+	for (size_t i = 0; i < rayQueues.size(); i++)
+	{
+		device.destroyBuffer(rayQueues[i]);
+		device.freeMemory(rayQueuesMemory[i]);
+		device.destroyBuffer(rayQueueStates[i]);
+		device.freeMemory(rayQueueStatesMemory[i]);
+	}
+	LOG_DEBUG("destroyed {} ray queues and freed memory", rayQueues.size());
+
+	for (size_t i = 0; i < orbitBuffers.size(); i++)
+	{
+		device.unmapMemory(orbitBuffersMemory[i]);
+		device.destroyBuffer(orbitBuffers[i]);
+		device.freeMemory(orbitBuffersMemory[i]);
+	}
+	LOG_DEBUG("destroyed {} reference orbit buffers and freed memory", orbitBuffers.size());
+
+	for (size_t i = 0; i < frameStateBuffers.size(); i++)
+	{
+		device.unmapMemory(frameStateBuffersMemory[i]);
+		device.destroyBuffer(frameStateBuffers[i]);
+		device.freeMemory(frameStateBuffersMemory[i]);
+	}
+	LOG_DEBUG("destroyed {} frame state buffers and freed memory", frameStateBuffers.size());
+
+	device.destroyBuffer(temporalHistory);
+	device.freeMemory(temporalHistoryMemory);
+	device.destroyBuffer(temporalReprojection);
+	device.freeMemory(temporalReprojectionMemory);
+	LOG_DEBUG("destroyed temporal reprojection buffers and freed memory");
+
+	if (queryPool)
+	{
+		device.destroyQueryPool(queryPool);
+		queryPool = nullptr;
+		LOG_DEBUG("destroyed timestamp query pool");
+	}
+
+	device.destroyRenderPass(renderPass, nullptr);
+	LOG_DEBUG("destroyed render pass");
+
+	for (size_t i = 0; i < swapChainImageViews.size(); i++)
+	{
+		device.destroyImageView(swapChainImageViews[i], nullptr);
+	}
+	LOG_DEBUG("destroyed {} swap chain image views", swapChainImageViews.size());
+
+	device.destroySwapchainKHR(swapChain, nullptr);
+	LOG_DEBUG("destroyed swapchain");
+
+	spriteResources.reset(nullptr);
+}
+
+void VulkanResources::recreateSwapChain()
+{
+	//minimized, the update thread keeps polling events and reports the new size
+	while ((framebufferWidth == 0 || framebufferHeight == 0) && rendering)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	if (!rendering)
+	{
+		return;
+	}
+	framebufferResized = false;
+	frameAllocations.rewarm();
+	device.waitIdle();
+
+	for (auto const& retired : retiredPipelines)
+	{
+		destroyFractalPipelines(retired.pipelines);
+	}
+	retiredPipelines.clear();
+
+	//a reload that finishes after this is thrown away, the new pipelines already read its shaders
+	std::lock_guard<std::mutex> lock(pipelineMutex);
+	swapChainGeneration++;
+
+	cleanupSwapChain();
+
+	createSwapChain();
+	createImageViews();
+	createRenderPass();
+	createGraphicsPipelines();
+	createComputePipelines();
+	createColorResources();
+	createDepthResources();
+	createFramebuffers();
+	createFractalResources();
+	createQueryPool();
+	//sprites keep their transforms, every image gets rewritten on its next draw
+	spriteResources = std::make_unique<SpriteResources>(this);
+	createCommandBuffers();
+
+	//image count can change and old fences or frames don't guard the new command buffers
+	imagesInFlight.assign(timelineSemaphores ? 0 : swapChainImages.size(), nullptr);
+	imageFrames.assign(timelineSemaphores ? swapChainImages.size() : 0, 0);
+	//the new images hold nothing yet
+	framesToRefine = std::max(framesToRefine, refinementFrames());
+}
+
+void VulkanResources::updateSprites(uint32_t imageIndex)
+{
+	//pages, sort keys and draw lists only grow with the sprite count
+	if (frame->sprites.size() > spriteHighWater)
+	{
+		spriteHighWater = frame->sprites.size();
+		frameAllocations.rewarm();
+	}
+	spriteResources->update(*frame, imageIndex);
 }
 
 void VulkanResources::updateCommandBuffer(uint32_t imageIndex)
@@ -953,71 +1869,631 @@ void VulkanResources::updateCommandBuffer(uint32_t imageIndex)
 	vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr);
 	commandBuffers[imageIndex].begin(beginInfo);
 
-	vk::Rect2D renderArea({ 0,0 }, swapChainExtent);
-	std::array<vk::ClearValue, 2> clearValues = {};
-	clearValues[0].color = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } };
-	clearValues[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
-	vk::RenderPassBeginInfo renderPassInfo(renderPass, swapChainFramebuffers[imageIndex],
-		renderArea, (uint32_t)clearValues.size(), clearValues.data());
+	FractalPushConstants pushConstants = getFractalPushConstants();
+
+	//one-off, kept out of the fractal time
+	if (cacheBakePending)
+	{
+		recordCacheBake(commandBuffers[imageIndex], imageIndex, pushConstants);
+	}
+	pushConstants.marchPass.w = (frame->distanceCache && !frame->deepZoom && cacheValid) ? 1.0f : 0.0f;
+
+	//fractal time covers the compute passes and the draw that puts the fractal on screen
+	if (timestampPeriod != 0.0f)
+	{
+		commandBuffers[imageIndex].resetQueryPool(queryPool, 2 * imageIndex, 2);
+		commandBuffers[imageIndex].writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, queryPool, 2 * imageIndex);
+	}
+
+	if (frame->temporal)
+	{
+		recordTemporalReproject(commandBuffers[imageIndex], imageIndex, pushConstants);
+	}
+
+	if (frame->fractalPath != FractalPaths::eFragment)
+	{
+		recordFractalCompute(commandBuffers[imageIndex], imageIndex, pushConstants);
+	}
+
+	vk::Rect2D renderArea({ 0,0 }, swapChainExtent);
+	std::array<vk::ClearValue, 2> clearValues = {};
+	clearValues[0].color = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } };
+	clearValues[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
+	vk::RenderPassBeginInfo renderPassInfo(renderPass, swapChainFramebuffers[imageIndex],
+		renderArea, (uint32_t)clearValues.size(), clearValues.data());
+
+	//the render pass only executes secondary command buffers, they're recorded before the primary references them
+	recordRenderPasses(imageIndex, pushConstants);
+	std::array<vk::CommandBuffer, renderPassCount> passes;
+	uint32_t passCount = 0;
+	for (uint32_t pass : passOrder)
+	{
+		//empty layers were never begun
+		if (pass < spritePassCount && recordedPasses[imageIndex][pass].draws.empty())
+		{
+			continue;
+		}
+		passes[passCount++] = secondaryCommandBuffers[imageIndex][pass];
+	}
+
+	commandBuffers[imageIndex].beginRenderPass(renderPassInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+
+	commandBuffers[imageIndex].executeCommands(passCount, passes.data());
+
+	commandBuffers[imageIndex].endRenderPass();
+
+	//outside the timed part, the fragment path never writes the fractal image
+	if (capturePending && frame->fractalPath != FractalPaths::eFragment)
+	{
+		recordFractalCapture(commandBuffers[imageIndex], imageIndex);
+	}
+
+	commandBuffers[imageIndex].end();
+}
+
+void VulkanResources::recordRenderPasses(uint32_t imageIndex, FractalPushConstants const& pushConstants)
+{
+	//moved sprites only change their mvps, descriptor sets are never rewritten so only the draws matter
+	std::array<bool, renderPassCount> stale = {};
+	for (uint32_t pass = 0; pass < spritePassCount; pass++)
+	{
+		RecordedPass const& recorded = recordedPasses[imageIndex][pass];
+		stale[pass] = !recorded.valid || recorded.draws != spriteResources->getDraws(static_cast<SpriteLayers>(pass));
+	}
+	//the compute paths composite the same image every frame, only the fragment path depends on the push constants
+	RecordedPass const& fractalRecorded = recordedPasses[imageIndex][spritePassCount];
+	stale[spritePassCount] = !fractalRecorded.valid || fractalRecorded.fractalPath != frame->fractalPath ||
+		(frame->fractalPath == FractalPaths::eFragment && memcmp(&fractalRecorded.pushConstants, &pushConstants, sizeof(FractalPushConstants)) != 0);
+
+	uint32_t jobCount = (uint32_t)recordPools.size();
+	for (uint32_t job = 0; job < jobCount; job++)
+	{
+		bool jobStale = false;
+		for (uint32_t pass = job; pass < renderPassCount; pass += jobCount)
+		{
+			jobStale = jobStale || stale[pass];
+		}
+		if (!jobStale)
+		{
+			continue;
+		}
+
+		RecordJob* recordJob = frameArena.make<RecordJob>(job, jobCount, imageIndex, &stale, &pushConstants);
+		recordJobs->submit([this, recordJob]()
+			{
+				for (uint32_t pass = recordJob->firstPass; pass < renderPassCount; pass += recordJob->jobCount)
+				{
+					if (!(*recordJob->stale)[pass])
+					{
+						continue;
+					}
+					if (pass < spritePassCount)
+					{
+						recordSpritePass(recordJob->imageIndex, pass);
+					}
+					else
+					{
+						recordFractalPass(recordJob->imageIndex, *recordJob->pushConstants);
+					}
+				}
+			});
+	}
+	recordJobs->wait();
+}
+
+void VulkanResources::beginRenderPassCommands(vk::CommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	//kept across frames, so no one time submit
+	vk::CommandBufferInheritanceInfo inheritanceInfo(renderPass, 0, swapChainFramebuffers[imageIndex]);
+	vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eRenderPassContinue, &inheritanceInfo);
+	commandBuffer.begin(beginInfo);
+}
+
+void VulkanResources::recordSpritePass(uint32_t imageIndex, uint32_t pass)
+{
+	RecordedPass& recorded = recordedPasses[imageIndex][pass];
+	SpriteLayers layer = static_cast<SpriteLayers>(pass);
+	//draws merge sprites, sized for the most there can be so assigning never grows it
+	recorded.draws.reserve(frame->sprites.size());
+	recorded.draws = spriteResources->getDraws(layer);
+	recorded.valid = true;
+	if (recorded.draws.empty())
+	{
+		return;
+	}
 
-	commandBuffers[imageIndex].beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+	vk::CommandBuffer commandBuffer = secondaryCommandBuffers[imageIndex][pass];
+	beginRenderPassCommands(commandBuffer, imageIndex);
 
-	commandBuffers[imageIndex].bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[0].pipeline);
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, isTransparentLayer(layer) ? spriteBlendPipeline : graphicsPipelinesData[0].pipeline);
 
 	vk::DeviceSize offsets = { 0 };
-	commandBuffers[imageIndex].bindVertexBuffers(0, vertexBuffer, offsets);
+	commandBuffer.bindVertexBuffers(0, vertexBuffer, offsets);
 
-	commandBuffers[imageIndex].bindIndexBuffer(indexBuffer, offsets, vk::IndexType::eUint32);
+	commandBuffer.bindIndexBuffer(indexBuffer, offsets, vk::IndexType::eUint32);
 
-	//get sprite array from sprite pool
-	auto const& sprites = spritesToRender->getSprites();
-	for (int i = 0; i < spritesToRender->size(); i++)
+	//draws are sorted by texture, the page and texture sets only get bound when they change
+	uint32_t boundPage = UINT32_MAX;
+	uint32_t boundTextureSet = UINT32_MAX;
+	for (SpriteDraw const& draw : recorded.draws)
 	{
-		if (!sprites[i].isRemoved)
+		if (draw.page != boundPage)
 		{
-			commandBuffers[imageIndex].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[0].layout,
-				0, sprites[i].descriptorSets[imageIndex], nullptr);
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[0].layout,
+				0, spriteResources->getPageDescriptorSet(draw.page, imageIndex), nullptr);
+			boundPage = draw.page;
+		}
+		if (draw.textureSet != boundTextureSet)
+		{
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[0].layout,
+				1, spriteResources->getTextureDescriptorSet(draw.textureSet), nullptr);
+			boundTextureSet = draw.textureSet;
+		}
+
+		commandBuffer.drawIndexed((uint32_t)indices.size(), draw.count, 0, 0, draw.firstSlot);
+	}
+
+	commandBuffer.end();
+}
+
+void VulkanResources::recordFractalPass(uint32_t imageIndex, FractalPushConstants const& pushConstants)
+{
+	RecordedPass& recorded = recordedPasses[imageIndex][spritePassCount];
+	recorded.fractalPath = frame->fractalPath;
+	recorded.pushConstants = pushConstants;
+	recorded.valid = true;
+
+	vk::CommandBuffer commandBuffer = secondaryCommandBuffers[imageIndex][spritePassCount];
+	beginRenderPassCommands(commandBuffer, imageIndex);
+
+	if (frame->fractalPath == FractalPaths::eFragment)
+	{
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[1].pipeline);
+
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[1].layout,
+			0, fractalSets[imageIndex], nullptr);
+
+		commandBuffer.pushConstants(graphicsPipelinesData[1].layout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(FractalPushConstants), &pushConstants);
+	}
+	else
+	{
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[2].pipeline);
+
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[2].layout,
+			0, fractalCompositeSet, nullptr);
+
+		glm::vec2 compositeScale((float)fractalExtent.width / swapChainExtent.width, (float)fractalExtent.height / swapChainExtent.height);
+		commandBuffer.pushConstants(graphicsPipelinesData[2].layout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(glm::vec2), &compositeScale);
+	}
+
+	commandBuffer.draw(4, 1, 0, 0);
+
+	//the query is reset by the primary every frame, writing it from a reused buffer is fine
+	if (timestampPeriod != 0.0f)
+	{
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, queryPool, 2 * imageIndex + 1);
+	}
+
+	commandBuffer.end();
+}
 
-			commandBuffers[imageIndex].drawIndexed((uint32_t)indices.size(), 1, 0, 0, 0);
+FractalPushConstants VulkanResources::getFractalPushConstants() const
+{
+	FractalPushConstants pushConstants;
+	vk::Extent2D extent = getMarchExtent();
+	pushConstants.data = glm::vec4(extent.width, extent.height, frame->steps, frame->fractalData[0]);
+	//the camera is split into a float and the float of what's left, the shader adds the small part to ray offsets
+	glm::vec3 cameraHigh = glm::vec3(frame->camera.position);
+	glm::vec3 cameraLow = glm::vec3(frame->camera.position - glm::dvec3(cameraHigh));
+	pushConstants.cameraPos = glm::vec4(cameraHigh, frame->camera.focalLength);
+	pushConstants.cameraHorizontal = glm::vec4(frame->camera.right, frame->estimator);
+	pushConstants.cameraVertical = glm::vec4(frame->camera.up, frame->fractalData[1]);
+	pushConstants.cameraDirection = glm::vec4(frame->camera.direction, frame->iterations);
+	pushConstants.juliaC = frame->juliaC;
+	pushConstants.marchPass = glm::vec4(0.0f, 0.0f, frame->deepZoom ? 1.0f : 0.0f, 0.0f);
+	//slowing the camera down is how you zoom in, hits have to get as precise as the movement
+	float precisionScale = frame->deepZoom ? frame->camera.speed / Camera::defaultSpeed : 1.0f;
+	pushConstants.cameraLow = glm::vec4(frame->deepZoom ? cameraLow : glm::vec3(0.0f), precisionScale);
+	return pushConstants;
+}
+
+vk::Extent2D VulkanResources::getMarchExtent() const
+{
+	return frame->fractalPath == FractalPaths::eFragment ? swapChainExtent : fractalExtent;
+}
+
+void VulkanResources::recordFractalCompute(vk::CommandBuffer commandBuffer, uint32_t imageIndex, FractalPushConstants& pushConstants)
+{
+	//last frame's composite has to be done reading and its passes done with the ray queues
+	vk::MemoryBarrier queueBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead |
+		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite);
+	vk::ImageSubresourceRange subresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+	vk::ImageMemoryBarrier writeBarrier(vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eShaderWrite,
+		vk::ImageLayout::eGeneral, vk::ImageLayout::eGeneral, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+		fractalImage, subresourceRange);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader |
+		vk::PipelineStageFlagBits::eDrawIndirect, vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+		{}, queueBarrier, {}, writeBarrier);
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, computePipelineData.pipeline);
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipelineData.layout, 1, fractalSets[imageIndex], nullptr);
+
+	//without wavefront passes every ray is marched to the end in a single dispatch
+	uint32_t stepsPerPass = 0;
+	uint32_t passCount = 1;
+	if (frame->fractalPath == FractalPaths::eComputeWavefront)
+	{
+		uint32_t maxSteps = (uint32_t)std::max(frame->steps, 0.0f);
+		stepsPerPass = Settings::FRACTAL_STEPS_PER_PASS;
+		passCount = std::max(1u, (maxSteps + stepsPerPass - 1) / stepsPerPass);
+
+		for (auto const& state : rayQueueStates)
+		{
+			commandBuffer.fillBuffer(state, 0, VK_WHOLE_SIZE, 0);
 		}
+		vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+			{}, clearBarrier, {}, {});
+	}
+
+	//reduced shading packs the pixels it marches into a smaller grid
+	uint32_t shadedWidth = fractalExtent.width;
+	uint32_t shadedHeight = fractalExtent.height;
+	if (frame->fractalShading != FractalShading::eFull)
+	{
+		shadedWidth = (shadedWidth + 1) / 2;
+	}
+	if (frame->fractalShading == FractalShading::eQuarter)
+	{
+		shadedHeight = (shadedHeight + 1) / 2;
 	}
 
-	commandBuffers[imageIndex].bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipelinesData[1].pipeline);
+	pushConstants.marchPass.x = (float)toUType(MarchPasses::ePrimary);
+	pushConstants.marchPass.y = (float)stepsPerPass;
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipelineData.layout, 0, fractalComputeSets[0], nullptr);
+	commandBuffer.pushConstants(computePipelineData.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FractalPushConstants), &pushConstants);
+	commandBuffer.dispatch((shadedWidth + 7) / 8, (shadedHeight + 7) / 8, 1);
 
-	std::vector<glm::vec4> pushConstantData;
-	pushConstantData.push_back(glm::vec4(swapChainExtent.width, swapChainExtent.height, game->steps, game->fractalData[0]));
-	pushConstantData.push_back(glm::vec4(game->camera.position, game->camera.focalLength));
-	pushConstantData.push_back(glm::vec4(game->camera.right, game->sceneID));
-	pushConstantData.push_back(glm::vec4(game->camera.up, game->fractalData[1]));
-	pushConstantData.push_back(glm::vec4(game->camera.direction, game->iterations));
-	pushConstantData.push_back(game->juliaC);
-	commandBuffers[imageIndex].pushConstants(graphicsPipelinesData[1].layout, vk::ShaderStageFlagBits::eFragment, 0, (uint32_t)(sizeof(glm::vec4) * pushConstantData.size()), pushConstantData.data());
+	//each pass advances the surviving rays and compacts them into the other queue
+	vk::MemoryBarrier passBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead |
+		vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eIndirectCommandRead);
+	for (uint32_t pass = 1; pass < passCount; pass++)
+	{
+		uint32_t inputQueue = pass % 2;
 
-	commandBuffers[imageIndex].draw(4, 1, 0, 0);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader |
+			vk::PipelineStageFlagBits::eDrawIndirect, {}, passBarrier, {}, {});
 
-	commandBuffers[imageIndex].endRenderPass();
-	commandBuffers[imageIndex].end();
+		pushConstants.marchPass.x = (float)toUType(MarchPasses::ePrepare);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipelineData.layout, 0, fractalComputeSets[1 - inputQueue], nullptr);
+		commandBuffer.pushConstants(computePipelineData.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FractalPushConstants), &pushConstants);
+		commandBuffer.dispatch(1, 1, 1);
+
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader |
+			vk::PipelineStageFlagBits::eDrawIndirect, {}, passBarrier, {}, {});
+
+		pushConstants.marchPass.x = (float)toUType(MarchPasses::eContinue);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipelineData.layout, 0, fractalComputeSets[inputQueue], nullptr);
+		commandBuffer.pushConstants(computePipelineData.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FractalPushConstants), &pushConstants);
+		commandBuffer.dispatchIndirect(rayQueueStates[inputQueue], 0);
+	}
+
+	if (frame->fractalShading != FractalShading::eFull)
+	{
+		//marched pixels have to be in the image before their neighbours are filled from them
+		vk::ImageMemoryBarrier marchBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+			vk::ImageLayout::eGeneral, vk::ImageLayout::eGeneral, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			fractalImage, subresourceRange);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+			{}, {}, {}, marchBarrier);
+
+		pushConstants.marchPass.x = (float)toUType(MarchPasses::eReconstruct);
+		commandBuffer.pushConstants(computePipelineData.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FractalPushConstants), &pushConstants);
+		commandBuffer.dispatch((fractalExtent.width + 7) / 8, (fractalExtent.height + 7) / 8, 1);
+	}
+
+	//composite reads the finished image inside the render pass
+	vk::ImageMemoryBarrier readBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead,
+		vk::ImageLayout::eGeneral, vk::ImageLayout::eGeneral, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+		fractalImage, subresourceRange);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader,
+		{}, {}, {}, readBarrier);
+}
+
+void VulkanResources::updateReferenceOrbit(uint32_t imageIndex)
+{
+	if (frame->deepZoom)
+	{
+		referenceOrbit.compute(frame->estimator, frame->camera.position, frame->fractalData, frame->iterations, frame->juliaC);
+	}
+	else
+	{
+		referenceOrbit.clear();
+	}
+	referenceOrbit.copyTo(orbitBuffersMapped[imageIndex]);
+}
+
+FractalParameters VulkanResources::getFractalParameters() const
+{
+	FractalParameters parameters;
+	parameters.estimator = frame->estimator;
+	parameters.fractalData[0] = frame->fractalData[0];
+	parameters.fractalData[1] = frame->fractalData[1];
+	parameters.iterations = frame->iterations;
+	parameters.juliaC = frame->juliaC;
+	return parameters;
+}
+
+void VulkanResources::updateDistanceCache()
+{
+	if (!frame->distanceCache || frame->deepZoom)
+	{
+		return;
+	}
+
+	//held keys change parameters every tick, only bake once they stayed the same for a frame
+	FractalParameters parameters = getFractalParameters();
+	if (parameters != cacheParameters)
+	{
+		cacheParameters = parameters;
+		cacheValid = false;
+	}
+	else if (!cacheValid)
+	{
+		cacheBakePending = true;
+	}
+}
+
+void VulkanResources::recordCacheBake(vk::CommandBuffer commandBuffer, uint32_t imageIndex, FractalPushConstants pushConstants)
+{
+	//frames still in flight may be marching the old cache
+	vk::MemoryBarrier readBarrier(vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer, {}, readBarrier, {}, {});
+
+	commandBuffer.fillBuffer(cacheState, 0, VK_WHOLE_SIZE, 0);
+	vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+		{}, clearBarrier, {}, {});
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, bakePipelineData.pipeline);
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, bakePipelineData.layout, 0, fractalSets[imageIndex], nullptr);
+
+	//cells first, they decide which ones get a brick
+	uint32_t groupCount = Settings::FRACTAL_CACHE_GRID / 8;
+	pushConstants.marchPass = glm::vec4(0.0f, (float)Settings::FRACTAL_CACHE_MAX_BRICKS, 0.0f, 0.0f);
+	commandBuffer.pushConstants(bakePipelineData.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FractalPushConstants), &pushConstants);
+	commandBuffer.dispatch(groupCount, groupCount, groupCount);
+
+	vk::MemoryBarrier cellBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+		{}, cellBarrier, {}, {});
+
+	pushConstants.marchPass.x = 1.0f;
+	commandBuffer.pushConstants(bakePipelineData.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FractalPushConstants), &pushConstants);
+	commandBuffer.dispatch(Settings::FRACTAL_CACHE_GRID, Settings::FRACTAL_CACHE_GRID, Settings::FRACTAL_CACHE_GRID);
+
+	//marching in this and later frames, and the brick count report
+	vk::MemoryBarrier bakeBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eHostRead);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader |
+		vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eHost, {}, bakeBarrier, {}, {});
+
+	cacheBakePending = false;
+	cacheValid = true;
+	cacheReportImage = imageIndex;
+}
+
+void VulkanResources::reportDistanceCache()
+{
+	cacheReportImage.reset();
+	uint32_t brickCount = *static_cast<uint32_t*>(cacheStateMapped);
+	if (brickCount > Settings::FRACTAL_CACHE_MAX_BRICKS)
+	{
+		LOG_INFO("baked distance cache, {} of {} bricks used, {} cells fall back to the exact DE", Settings::FRACTAL_CACHE_MAX_BRICKS,
+			Settings::FRACTAL_CACHE_MAX_BRICKS, brickCount - Settings::FRACTAL_CACHE_MAX_BRICKS);
+	}
+	else
+	{
+		LOG_INFO("baked distance cache, {} of {} bricks used", brickCount, Settings::FRACTAL_CACHE_MAX_BRICKS);
+	}
+}
+
+void VulkanResources::updateFrameState(uint32_t imageIndex)
+{
+	FrameState state = {};
+	updateTemporalState(state);
+	state.marchLod = glm::vec4(frame->adaptivePrecision ? Settings::FRACTAL_PIXEL_FOOTPRINT : 0.0f,
+		frame->iterationLod ? Settings::FRACTAL_LOD_DISTANCE : 0.0f, Settings::FRACTAL_LOD_ITERATIONS, 0.0f);
+	state.sceneBounds = frame->sceneBounds;
+
+	//only the compute paths reconstruct, the fragment path always shades every pixel
+	bool computePath = frame->fractalPath != FractalPaths::eFragment;
+	FractalShading shading = computePath ? frame->fractalShading : FractalShading::eFull;
+	uint32_t phase = 0;
+	if (shading == FractalShading::eCheckerboard)
+	{
+		phase = shadingFrame % 2;
+	}
+	else if (shading == FractalShading::eQuarter)
+	{
+		phase = shadingFrame % 4;
+	}
+	state.shading = glm::uvec4(toUType(shading), phase, shadingHistoryValid ? 1 : 0, 0);
+	shadingFrame++;
+	shadingHistoryValid = computePath;
+	memcpy(frameStateBuffersMapped[imageIndex], &state, sizeof(FrameState));
+}
+
+void VulkanResources::updateTemporalState(FrameState& state)
+{
+	if (!frame->temporal)
+	{
+		state.temporalFlags = glm::uvec4(0, 0, UINT32_MAX, 0);
+		historyValid = false;
+		temporalReproject = false;
+		return;
+	}
+
+	//last frame's hits only mean something for the same distance field
+	FractalParameters parameters = getFractalParameters();
+	vk::Extent2D extent = getMarchExtent();
+	temporalReproject = historyValid && parameters == historyParameters && frame->deepZoom == historyDeepZoom && extent == historyExtent;
+
+	uint32_t pixelCount = extent.width * extent.height;
+	uint32_t readPlane = historyFrame % 2;
+	//offset is taken in double so it stays exact when the camera is zoomed in
+	state.previousOffset = glm::vec4(glm::vec3(historyCamera.position - frame->camera.position), historyCamera.focalLength);
+	state.previousHorizontal = glm::vec4(historyCamera.right, (float)extent.width / extent.height);
+	state.previousVertical = glm::vec4(historyCamera.up, 0.0f);
+	state.previousDirection = glm::vec4(historyCamera.direction, 0.0f);
+	//the refresh pixel stays for a whole shading pattern cycle so reduced shading marches it at least once
+	uint32_t refreshPhase = historyFrame;
+	if (frame->fractalPath != FractalPaths::eFragment)
+	{
+		if (frame->fractalShading == FractalShading::eCheckerboard)
+		{
+			refreshPhase /= 2;
+		}
+		else if (frame->fractalShading == FractalShading::eQuarter)
+		{
+			refreshPhase /= 4;
+		}
+	}
+	state.temporalFlags = glm::uvec4(temporalReproject ? 1 : 0, readPlane * pixelCount, (1 - readPlane) * pixelCount, refreshPhase % 16);
+
+	historyCamera = frame->camera;
+	historyParameters = parameters;
+	historyDeepZoom = frame->deepZoom;
+	historyExtent = extent;
+	historyValid = true;
+	historyFrame++;
+}
+
+void VulkanResources::recordTemporalReproject(vk::CommandBuffer commandBuffer, uint32_t imageIndex, FractalPushConstants pushConstants)
+{
+	//last frame wrote the plane read here, and read the plane and reprojection written here
+	vk::MemoryBarrier historyBarrier(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+		vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader,
+		{}, historyBarrier, {}, {});
+
+	if (!temporalReproject)
+	{
+		return;
+	}
+
+	commandBuffer.fillBuffer(temporalReprojection, 0, VK_WHOLE_SIZE, UINT32_MAX);
+	vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+		{}, clearBarrier, {}, {});
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, reprojectPipelineData.pipeline);
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, reprojectPipelineData.layout, 0, fractalSets[imageIndex], nullptr);
+	commandBuffer.pushConstants(reprojectPipelineData.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(FractalPushConstants), &pushConstants);
+	vk::Extent2D extent = getMarchExtent();
+	commandBuffer.dispatch((extent.width + 7) / 8, (extent.height + 7) / 8, 1);
+
+	vk::MemoryBarrier scatterBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader |
+		vk::PipelineStageFlagBits::eFragmentShader, {}, scatterBarrier, {}, {});
+}
+
+void VulkanResources::recordFractalCapture(vk::CommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	vk::ImageSubresourceRange subresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+	vk::ImageMemoryBarrier copyBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead,
+		vk::ImageLayout::eGeneral, vk::ImageLayout::eGeneral, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+		fractalImage, subresourceRange);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer,
+		{}, {}, {}, copyBarrier);
+
+	vk::BufferImageCopy region(0, 0, 0, vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+		{ 0, 0, 0 }, { fractalExtent.width, fractalExtent.height, 1 });
+	commandBuffer.copyImageToBuffer(fractalImage, vk::ImageLayout::eGeneral, captureBuffer, region);
+
+	vk::MemoryBarrier hostBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+		{}, hostBarrier, {}, {});
+
+	capturePending = false;
+	captureImage = imageIndex;
+}
+
+void VulkanResources::readFractalCapture()
+{
+	captureImage.reset();
+	std::lock_guard<std::mutex> lock(resultsMutex);
+	capturedExtent = fractalExtent;
+	capturedPixels.resize((size_t)fractalExtent.width * fractalExtent.height * 4);
+	memcpy(capturedPixels.data(), captureBufferMapped, capturedPixels.size());
+	captureReady = true;
+}
+
+bool VulkanResources::takeFractalCapture(std::vector<uint8_t>& pixels, vk::Extent2D& extent)
+{
+	std::lock_guard<std::mutex> lock(resultsMutex);
+	if (!captureReady)
+	{
+		return false;
+	}
+
+	captureReady = false;
+	pixels = std::move(capturedPixels);
+	extent = capturedExtent;
+	return true;
+}
+
+void VulkanResources::collectImageResults(uint32_t imageIndex)
+{
+	readFractalTime(imageIndex);
+	if (cacheReportImage == imageIndex)
+	{
+		reportDistanceCache();
+	}
+	if (captureImage == imageIndex)
+	{
+		readFractalCapture();
+		//the pixels were handed to the update thread, the next capture allocates them again
+		frameAllocations.rewarm();
+	}
+}
+
+void VulkanResources::readFractalTime(uint32_t imageIndex)
+{
+	if (timestampPeriod == 0.0f)
+	{
+		return;
+	}
+
+	std::array<uint64_t, 2> timestamps = {};
+	auto result = device.getQueryPoolResults(queryPool, 2 * imageIndex, 2, sizeof(timestamps), timestamps.data(),
+		sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+	if (result == vk::Result::eSuccess)
+	{
+		fractalTime = (float)((timestamps[1] - timestamps[0]) * timestampPeriod / 1000000.0);
+	}
 }
 
-short VulkanResources::addSprite(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
-	vk::Sampler sampler, Texture* texture, GraphicsComponent* object)
+SpriteHandle VulkanResources::addSprite(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
+	vk::Sampler sampler, Texture* texture)
 {
-	return spritesToRender->addSprite(posX, posY, layer, sizeX, sizeY, rotation, sampler, texture, object);
+	return spritesToRender->addSprite(posX, posY, layer, sizeX, sizeY, rotation, sampler, texture);
 }
 
-void VulkanResources::removeSprite(unsigned short index)
+void VulkanResources::removeSprite(SpriteHandle sprite)
 {
-	spritesToRender->removeSprite(index);
+	spritesToRender->removeSprite(sprite);
 }
 
 bool checkValidationLayerSupport()
 {
 	std::vector<vk::LayerProperties> availableLayers = vk::enumerateInstanceLayerProperties();
 
-	std::cout << "available layers: \n";
+	LOG_DEBUG("available layers: ");
 	for (auto const& layerProperties : availableLayers)
 	{
-		std::cout << "\t" << layerProperties.layerName << "\n";
+		LOG_DEBUG("\t{}", layerProperties.layerName);
 	}
 
 	for (auto layerName : validationLayers)
@@ -1034,12 +2510,12 @@ bool checkValidationLayerSupport()
 
 		if (!layerFound)
 		{
-			std::cout << layerName << " layer couldn't be found\n";
+			LOG_WARNING("{} layer couldn't be found", layerName);
 			return false;
 		}
 		else
 		{
-			std::cout << layerName << " layer is active\n";
+			LOG_DEBUG("{} layer is active", layerName);
 		}
 	}
 
@@ -1054,20 +2530,20 @@ std::vector<char const*> getRequiredExtensions()
 
 	std::vector<char const*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 
-	if (enableValidationLayers)
+	if (Settings::VALIDATION_LAYERS)
 	{
 		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 	}
 
 	std::vector<vk::ExtensionProperties> availableExtensions = vk::enumerateInstanceExtensionProperties();
-	std::cout << "available extensions: \n";
+	LOG_DEBUG("available extensions: ");
 
 	for (auto const& extension : availableExtensions)
 	{
-		std::cout << "\t" << extension.extensionName << "\n";
+		LOG_DEBUG("\t{}", extension.extensionName);
 	}
 
-	std::cout << "Total required extensions: " << extensions.size() << "\n";
+	LOG_DEBUG("Total required extensions: {}", extensions.size());
 
 	for (int i = 0; i < extensions.size(); i++)
 	{
@@ -1082,7 +2558,7 @@ std::vector<char const*> getRequiredExtensions()
 		}
 		if (extension_present)
 		{
-			std::cout << "\t" << extensions[i] << " is supported\n";
+			LOG_DEBUG("\t{} is supported", extensions[i]);
 		}
 		else
 		{
@@ -1116,11 +2592,14 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
 	return VK_FALSE;
 }
 
-//sets bool in Game
+//runs on the update thread while it polls events
 static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
 {
 	auto program = reinterpret_cast<VulkanResources*>(glfwGetWindowUserPointer(window));
-	program->game->setWindowWasResized();
+	program->framebufferWidth = (uint32_t)width;
+	program->framebufferHeight = (uint32_t)height;
+	program->framebufferResized = true;
+	program->wakeRenderThread();
 }
 
 static void mouseWheelMoveCallback(GLFWwindow* window, double xOffset, double yOffset)
@@ -1129,33 +2608,46 @@ static void mouseWheelMoveCallback(GLFWwindow* window, double xOffset, double yO
 	program->game->mWheelMovement = yOffset;
 }
 
-bool isDeviceSuitable(vk::PhysicalDevice device, vk::SurfaceKHR surface, QueueFamilyIndices const& indices)
+//key repeats don't change the state
+static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-	vk::PhysicalDeviceProperties deviceProperties = device.getProperties();
-	std::cout << deviceProperties.deviceName << " is being queried\n";
-
-	std::cout << deviceProperties.limits.maxVertexInputBindings << " max vertex input bindings\n";
-	std::cout << deviceProperties.limits.maxDescriptorSetUniformBuffers << " max descriptor set uniform buffers\n";
-	std::cout << deviceProperties.limits.maxMemoryAllocationCount << " max memory allocation count\n";
-	std::cout << deviceProperties.limits.maxBoundDescriptorSets << " max bound descriptor sets\n";
-	std::cout << deviceProperties.limits.maxPushConstantsSize << " max push constants size\n";
-	std::cout << deviceProperties.limits.maxComputeSharedMemorySize << " max compute shader memory size\n";
-	std::cout << deviceProperties.limits.maxImageDimension2D << " max 2D image dimension\n";
-	std::cout << deviceProperties.vendorID << " vendor id\n";
-	if (deviceProperties.vendorID == 0x8086)
+	if (action == GLFW_REPEAT)
 	{
-		return false;
+		return;
 	}
+	auto program = reinterpret_cast<VulkanResources*>(glfwGetWindowUserPointer(window));
+	program->game->input.push(key, action == GLFW_PRESS, glfwGetTime());
+}
+
+static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+	auto program = reinterpret_cast<VulkanResources*>(glfwGetWindowUserPointer(window));
+	program->game->input.push(button, action == GLFW_PRESS, glfwGetTime());
+}
+
+bool isDeviceSuitable(vk::PhysicalDevice device, vk::SurfaceKHR surface, QueueFamilyIndices const& indices)
+{
+	vk::PhysicalDeviceProperties deviceProperties = device.getProperties();
+	LOG_DEBUG("{} is being queried", deviceProperties.deviceName);
+
+	LOG_DEBUG("{} max vertex input bindings", deviceProperties.limits.maxVertexInputBindings);
+	LOG_DEBUG("{} max descriptor set uniform buffers", deviceProperties.limits.maxDescriptorSetUniformBuffers);
+	LOG_DEBUG("{} max memory allocation count", deviceProperties.limits.maxMemoryAllocationCount);
+	LOG_DEBUG("{} max bound descriptor sets", deviceProperties.limits.maxBoundDescriptorSets);
+	LOG_DEBUG("{} max push constants size", deviceProperties.limits.maxPushConstantsSize);
+	LOG_DEBUG("{} max compute shader memory size", deviceProperties.limits.maxComputeSharedMemorySize);
+	LOG_DEBUG("{} max 2D image dimension", deviceProperties.limits.maxImageDimension2D);
+	LOG_DEBUG("{} vendor id", deviceProperties.vendorID);
 
 	std::vector<vk::QueueFamilyProperties> queueFamilies = device.getQueueFamilyProperties();
-	std::cout << "Total number of queue families: " << queueFamilies.size() << "\n";
+	LOG_DEBUG("Total number of queue families: {}", queueFamilies.size());
 
 	if (indices.isComplete())
 	{
-		std::cout << "graphics queue family index: " << indices.graphicsFamily.value() << "\n";
-		std::cout << "present queue family index: " << indices.presentFamily.value() << "\n";
-		std::cout << "Number of graphics queues: " << queueFamilies[indices.graphicsFamily.value()].queueCount << "\n";
-		std::cout << "Number of present queues: " << queueFamilies[indices.presentFamily.value()].queueCount << "\n";
+		LOG_DEBUG("graphics queue family index: {}", indices.graphicsFamily.value());
+		LOG_DEBUG("present queue family index: {}", indices.presentFamily.value());
+		LOG_DEBUG("Number of graphics queues: {}", queueFamilies[indices.graphicsFamily.value()].queueCount);
+		LOG_DEBUG("Number of present queues: {}", queueFamilies[indices.presentFamily.value()].queueCount);
 	}
 
 	bool extensionsSupported = checkDeviceExtensionSupport(device);
@@ -1170,19 +2662,24 @@ bool isDeviceSuitable(vk::PhysicalDevice device, vk::SurfaceKHR surface, QueueFa
 	vk::PhysicalDeviceFeatures supportedFeatures = device.getFeatures();
 	if (supportedFeatures.samplerAnisotropy)
 	{
-		std::cout << "sampler anisotropy is supported\n";
+		LOG_DEBUG("sampler anisotropy is supported");
 	}
 	else
 	{
-		std::cout << "sampler anisotropy is not supported\n";
+		LOG_WARNING("sampler anisotropy is not supported");
+	}
+
+	if (!supportedFeatures.fragmentStoresAndAtomics)
+	{
+		LOG_WARNING("fragment stores and atomics are not supported");
 	}
 
 	bool deviceIsSuitable = indices.isComplete() && extensionsSupported &&
-		swapChainAdequate && supportedFeatures.samplerAnisotropy;
+		swapChainAdequate && supportedFeatures.samplerAnisotropy && supportedFeatures.fragmentStoresAndAtomics;
 
 	if (deviceIsSuitable)
 	{
-		std::cout << deviceProperties.deviceName << " was picked as a suitable GPU\n";
+		LOG_DEBUG("{} is a suitable GPU", deviceProperties.deviceName);
 	}
 
 	return deviceIsSuitable;
@@ -1224,10 +2721,10 @@ bool checkDeviceExtensionSupport(vk::PhysicalDevice device)
 {
 	std::vector<vk::ExtensionProperties> availableExtensions = device.enumerateDeviceExtensionProperties();
 
-	std::cout << "supported extensions: \n";
+	LOG_DEBUG("supported extensions: ");
 	for (auto const& extension : availableExtensions)
 	{
-		std::cout << "\t" << extension.extensionName << "\n";
+		LOG_DEBUG("\t{}", extension.extensionName);
 	}
 
 	std::unordered_set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
@@ -1236,7 +2733,7 @@ bool checkDeviceExtensionSupport(vk::PhysicalDevice device)
 	{
 		if (requiredExtensions.erase(extension.extensionName) == 1)
 		{
-			std::cout << extension.extensionName << " is supported\n";
+			LOG_DEBUG("{} is supported", extension.extensionName);
 		}
 	}
 
@@ -1264,57 +2761,49 @@ vk::SurfaceFormatKHR chooseSwapSurfaceFormat(std::vector<vk::SurfaceFormatKHR> c
 		if (availableFormat.format == vk::Format::eB8G8R8A8Unorm &&
 			availableFormat.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear)
 		{
-			std::cout << "swap surface format is B8G8R8A8Unorm with SRGB color space supported\n";
+			LOG_DEBUG("swap surface format is B8G8R8A8Unorm with SRGB color space supported");
 			return availableFormat;
 		}
 	}
 
-	std::cout << "swap surface format is " << (int)availableFormats[0].format <<
-		" with " << (int)availableFormats[0].colorSpace << " color space\n";
+	LOG_DEBUG("swap surface format is {} with {} color space", (int)availableFormats[0].format, (int)availableFormats[0].colorSpace);
 
 	return availableFormats[0];
 }
 
-vk::PresentModeKHR chooseSwapPresentMode(std::vector<vk::PresentModeKHR> const& availablePresentModes)
+vk::PresentModeKHR chooseSwapPresentMode(std::vector<vk::PresentModeKHR> const& availablePresentModes, vk::PresentModeKHR preferred)
 {
 	for (auto const& availablePresentMode : availablePresentModes)
 	{
-		if (availablePresentMode == vk::PresentModeKHR::eMailbox)
+		if (availablePresentMode == preferred)
 		{
-			std::cout << "swap present mode is Mailbox\n";
+			LOG_INFO("swap present mode is {}", vk::to_string(availablePresentMode));
 			return availablePresentMode;
 		}
 	}
 
-	std::cout << "swap present mode is FIFO\n";
+	//every surface supports fifo
+	LOG_WARNING("{} present mode isn't supported, swap present mode is FIFO", vk::to_string(preferred));
 	return vk::PresentModeKHR::eFifo;
 }
 
-vk::Extent2D chooseSwapExtent(vk::SurfaceCapabilitiesKHR const& capabilities, GLFWwindow* window)
+vk::Extent2D chooseSwapExtent(vk::SurfaceCapabilitiesKHR const& capabilities, vk::Extent2D framebufferSize)
 {
 	if (capabilities.currentExtent.width != UINT32_MAX)
 	{
-		std::cout << "swap extent is " << capabilities.currentExtent.width <<
-			"x" << capabilities.currentExtent.height << "\n";
+		LOG_INFO("swap extent is {}x{}", capabilities.currentExtent.width, capabilities.currentExtent.height);
 		return capabilities.currentExtent;
 	}
 	else
 	{
-		int width, height;
-		glfwGetFramebufferSize(window, &width, &height);
-
-		vk::Extent2D actualExtent = {
-			(uint32_t)(width),
-			(uint32_t)(height)
-		};
+		vk::Extent2D actualExtent = framebufferSize;
 
 		actualExtent.width = std::max(capabilities.minImageExtent.width,
 			std::min(capabilities.maxImageExtent.width, actualExtent.width));
 		actualExtent.height = std::max(capabilities.minImageExtent.height,
 			std::min(capabilities.maxImageExtent.height, actualExtent.height));
 
-		std::cout << "swap extent is " << actualExtent.width <<
-			"x" << actualExtent.height << "\n";
+		LOG_INFO("swap extent is {}x{}", actualExtent.width, actualExtent.height);
 		return actualExtent;
 	}
 }
@@ -1354,38 +2843,145 @@ vk::SampleCountFlagBits getMaxUsableSampleCount(vk::PhysicalDevice physicalDevic
 		physicalDeviceProperties.limits.framebufferDepthSampleCounts;
 	if (counts & vk::SampleCountFlagBits::e64)
 	{
-		std::cout << "max msaa samples are 64\n";
+		LOG_DEBUG("max msaa samples are 64");
 		return vk::SampleCountFlagBits::e64;
 	}
 	if (counts & vk::SampleCountFlagBits::e32)
 	{
-		std::cout << "max msaa samples are 32\n";
+		LOG_DEBUG("max msaa samples are 32");
 		return vk::SampleCountFlagBits::e32;
 	}
 	if (counts & vk::SampleCountFlagBits::e16)
 	{
-		std::cout << "max msaa samples are 16\n";
+		LOG_DEBUG("max msaa samples are 16");
 		return vk::SampleCountFlagBits::e16;
 	}
 	if (counts & vk::SampleCountFlagBits::e8)
 	{
-		std::cout << "max msaa samples are 8\n";
+		LOG_DEBUG("max msaa samples are 8");
 		return vk::SampleCountFlagBits::e8;
 	}
 	if (counts & vk::SampleCountFlagBits::e4)
 	{
-		std::cout << "max msaa samples are 4\n";
+		LOG_DEBUG("max msaa samples are 4");
 		return vk::SampleCountFlagBits::e4;
 	}
 	if (counts & vk::SampleCountFlagBits::e2)
 	{
-		std::cout << "max msaa samples are 2\n";
+		LOG_DEBUG("max msaa samples are 2");
 		return vk::SampleCountFlagBits::e2;
 	}
-	std::cout << "max msaa samples are 2\n";
+	LOG_DEBUG("max msaa samples are 1");
 	return vk::SampleCountFlagBits::e1;
 }
 
+DeviceCapabilities queryDeviceCapabilities(vk::PhysicalDevice device)
+{
+	DeviceCapabilities capabilities;
+
+	vk::PhysicalDeviceProperties deviceProperties = device.getProperties();
+	capabilities.type = deviceProperties.deviceType;
+
+	vk::PhysicalDeviceMemoryProperties memoryProperties = device.getMemoryProperties();
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+	{
+		if (memoryProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+		{
+			capabilities.localMemory += memoryProperties.memoryHeaps[i].size;
+		}
+	}
+
+	//families with transfer but neither graphics nor compute are usually the copy engines
+	std::vector<vk::QueueFamilyProperties> queueFamilies = device.getQueueFamilyProperties();
+	for (uint32_t i = 0; i < (uint32_t)queueFamilies.size(); i++)
+	{
+		vk::QueueFlags flags = queueFamilies[i].queueFlags;
+		if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
+		{
+			capabilities.transferFamily = i;
+			break;
+		}
+	}
+
+	capabilities.maxSamples = getMaxUsableSampleCount(device);
+
+	if (deviceProperties.apiVersion >= VK_API_VERSION_1_1)
+	{
+		auto properties = device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>();
+		auto const& subgroupProperties = properties.get<vk::PhysicalDeviceSubgroupProperties>();
+		capabilities.subgroupSize = subgroupProperties.subgroupSize;
+		if (subgroupProperties.supportedStages & vk::ShaderStageFlagBits::eCompute)
+		{
+			capabilities.subgroupOperations = subgroupProperties.supportedOperations;
+		}
+	}
+
+	//both are core in vulkan 1.2 but still optional there
+	if (deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+	{
+		auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		auto const& vulkan12Features = features.get<vk::PhysicalDeviceVulkan12Features>();
+		capabilities.timelineSemaphores = vulkan12Features.timelineSemaphore;
+		capabilities.descriptorIndexing = vulkan12Features.descriptorIndexing;
+	}
+
+	return capabilities;
+}
+
+//device type decides, device local memory breaks ties between devices of one type
+//0 for software devices unless ALLOW_SOFTWARE_DEVICE is set
+uint64_t scoreDevice(DeviceCapabilities const& capabilities)
+{
+	uint64_t typeRank = 0;
+	switch (capabilities.type)
+	{
+	case vk::PhysicalDeviceType::eDiscreteGpu:
+		typeRank = 4;
+		break;
+	case vk::PhysicalDeviceType::eIntegratedGpu:
+		typeRank = 3;
+		break;
+	case vk::PhysicalDeviceType::eVirtualGpu:
+		typeRank = 2;
+		break;
+	case vk::PhysicalDeviceType::eCpu:
+		typeRank = Settings::ALLOW_SOFTWARE_DEVICE ? 1 : 0;
+		break;
+	default:
+		typeRank = 1;
+		break;
+	}
+
+	if (typeRank == 0)
+	{
+		return 0;
+	}
+	//memory in MiB stays far below 2^40, so a better type always wins
+	return typeRank << 40 | capabilities.localMemory >> 20;
+}
+
+void reportDeviceCapabilities(vk::PhysicalDeviceProperties const& properties, DeviceCapabilities const& capabilities)
+{
+	LOG_INFO("{} capabilities:", properties.deviceName);
+	LOG_INFO("\ttype: {}", vk::to_string(capabilities.type));
+	LOG_INFO("\tvulkan {}.{}.{}", VK_VERSION_MAJOR(properties.apiVersion), VK_VERSION_MINOR(properties.apiVersion),
+		VK_VERSION_PATCH(properties.apiVersion));
+	LOG_INFO("\tdevice local memory: {} MiB", capabilities.localMemory >> 20);
+	if (capabilities.transferFamily.has_value())
+	{
+		LOG_INFO("\tdedicated transfer queue family: {}", capabilities.transferFamily.value());
+	}
+	else
+	{
+		LOG_INFO("\tdedicated transfer queue family: none");
+	}
+	LOG_INFO("\ttimeline semaphores: {}", capabilities.timelineSemaphores);
+	LOG_INFO("\tdescriptor indexing: {}", capabilities.descriptorIndexing);
+	LOG_INFO("\tsubgroup size: {}", capabilities.subgroupSize);
+	LOG_INFO("\tcompute subgroup operations: {}", vk::to_string(capabilities.subgroupOperations));
+	LOG_INFO("\tmax msaa samples: {}", (uint32_t)capabilities.maxSamples);
+}
+
 std::vector<char> readFile(std::string const& filename)
 {
 	std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -1495,6 +3091,14 @@ void VulkanResources::transitionImageLayout(vk::Image image, vk::Format format,
 		sourceStage = vk::PipelineStageFlagBits::eTransfer;
 		destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
 	}
+	else if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eGeneral)
+	{
+		barrier.srcAccessMask = {};
+		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+		sourceStage = vk::PipelineStageFlagBits::eTopOfPipe;
+		destinationStage = vk::PipelineStageFlagBits::eComputeShader;
+	}
 	else if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal)
 	{
 		barrier.srcAccessMask = {};
@@ -1653,7 +3257,7 @@ void loadModel(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
 		{{-1.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f}}
 	};
 	indices = { 0, 1, 2, 2, 3, 0 };
-	std::cout << "loaded quad vertices and indices\n";
+	LOG_DEBUG("loaded quad vertices and indices");
 }
 
 void copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size,
@@ -1678,9 +3282,9 @@ ShaderModulePair::ShaderModulePair(std::string const& vertFilename, std::string
 	auto fragShaderCode = readFile(fragFilename);
 
 	vertShaderModule = createShaderModule(vertShaderCode, device);
-	std::cout << "created vertex shader module\n";
+	LOG_DEBUG("created vertex shader module");
 	fragShaderModule = createShaderModule(fragShaderCode, device);
-	std::cout << "created fragment shader module\n";
+	LOG_DEBUG("created fragment shader module");
 
 	createShaderStages();
 }
@@ -1690,12 +3294,12 @@ ShaderModulePair::~ShaderModulePair()
 	if (fragShaderModule)
 	{
 		device.destroyShaderModule(fragShaderModule);
-		std::cout << "destroyed frag shader module\n";
+		LOG_DEBUG("destroyed frag shader module");
 	}
 	if (vertShaderModule)
 	{
 		device.destroyShaderModule(vertShaderModule);
-		std::cout << "destroyed vert shader module\n";
+		LOG_DEBUG("destroyed vert shader module");
 	}
 }
 
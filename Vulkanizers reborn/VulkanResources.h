@@ -8,6 +8,14 @@
 
 #include "Constants.h"
 #include "Sprite.h"
+#include "ReferenceOrbit.h"
+#include "Camera.h"
+#include "FrameSnapshot.h"
+#include "TripleBuffer.h"
+#include "JobSystem.h"
+#include "ShaderReloader.h"
+#include "FrameArena.h"
+#include "AllocationCheck.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/hash.hpp>
@@ -23,6 +31,12 @@
 #include <chrono>
 #include <unordered_map>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <utility>
 
 class Game;
 struct Vertex;
@@ -39,6 +53,19 @@ struct QueueFamilyIndices
 	}
 };
 
+//what the picked device offers past what every path needs, the renderer checks these before taking a faster path
+struct DeviceCapabilities
+{
+	vk::PhysicalDeviceType type = vk::PhysicalDeviceType::eOther;
+	uint64_t localMemory = 0;							//bytes in device local heaps, shared system memory on integrated gpus
+	std::optional<uint32_t> transferFamily;				//family with transfer but no graphics or compute, copies there overlap rendering
+	bool timelineSemaphores = false;
+	bool descriptorIndexing = false;
+	uint32_t subgroupSize = 1;							//1 before vulkan 1.1
+	vk::SubgroupFeatureFlags subgroupOperations;		//available in compute shaders
+	vk::SampleCountFlagBits maxSamples = vk::SampleCountFlagBits::e1;	//for color and depth alike
+};
+
 struct GraphicsPipelineData
 {
 	vk::DescriptorSetLayout descriptorSetLayout;
@@ -46,6 +73,70 @@ struct GraphicsPipelineData
 	vk::Pipeline pipeline;
 };
 
+struct ComputePipelineData
+{
+	vk::DescriptorSetLayout descriptorSetLayout;
+	vk::PipelineLayout layout;
+	vk::Pipeline pipeline;
+};
+
+//matches the push constant block in fractal_common.glsl, at the 128 bytes every device guarantees
+struct FractalPushConstants
+{
+	glm::vec4 data;
+	glm::vec4 cameraPos;
+	glm::vec4 cameraHorizontal;
+	glm::vec4 cameraVertical;
+	glm::vec4 cameraDirection;
+	glm::vec4 juliaC;
+	glm::vec4 marchPass;
+	glm::vec4 cameraLow;
+};
+
+//everything the distance field depends on, the distance cache is rebaked when it changes
+struct FractalParameters
+{
+	int estimator = -1;
+	float fractalData[2] = {};
+	float iterations = 0.0f;
+	glm::vec4 juliaC = glm::vec4(0.0f);
+
+	bool operator==(FractalParameters const& other) const
+	{
+		return estimator == other.estimator && fractalData[0] == other.fractalData[0] && fractalData[1] == other.fractalData[1] &&
+			iterations == other.iterations && juliaC == other.juliaC;
+	}
+	bool operator!=(FractalParameters const& other) const { return !(*this == other); }
+};
+
+//matches the FrameState block in fractal_common.glsl
+struct FrameState
+{
+	glm::vec4 previousOffset;
+	glm::vec4 previousHorizontal;
+	glm::vec4 previousVertical;
+	glm::vec4 previousDirection;
+	glm::uvec4 temporalFlags;
+	glm::vec4 marchLod;
+	glm::uvec4 shading;
+	glm::vec4 sceneBounds;
+};
+
+//inputs a secondary command buffer was recorded with, it's executed again as long as they don't change
+struct RecordedPass
+{
+	bool valid = false;
+	std::vector<SpriteDraw> draws;	//sprite passes
+	FractalPaths fractalPath = FractalPaths::eFragment;	//fractal pass
+	FractalPushConstants pushConstants = {};
+};
+
+//compute pass types in fractal_shader.comp
+enum class MarchPasses
+{
+	ePrimary, eContinue, ePrepare, eReconstruct
+};
+
 class ShaderModulePair
 {
 public:
@@ -86,6 +177,8 @@ struct PipelineCreateData
 
 static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
 static void mouseWheelMoveCallback(GLFWwindow* window, double xOffset, double yOffset);
+static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 std::vector<char> readFile(std::string const& filename);
 
 class VulkanResources
@@ -96,11 +189,16 @@ public:
 
 	void recreateSwapChain();
 	void waitUntilDeviceIsIdle() { device.waitIdle(); }
-	void drawFrame();
+	//draw the newest snapshot on a render thread until stopRendering, one has to be published first
+	//an exception on the render thread closes the window, stopRendering rethrows it on the calling thread
+	void startRendering();
+	void stopRendering();
+	//a snapshot that looks different was published, on demand the render thread waits for this
+	void wakeRenderThread();
 
-	short addSprite(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
-		vk::Sampler sampler, Texture* texture, GraphicsComponent* object);	//returns index of sprite in pool
-	void removeSprite(unsigned short index);
+	SpriteHandle addSprite(float posX, float posY, SpriteLayers layer, float sizeX, float sizeY, float rotation,
+		vk::Sampler sampler, Texture* texture);	//returns handle of sprite in pool
+	void removeSprite(SpriteHandle sprite);
 
 	vk::ImageView createImageView(vk::Image image, vk::Format format,
 		vk::ImageAspectFlags aspectFlags, uint32_t mipLevels);
@@ -121,17 +219,33 @@ public:
 	vk::Device device;
 	std::vector<vk::Image> swapChainImages;
 	vk::Extent2D swapChainExtent;
-	vk::DescriptorPool descriptorPool;
+	vk::Extent2D fractalExtent;	//compute fractal paths march at this size, the swap chain extent scaled by RESOLUTION_SCALE
 	vk::CommandPool commandPool;
 	vk::Queue graphicsQueue;
 	std::vector<GraphicsPipelineData> graphicsPipelinesData;
+	vk::DescriptorSetLayout spriteTextureSetLayout;	//set 1 of the sprite pipelines
 
 	vk::Sampler textureSampler;
-	std::array<Texture, Settings::MAX_TEXTURES> textures;
+	std::deque<Texture> textures;	//grows without moving loaded textures, sprites point into it
 
-	std::unique_ptr<SpritePool> spritesToRender;
+	std::unique_ptr<SpritePool> spritesToRender;		//update thread's sprites, outlive the swap chain
+	std::unique_ptr<SpriteResources> spriteResources;	//render thread's buffers for them
+
+	TripleBuffer<FrameSnapshot> frames;	//written by the update thread, the render thread draws the newest
 
 	size_t currentFrame = 0;
+	float fractalTime = -1.0f;	//gpu time of the fractal pass in ms, negative if timestamps are unsupported
+	float inputLatency = -1.0f;	//of the last drawn frame, see FrameResult
+
+	//hand over the results of the frames submitted since the last call
+	void takeFrameResults(std::vector<FrameResult>& results);
+	//true once a capture requested through FrameSnapshot::captureRequests finished, rgba8 rows
+	bool takeFractalCapture(std::vector<uint8_t>& pixels, vk::Extent2D& extent);
+
+	//set by the framebuffer callback on the update thread, glfw can't be queried from the render thread
+	std::atomic<bool> framebufferResized{ false };
+	std::atomic<uint32_t> framebufferWidth{ 0 };
+	std::atomic<uint32_t> framebufferHeight{ 0 };
 
 private:
 	void initWindow();
@@ -147,26 +261,80 @@ private:
 	void createImageViews();
 	void createRenderPass();
 	void createGraphicsPipelines();
+	vk::Pipeline createFractalPipeline();
+	vk::Pipeline createCompositePipeline();
+	void createComputePipelines();
+	vk::Pipeline createComputePipeline(std::string const& shaderFilename, vk::PipelineLayout layout);
+	//build the fractal pipelines from the spv files on disk, called on the shader reloader's thread
+	FractalPipelines buildFractalPipelines();
+	//swap in pipelines the shader reloader finished and destroy the ones no frame in flight uses anymore
+	void swapReloadedPipelines();
+	void destroyFractalPipelines(FractalPipelines const& pipelines);
 	void createCommandPool();
 	void createColorResources();
 	void createDepthResources();
 	void createFramebuffers();
+	void createDistanceCache();
+	void createFractalResources();
+	void createQueryPool();
 	void createTextures();
 	void createTextureSampler();
 	void createVertexBuffer();
 	void createIndexBuffer();
-	void createDescriptorPool();
 	void createCommandBuffers();
 	void createSyncObjects();
-
-	void createSprites();
+	void destroySyncObjects();
+	//block until the frame with this number has retired on the gpu, timeline only
+	void waitForFrame(uint64_t frameNumber);
+	//throw if the timeline went backwards, is behind a frame that was waited for or ahead of the frames submitted
+	void checkFrameOrder(uint64_t waitedFrame);
+	//follow the snapshot's frames in flight and present mode, false if the swap chain was recreated and nothing drawn
+	bool applyPresentationSettings();
+
+	//catches what renderFrames throws for stopRendering
+	void renderLoop();
+	void renderFrames();
+	//frames a picture keeps improving after it changed, reduced shading and temporal refresh fill in over several
+	uint32_t refinementFrames() const;
+	//true while a frame has to be drawn for work that finishes on a later frame, like a bake report or a capture readback
+	bool readbackPending() const;
+	//returns false if no frame was submitted
+	bool drawFrame();
+	//rewrite the changed mvps of this image, more sprites than ever before restart the allocation warmup
 	void updateSprites(uint32_t imageIndex);
 	void updateCommandBuffer(uint32_t imageIndex);
+	//rerecord the secondary command buffers whose inputs changed, in parallel on the record jobs
+	void recordRenderPasses(uint32_t imageIndex, FractalPushConstants const& pushConstants);
+	void beginRenderPassCommands(vk::CommandBuffer commandBuffer, uint32_t imageIndex);
+	void recordSpritePass(uint32_t imageIndex, uint32_t pass);
+	void recordFractalPass(uint32_t imageIndex, FractalPushConstants const& pushConstants);
+	FractalPushConstants getFractalPushConstants() const;
+	//pixels the frame's fractal path marches, the fragment path always draws at the swap chain extent
+	vk::Extent2D getMarchExtent() const;
+	void recordFractalCompute(vk::CommandBuffer commandBuffer, uint32_t imageIndex, FractalPushConstants& pushConstants);
+	//read what the image's last submission measured and copied back, it has to be done
+	void collectImageResults(uint32_t imageIndex);
+	void readFractalTime(uint32_t imageIndex);
+	//recompute the deep zoom reference orbit and upload it for this image
+	void updateReferenceOrbit(uint32_t imageIndex);
+	FractalParameters getFractalParameters() const;
+	//invalidate the distance cache on parameter changes, schedule a bake once they settle
+	void updateDistanceCache();
+	void recordCacheBake(vk::CommandBuffer commandBuffer, uint32_t imageIndex, FractalPushConstants pushConstants);
+	void reportDistanceCache();
+	//write the values that don't fit in the push constants for this image
+	void updateFrameState(uint32_t imageIndex);
+	//hand the last frame's camera and history plane to the shaders, decide if it can be reprojected
+	void updateTemporalState(FrameState& state);
+	void recordTemporalReproject(vk::CommandBuffer commandBuffer, uint32_t imageIndex, FractalPushConstants pushConstants);
+	void recordFractalCapture(vk::CommandBuffer commandBuffer, uint32_t imageIndex);
+	void readFractalCapture();
 
 	vk::DynamicLoader dynamicLoader;
 	vk::Instance instance;
 	vk::DebugUtilsMessengerEXT debugMessenger;
 	QueueFamilyIndices queueIndices;
+	DeviceCapabilities deviceCapabilities;				//of physicalDevice, filled when it's picked
 	vk::SurfaceKHR surface;
 	vk::Queue presentQueue;
 	vk::SwapchainKHR swapChain;
@@ -181,16 +349,121 @@ private:
 	vk::DeviceMemory depthImageMemory;
 	vk::ImageView depthImageView;
 	std::vector<vk::Framebuffer> swapChainFramebuffers;
+	ComputePipelineData computePipelineData;
+	ComputePipelineData bakePipelineData;				//uses the fractal pipeline's set layout
+	ComputePipelineData reprojectPipelineData;			//same
+	vk::DescriptorPool fractalDescriptorPool;
+	vk::Image fractalImage;
+	vk::DeviceMemory fractalImageMemory;
+	vk::ImageView fractalImageView;
+	std::array<vk::Buffer, 2> rayQueues;				//ping-pong queues of rays surviving a wavefront pass
+	std::array<vk::DeviceMemory, 2> rayQueuesMemory;
+	std::array<vk::Buffer, 2> rayQueueStates;			//indirect dispatch size and ray count of each queue
+	std::array<vk::DeviceMemory, 2> rayQueueStatesMemory;
+	std::array<vk::DescriptorSet, 2> fractalComputeSets;	//set i reads queue i and writes the other one
+	vk::DescriptorSet fractalCompositeSet;
+	ReferenceOrbit referenceOrbit;
+	std::vector<vk::Buffer> orbitBuffers;				//one per swap chain image, host visible and mapped
+	std::vector<vk::DeviceMemory> orbitBuffersMemory;
+	std::vector<void*> orbitBuffersMapped;
+	std::vector<vk::DescriptorSet> fractalSets;			//orbit, cache and temporal buffers, set 0 of the fractal pipeline and set 1 of the compute pipeline
+	vk::Buffer cacheCells;								//distance lower bound or brick index for every cell
+	vk::DeviceMemory cacheCellsMemory;
+	vk::Buffer cacheBricks;
+	vk::DeviceMemory cacheBricksMemory;
+	vk::Buffer cacheState;								//bricks handed out by the last bake, host visible
+	vk::DeviceMemory cacheStateMemory;
+	void* cacheStateMapped;
+	FractalParameters cacheParameters;					//parameters of the last frame the cache was checked
+	bool cacheValid = false;
+	bool cacheBakePending = false;
+	std::optional<uint32_t> cacheReportImage;			//image whose command buffer baked, report once it's done
+	std::vector<vk::Buffer> frameStateBuffers;			//FrameState, one per swap chain image, host visible and mapped
+	std::vector<vk::DeviceMemory> frameStateBuffersMemory;
+	std::vector<void*> frameStateBuffersMapped;
+	vk::Buffer temporalHistory;							//two planes of packed hit distances and step counts
+	vk::DeviceMemory temporalHistoryMemory;
+	vk::Buffer temporalReprojection;					//last frame's hits scattered into this frame's pixels
+	vk::DeviceMemory temporalReprojectionMemory;
+	Camera historyCamera;								//camera the history was rendered with
+	FractalParameters historyParameters;
+	bool historyDeepZoom = false;
+	vk::Extent2D historyExtent;							//pixels of the history, paths with another extent can't reproject it
+	bool historyValid = false;							//reset when the swap chain or the buffers change
+	uint32_t historyFrame = 0;							//picks the history plane and the refresh phase
+	bool temporalReproject = false;						//this frame starts rays at the reprojected history
+	uint32_t shadingFrame = 0;							//picks the pixels reduced shading marches
+	bool shadingHistoryValid = false;					//fractal image holds last frame's compute output
+	std::thread renderThread;
+	std::atomic<bool> rendering{ false };
+	std::exception_ptr renderError;						//written by the render thread before it ends, read after joining it
+	FrameSnapshot const* frame = nullptr;				//snapshot being drawn, render thread only
+	uint32_t framesToRefine = 0;						//frames still drawn on demand after the last change or resize
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+	bool wakeRequested = false;
+	std::mutex resultsMutex;							//guards frameResults and the finished capture
+	std::vector<FrameResult> frameResults;
+	vk::Buffer captureBuffer;							//fractal image copy for the benchmark, host visible
+	vk::DeviceMemory captureBufferMemory;
+	void* captureBufferMapped;
+	bool capturePending = false;
+	uint32_t captureRequestsSeen = 0;
+	std::optional<uint32_t> captureImage;				//image whose command buffer copies, read once it's done
+	std::vector<uint8_t> capturedPixels;
+	vk::Extent2D capturedExtent;
+	bool captureReady = false;
+	vk::QueryPool queryPool;
+	float timestampPeriod = 0.0f;	//0 if the graphics queue can't write timestamps
 	vk::Buffer vertexBuffer;
 	vk::DeviceMemory vertexBufferMemory;
 	vk::Buffer indexBuffer;
 	vk::DeviceMemory indexBufferMemory;
 	std::vector<vk::DescriptorSet> descriptorSets;
 	std::vector<vk::CommandBuffer> commandBuffers;
+	static constexpr uint32_t spritePassCount = toUType(SpriteLayers::eGUI) + 1;	//one per layer
+	static constexpr uint32_t renderPassCount = spritePassCount + 1;				//then the fractal
+	//opaque layers write depth so the fractal skips what they cover, transparent ones blend over both
+	static constexpr std::array<uint32_t, renderPassCount> passOrder = { toUType(SpriteLayers::eBackground),
+		toUType(SpriteLayers::eGround), spritePassCount, toUType(SpriteLayers::eAir), toUType(SpriteLayers::eGUI) };
+	vk::Pipeline spriteBlendPipeline;	//sprite pipeline without depth writes for the transparent layers
+	std::unique_ptr<JobSystem> recordJobs;
+	std::vector<vk::CommandPool> recordPools;			//one per job, job i records passes i, i + jobs, ...
+	std::vector<std::array<vk::CommandBuffer, renderPassCount>> secondaryCommandBuffers;	//[image][pass], from the pool of the job recording the pass
+	std::vector<std::array<RecordedPass, renderPassCount>> recordedPasses;
+	//what one record job of a frame needs, made in the frame arena so the job's closure fits in std::function without allocating
+	struct RecordJob
+	{
+		uint32_t firstPass;								//then every jobCount-th pass
+		uint32_t jobCount;
+		uint32_t imageIndex;
+		std::array<bool, renderPassCount> const* stale;
+		FractalPushConstants const* pushConstants;
+	};
+	FrameArena frameArena{ 16 * 1024 };					//reset at the start of every frame
+	AllocationCheck frameAllocations{ "drawFrame", 120 };	//debug builds assert once drawing stopped allocating
+	uint32_t spriteHighWater = 0;						//most sprites drawn so far, more make the sprite arrays grow
+	std::unique_ptr<ShaderReloader> shaderReloader;
+	std::mutex pipelineMutex;							//the reloader's builds read the render pass and layouts swap chain recreation replaces
+	uint64_t swapChainGeneration = 0;					//counts swap chain recreations
+	uint64_t framesDrawn = 0;							//also the number of the last submitted frame, the first one is 1
+	struct RetiredPipelines
+	{
+		FractalPipelines pipelines;
+		uint64_t frame;									//replaced before this frame was drawn
+	};
+	std::vector<RetiredPipelines> retiredPipelines;		//swapped out, frames in flight can still use them
+	uint32_t framesInFlight = Settings::FRAMES_IN_FLIGHT;			//sync objects drawFrame cycles through
+	vk::PresentModeKHR presentMode = Settings::PRESENT_MODE;		//asked of the swap chain, it falls back to fifo
+	double measuredInputTime = -1.0;					//input of the last frame whose latency was measured
 	std::vector<vk::Semaphore> imageAvailableSemaphores;
 	std::vector<vk::Semaphore> renderFinishedSemaphores;
-	std::vector<vk::Fence> inFlightFences;
-	std::vector<vk::Fence> imagesInFlight;
+	std::vector<vk::Fence> inFlightFences;				//fences only
+	std::vector<vk::Fence> imagesInFlight;				//fences only
+	bool timelineSemaphores = false;					//frames are tracked by frameTimeline, by the fences if the device has no timeline semaphores
+	vk::Semaphore frameTimeline;						//every submit signals the number it gets in framesDrawn, it only grows
+	std::vector<uint64_t> imageFrames;					//timeline only, frame that last used each image, 0 if none
+	uint64_t completedFrame = 0;						//CHECK_FRAME_ORDER, the timeline's value when it was last read
 
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
@@ -245,8 +518,3 @@ struct Vertex
 		return pos == other.pos && color == other.color && texCoord == other.texCoord;
 	}
 };
-
-struct UniformBufferObject
-{
-	alignas(16) glm::mat4 mvp;
-};
\ No newline at end of file
@@ -0,0 +1,68 @@
+//distance cache: the DE baked into a grid of cells around the origin, cells near the surface get a brick of samples
+//baked by fractal_bake.comp whenever the fractal parameters settle, included by fractal_common.glsl after the DEs
+
+const int CACHE_GRID = 64;			//cells per axis, matches Settings::FRACTAL_CACHE_GRID
+const int CACHE_BRICK = 8;			//samples per brick axis, the outer ones lie on the cell walls
+const float CACHE_EXTENT = 8.0;		//half size of the cached cube around the origin
+const uint CACHE_EMPTY = 0xffffffffu;	//no surface in the cell, its distance is a lower bound for the whole cell
+const uint CACHE_EXACT = 0xfffffffeu;	//near the surface but the bricks ran out
+
+const float CACHE_CELL_SIZE = 2.0 * CACHE_EXTENT / float(CACHE_GRID);
+const float CACHE_SAMPLE_SPACING = CACHE_CELL_SIZE / float(CACHE_BRICK - 1);
+
+#ifndef CACHE_ACCESS
+#define CACHE_ACCESS readonly
+#endif
+
+struct CacheCell
+{
+	float distance;
+	uint brick;
+};
+
+layout(std430, set = FRACTAL_SET, binding = 1) CACHE_ACCESS buffer CacheCells { CacheCell cacheCells[]; };
+layout(std430, set = FRACTAL_SET, binding = 2) CACHE_ACCESS buffer CacheBricks { float cacheBricks[]; };
+
+int cacheCellIndex(ivec3 cell)
+{
+	return cell.x + CACHE_GRID * (cell.y + CACHE_GRID * cell.z);
+}
+
+vec3 cacheCellCorner(ivec3 cell)
+{
+	return vec3(cell) * CACHE_CELL_SIZE - CACHE_EXTENT;
+}
+
+float cacheSample(uint brick, ivec3 sample)
+{
+	return cacheBricks[int(brick) * CACHE_BRICK * CACHE_BRICK * CACHE_BRICK + sample.x + CACHE_BRICK * (sample.y + CACHE_BRICK * sample.z)];
+}
+
+//cached estimate while it is far enough from the surface, the exact DE for the last stretch
+float cachedDistance(vec3 p)
+{
+	vec3 grid = (p + CACHE_EXTENT) / CACHE_CELL_SIZE;
+	if (any(lessThan(grid, vec3(0.0))) || any(greaterThanEqual(grid, vec3(CACHE_GRID)))) return sceneDistance(p);
+
+	ivec3 cell = ivec3(grid);
+	CacheCell cacheCell = cacheCells[cacheCellIndex(cell)];
+	if (cacheCell.brick == CACHE_EMPTY)
+	{
+		//a bound this small would stop the ray as a hit
+		return (cacheCell.distance > CACHE_SAMPLE_SPACING) ? cacheCell.distance : sceneDistance(p);
+	}
+	if (cacheCell.brick == CACHE_EXACT) return sceneDistance(p);
+
+	vec3 local = (grid - vec3(cell)) * float(CACHE_BRICK - 1);
+	ivec3 base = min(ivec3(local), ivec3(CACHE_BRICK - 2));
+	vec3 t = local - vec3(base);
+	float x00 = mix(cacheSample(cacheCell.brick, base), cacheSample(cacheCell.brick, base + ivec3(1, 0, 0)), t.x);
+	float x10 = mix(cacheSample(cacheCell.brick, base + ivec3(0, 1, 0)), cacheSample(cacheCell.brick, base + ivec3(1, 1, 0)), t.x);
+	float x01 = mix(cacheSample(cacheCell.brick, base + ivec3(0, 0, 1)), cacheSample(cacheCell.brick, base + ivec3(1, 0, 1)), t.x);
+	float x11 = mix(cacheSample(cacheCell.brick, base + ivec3(0, 1, 1)), cacheSample(cacheCell.brick, base + ivec3(1, 1, 1)), t.x);
+	float distance = mix(mix(x00, x10, t.y), mix(x01, x11, t.y), t.z);
+
+	//interpolation can overshoot by up to a sample spacing, inside the final brick only the exact DE is safe
+	distance -= CACHE_SAMPLE_SPACING;
+	return (distance > CACHE_SAMPLE_SPACING) ? distance : sceneDistance(p);
+}
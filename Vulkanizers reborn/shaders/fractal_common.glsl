@@ -0,0 +1,569 @@
+//shared by the fragment and compute fractal paths, included with GL_GOOGLE_include_directive
+
+layout( push_constant ) uniform constants
+{
+	vec4 data; //viewport width, viewport height, steps, {sphere size, polynomial degree, julia power, s, rot1, planeDist, boxFold, planeDist}
+	vec4 cameraPos; //4th argument is focal length
+	vec4 cameraHorizontal; //4th argument is the distance estimator
+	vec4 cameraVertical; //4th argument is { _ , _, k projection, r, rot2, _, rot, rot}
+	vec4 cameraDirection; //4th argument is iterations
+	vec4 juliaC;	// {f, translate_scale, translate_scale, translate_scale}
+	vec4 marchPass; //compute pass type, steps per pass, deep zoom, distance cache
+	vec4 cameraLow; //camera position minus cameraPos in deep zoom, 4th argument is ray precision scale
+} pushConstants;
+
+//set with the reference orbit, the distance cache and the temporal buffers, the compute path keeps its ray queues in set 0
+#ifndef FRACTAL_SET
+#define FRACTAL_SET 0
+#endif
+
+//per frame values that don't fit in the push constants, written by the cpu for every swap chain image
+layout(std430, set = FRACTAL_SET, binding = 4) readonly buffer FrameState
+{
+	vec4 previousOffset;		//previous camera position minus this one, 4th argument is previous focal length
+	vec4 previousHorizontal;	//4th argument is previous aspect ratio
+	vec4 previousVertical;
+	vec4 previousDirection;
+	uvec4 temporalFlags;		//reproject, history read offset, history write offset or TEMPORAL_NONE, refresh phase
+	vec4 marchLod;				//hit threshold in pixel footprints, iteration lod start distance, iterations dropped per doubling, _
+	uvec4 shading;				//compute shading rate, pattern phase, image holds last frame, _
+	vec4 sceneBounds;			//bounding sphere center and radius, 0 radius if the scene fills space
+};
+
+const float rayPrecision = 0.0001;
+
+//march lowers it for distant points when iteration lod is on, everything else runs the full count
+int lodIterations = 0x7fffffff;
+
+int iterationLimit()
+{
+	return min(int(pushConstants.cameraDirection.w), lodIterations);
+}
+
+float qLength2(in vec4 q) { return dot(q, q); }
+
+vec4 qPower(vec4 q, float power)
+{
+	float allLength = sqrt(qLength2(q));
+	float pureLength = sqrt(dot(q.yzw, q.yzw));
+	float phi;
+	vec3 unit;
+	if (q.x >= allLength || allLength <= 0.0001)
+	{
+		phi = 0.0;
+	}
+	else
+	{
+		phi = acos(q.x / allLength);
+	}
+	if (pureLength <= 0.0001)
+	{
+		unit = vec3(0.0, 0.0, 0.0);
+	}
+	else
+	{
+		unit = q.yzw / pureLength;
+	}
+	float powLength = pow(allLength, power);
+	return vec4(powLength * cos(power * phi), unit * powLength * sin(power * phi));
+}
+
+vec4 qSquare(vec4 q)
+{
+	return vec4(q.x * q.x - q.y * q.y - q.z * q.z - q.w * q.w, 2.0 * q.x * q.yzw);
+}
+
+vec4 qCube(vec4 q)
+{
+	vec4 q2 = q*q;
+	return vec4(q.x * (q2.x - 3.0*(q2.y + q2.z + q2.w)),
+							q.yzw * (3.0 * q2.x - q2.y - q2.z - q2.w));
+}
+
+vec2 clipPlane(vec3 p, vec3 dir, vec4 plane)
+{
+	float intersect = dot(dir, plane.xyz);
+	float projection = dot(plane.xyz * plane.w - p, plane.xyz);
+	//above the plane
+	if (projection < 0.0)
+	{
+		if (intersect < 0.0)
+		{
+			return vec2(projection / intersect, 10000.0);
+		}
+		else
+		{
+			return vec2(10000.0, 0.0);
+		}
+	}
+	//below the plane
+	else
+	{
+		if (intersect > 0.0)
+		{
+			return vec2(0.0, projection/intersect);
+		}
+		else
+		{
+			return vec2(0.0, 10000.0);
+		}
+	}
+}
+
+float DE_spheres(vec3 point)
+{
+	vec3 p = abs(mod(point - 1.0, 2.0) - 1.0);
+	return length(p - vec3(1.0, 1.0, 1.0)) - pushConstants.data.w;
+}
+
+float DE_mandelbulb(vec3 point)
+{
+	int iterations;
+	vec3 w = point;
+	float dz = 1.0;
+	float m = dot(w, w);
+	for (iterations = 0; iterations <= iterationLimit(); iterations++)
+	{
+		dz = pushConstants.data.w * pow(m, (pushConstants.data.w - 1.0) / 2.0)*dz + 1.0;
+		float r = length(w);
+		float b = pushConstants.data.w * acos(w.y/r);
+		float a = pushConstants.data.w * atan(w.x, w.z);
+		w = point + pow(r, pushConstants.data.w) * vec3(sin(b) * sin(a), cos(b), sin(b)*cos(a));
+		
+		m = dot(w, w);
+		if (m > 2048.0) break;
+	}
+	return 0.25 * log(m) * sqrt(m) / dz;
+}
+
+float DE_juliaExact(vec3 point)
+{
+	int iterations;
+	vec4 z = vec4(point, pushConstants.cameraVertical.w);
+	float dz2 = 1.0;
+	float prevm2 = 0.0;
+	float m2 = 0.0;
+	for (iterations = 0; iterations <= iterationLimit(); iterations++)
+	{
+		dz2 = pushConstants.data.w * pushConstants.data.w * qLength2(qPower(z, pushConstants.data.w - 1.0)) * dz2;
+		z = qPower(z, pushConstants.data.w) + pushConstants.juliaC;
+		prevm2 = m2;
+		m2 = qLength2(z);
+		if (m2 > 512000.0) break;
+	}
+	if (abs(m2 - prevm2) < 0.5 && prevm2 != 0.0) return 0.0; //convergence
+	if (abs(m2 - prevm2) > 0.5 && m2 < 512.0 && iterations >= 2) return 0.0; //oscillation
+	return 0.25 * log(m2)*sqrt(m2/dz2);
+}
+
+float DE_juliaSquare(vec3 point)
+{
+	int iterations;
+	vec4 z = vec4(point, pushConstants.cameraVertical.w);
+	if (4.0 * qLength2(z) < 0.000001) return 0.001;
+	float dz2 = 1.0;
+	float prevm2 = 0.0;
+	float m2 = 0.0;
+	for (iterations = 0; iterations <= iterationLimit(); iterations++)
+	{
+		dz2 = 4.0 * qLength2(z) * dz2;
+		z = qSquare(z) + pushConstants.juliaC;
+		prevm2 = m2;
+		m2 = qLength2(z);
+		if (m2 > 512.0) break;
+		if (dz2 < 0.0000001) break;
+	}
+	if (abs(m2 - prevm2) < 0.25 && prevm2 != 0.0) return 0.0; //convergence
+	if (abs(m2 - prevm2) > 0.25 && m2 < 512.0 && iterations >= 2) return 0.0; //oscillation
+	return 0.25 * log(m2)*sqrt(m2/dz2);
+}
+
+float DE_juliaCube(vec3 point)
+{
+	int iterations;
+	vec4 z = vec4(point, pushConstants.cameraVertical.w);
+	if (9.0 * qLength2(qSquare(z)) < 0.00001) return 0.01;
+	float dz2 = 1.0;
+	float m2 = 0.0;
+	float prevm2 = 0.0;
+	for (iterations = 0; iterations <= iterationLimit(); iterations++)
+	{
+		dz2 = 9.0 * qLength2(qSquare(z)) * dz2;
+		z = qCube(z) + pushConstants.juliaC;
+		prevm2 = m2;
+		m2 = qLength2(z);
+		if (m2 > 512.0) break;
+		if (dz2 < 0.0000001) break;
+	}
+	if (abs(m2 - prevm2) < 0.5 && prevm2 != 0.0) return 0.0; //convergence
+	if (abs(m2 - prevm2) > 0.5 && m2 < 512.0 && iterations >= 1) return 0.0; //oscillation
+	return 0.25 * log(m2)*sqrt(m2/dz2);
+}
+
+void boxFold(float r, inout vec4 point)
+{
+	point.xyz = clamp(point.xyz, -r, r)*2.0 - point.xyz;
+}
+
+void ballFold(float r2, inout vec4 point)
+{
+	float m2 = dot(point.xyz, point.xyz);
+	point /= clamp(max(r2, m2), 0.0, 1.0);
+	//if (m2 < r2) point /= r2;
+	//else if (m2 < 1.0) point /= m2;
+}
+
+void absFold(vec3 c, inout vec4 point)
+{
+	point.xyz = abs(point.xyz - c) + c;
+}
+
+void mengerFold(inout vec4 point)
+{
+	if (point.x < point.y) point.xy = point.yx;
+	if (point.x < point.z) point.xz = point.zx;
+	if (point.y < point.z) point.zy = point.yz;
+}
+
+void sierpinskiFold(inout vec4 point)
+{
+	if (point.x + point.y < 0.0) point.xy = -point.yx;
+	if (point.x + point.z < 0.0) point.xz = -point.zx;
+	if (point.y + point.z < 0.0) point.zy = -point.yz;
+}
+
+void planeFold(inout vec4 point, vec3 n, float d)
+{
+	point.xyz -= 2.0 * min(0.0, dot(point.xyz, n) - d) * n;
+}
+
+//the fold DEs can resume from an intermediate state, deep zoom hands rays over to them once float precision suffices
+float DE_mandelboxFrom(vec4 w, int firstIteration, vec3 point)
+{
+	int iterations;
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		boxFold(1.0, w);
+		w *= pushConstants.juliaC.w;
+		ballFold(pushConstants.cameraVertical.w * pushConstants.cameraVertical.w, w);
+		w.xyz = pushConstants.data.w * w.xyz + point;
+		w.w = w.w * abs(pushConstants.data.w) + 1.0;
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	vec3 boxDists = abs(w.xyz) - 6.0;
+	return (length(max(boxDists, 0.0)) + min(max(boxDists.x, max(boxDists.y, boxDists.z)), 0.0)) / w.w;
+	//return length(w.xyz)/abs(w.w);
+}
+
+float DE_mandelbox(vec3 point)
+{
+	return DE_mandelboxFrom(vec4(point, 1.0), 0, point);
+}
+
+float DE_juliaboxFrom(vec4 w, int firstIteration)
+{
+	int iterations;
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		boxFold(1.0, w);
+		w.xyz *= pushConstants.juliaC.w;
+		w.w *= abs(pushConstants.juliaC.w);
+		ballFold(pushConstants.cameraVertical.w * pushConstants.cameraVertical.w, w);
+		w.xyz = pushConstants.data.w * w.xyz + pushConstants.juliaC.xyz;
+		w.w = w.w * abs(pushConstants.data.w);
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	vec3 boxDists = abs(w.xyz) - 6.0;
+	return (length(max(boxDists, 0.0)) + min(max(boxDists.x, max(boxDists.y, boxDists.z)), 0.0)) / w.w;
+	//return length(w.xyz)/abs(w.w);
+}
+
+float DE_juliabox(vec3 point)
+{
+	return DE_juliaboxFrom(vec4(point, 1.0), 0);
+}
+
+float DE_butterweedHillsFrom(vec4 w, int firstIteration)
+{
+	int iterations;
+	float firstSin = sin(pushConstants.data.w);
+	float firstCos = cos(pushConstants.data.w);
+	float secondSin = sin(pushConstants.cameraVertical.w);
+	float secondCos = cos(pushConstants.cameraVertical.w);
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		w.xyz = abs(w.xyz);
+		w.xyz *= pushConstants.juliaC.w;
+		w.w *= abs(pushConstants.juliaC.w);
+		w.xyz += pushConstants.juliaC.xyz;
+		w.yz = vec2(firstCos * w.y + firstSin * w.z, firstCos * w.z - firstSin * w.y);
+		w.zx = vec2(secondCos * w.z + secondSin * w.x, secondCos * w.x - secondSin * w.z);
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	return (length(w.xyz) - 1.0) / w.w;
+}
+
+float DE_butterweedHills(vec3 point)
+{
+	return DE_butterweedHillsFrom(vec4(point, 1.0), 0);
+}
+
+float DE_mengerFrom(vec4 w, int firstIteration)
+{
+	int iterations;
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		w.xyz = abs(w.xyz);
+		mengerFold(w);
+		w.xyz *= pushConstants.juliaC.w;
+		w.w *= abs(pushConstants.juliaC.w);
+		w.xyz += pushConstants.juliaC.xyz;
+		w.z = -abs(w.z + pushConstants.data.w) - pushConstants.data.w;
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	vec3 boxDists = abs(w.xyz) - 2.0;
+	return (length(max(boxDists, 0.0)) + min(max(boxDists.x, max(boxDists.y, boxDists.z)), 0.0)) / w.w;
+}
+
+float DE_menger(vec3 point)
+{
+	return DE_mengerFrom(vec4(point, 1.0) / 100.0, 0);
+}
+
+float DE_mausoleumFrom(vec4 w, int firstIteration)
+{
+	int iterations;
+	float firstSin = sin(pushConstants.cameraVertical.w);
+	float firstCos = cos(pushConstants.cameraVertical.w);
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		boxFold(pushConstants.data.w, w);
+		mengerFold(w);
+		w.xyz *= pushConstants.juliaC.w;
+		w.w *= abs(pushConstants.juliaC.w);
+		w.xyz += pushConstants.juliaC.xyz;
+		w.yz = vec2(firstCos * w.y + firstSin * w.z, firstCos * w.z - firstSin * w.y);
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	vec3 boxDists = abs(w.xyz) - 2.0;
+	return (length(max(boxDists, 0.0)) + min(max(boxDists.x, max(boxDists.y, boxDists.z)), 0.0)) / w.w;
+}
+
+float DE_mausoleum(vec3 point)
+{
+	return DE_mausoleumFrom(vec4(point, 1.0), 0);
+}
+
+float DE_treePlanetFrom(vec4 w, int firstIteration)
+{
+	int iterations;
+	float firstSin = sin(pushConstants.cameraVertical.w);
+	float firstCos = cos(pushConstants.cameraVertical.w);
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		w.zx = vec2(firstCos * w.z + firstSin * w.x, firstCos * w.x - firstSin * w.z);
+		w.xyz = abs(w.xyz);
+		mengerFold(w);
+		w.xyz *= pushConstants.juliaC.w;
+		w.w *= abs(pushConstants.juliaC.w);
+		w.xyz += pushConstants.juliaC.xyz;
+		w.z = -abs(w.z + pushConstants.data.w) - pushConstants.data.w;
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	vec3 boxDists = abs(w.xyz) - 4.8;
+	return (length(max(boxDists, 0.0)) + min(max(boxDists.x, max(boxDists.y, boxDists.z)), 0.0)) / w.w;
+}
+
+float DE_treePlanet(vec3 point)
+{
+	return DE_treePlanetFrom(vec4(point, 1.0), 0);
+}
+
+float DE_sierpinskiTetrahedronFrom(vec4 w, int firstIteration)
+{
+	int iterations;
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		sierpinskiFold(w);
+		w.xyz *= pushConstants.juliaC.w;
+		w.w *= abs(pushConstants.juliaC.w);
+		w.xyz += pushConstants.juliaC.xyz;
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	float md = max(-w.x - w.y - w.z, max(w.x + w.y - w.z, max(-w.x + w.y + w.z, w.x - w.y + w.z)));
+	return (md - 1.0) / (w.w * sqrt(3.0));
+}
+
+float DE_sierpinskiTetrahedron(vec3 point)
+{
+	return DE_sierpinskiTetrahedronFrom(vec4(point, 1.0), 0);
+}
+
+float DE_snowStadiumFrom(vec4 w, int firstIteration)
+{
+	int iterations;
+	float firstSin = sin(pushConstants.data.w);
+	float firstCos = cos(pushConstants.data.w);
+	float secondSin = sin(pushConstants.cameraVertical.w);
+	float secondCos = cos(pushConstants.cameraVertical.w);
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		w.zx = vec2(firstCos * w.z + firstSin * w.x, firstCos * w.x - firstSin * w.z);
+		sierpinskiFold(w);
+		w.yz = vec2(secondCos * w.y + secondSin * w.z, secondCos * w.z - secondSin * w.y);
+		mengerFold(w);
+		w.xyz *= pushConstants.juliaC.w;
+		w.w *= abs(pushConstants.juliaC.w);
+		w.xyz += pushConstants.juliaC.xyz;
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	vec3 boxDists = abs(w.xyz) - 4.8;
+	return (length(max(boxDists, 0.0)) + min(max(boxDists.x, max(boxDists.y, boxDists.z)), 0.0)) / w.w;
+}
+
+float DE_snowStadium(vec3 point)
+{
+	return DE_snowStadiumFrom(vec4(point, 1.0), 0);
+}
+
+float DE_cumFrom(vec4 w, int firstIteration)
+{
+	int iterations;
+	float firstSin = sin(pushConstants.data.w);
+	float firstCos = cos(pushConstants.data.w);
+	float secondSin = sin(pushConstants.cameraVertical.w);
+	float secondCos = cos(pushConstants.cameraVertical.w);
+	for (iterations = firstIteration; iterations <= iterationLimit(); iterations++)
+	{
+		sierpinskiFold(w);
+		mengerFold(w);
+		w.zx = vec2(firstCos * w.z + firstSin * w.x, firstCos * w.x - firstSin * w.z);
+		w.xyz = abs(w.xyz);
+		w.xy = vec2(secondCos * w.x + secondSin * w.y, secondCos * w.y - secondSin * w.x);
+		w.xyz *= pushConstants.juliaC.w;
+		w.w *= abs(pushConstants.juliaC.w);
+		w.xyz += pushConstants.juliaC.xyz;
+		
+		if (dot(w.xyz, w.xyz) > 100000.0) break;
+	}
+	vec3 boxDists = abs(w.xyz) - 6.0;
+	return (length(max(boxDists, 0.0)) + min(max(boxDists.x, max(boxDists.y, boxDists.z)), 0.0)) / w.w;
+}
+
+float DE_cum(vec3 point)
+{
+	return DE_cumFrom(vec4(point, 1.0), 0);
+}
+
+float sceneDistance(vec3 p)
+{
+	switch(int(pushConstants.cameraHorizontal.w))
+	{
+		case 0:	return DE_spheres(p);
+		case 1:	return DE_mandelbulb(p);
+		case 2:	return DE_juliaExact(p);
+		case 3:	return DE_juliaSquare(p);
+		case 4:	return DE_juliaCube(p);
+		case 5:	return DE_mandelbox(p);
+		case 6:	return DE_juliabox(p);
+		case 7:	return DE_butterweedHills(p);
+		case 8:	return DE_menger(p);
+		case 9:	return DE_mausoleum(p);
+		case 10:return DE_treePlanet(p);
+		case 11:return DE_sierpinskiTetrahedron(p);
+		case 12:return DE_snowStadium(p);
+		case 13:return DE_cum(p);
+		default:return 1000.0;
+	}
+}
+
+//x is min, y is max distance along the ray
+vec2 sceneClip(vec3 from, vec3 direction)
+{
+	vec2 clip;
+	switch(int(pushConstants.cameraHorizontal.w))
+	{
+		case 2:
+		case 3:
+		case 4:	clip = clipPlane(from, direction, vec4(0.0, 1.0, 0.0, 0.0)); break;
+		default:	clip = vec2(0.0, 10000.0); break;
+	}
+	if (sceneBounds.w <= 0.0) return clip;
+
+	//start marching where the ray enters the bounding sphere, rays that miss it never march
+	vec3 offset = from - sceneBounds.xyz;
+	float b = dot(offset, direction);
+	float discriminant = b * b - (dot(offset, offset) - sceneBounds.w * sceneBounds.w);
+	if (discriminant < 0.0) return vec2(10000.0, 0.0);
+	float root = sqrt(discriminant);
+	clip = vec2(max(clip.x, -b - root), min(clip.y, -b + root));
+	if (clip.x > clip.y) return vec2(10000.0, 0.0);
+	return clip;
+}
+
+#include "fractal_deepzoom.glsl"
+#include "fractal_cache.glsl"
+
+//direction of the primary ray through a pixel center, relative to the camera so it stays exact when zoomed in
+vec3 primaryRay(vec2 pixel)
+{
+	vec3 horizontal = pushConstants.cameraHorizontal.xyz * pushConstants.data.x / pushConstants.data.y;
+	vec3 vertical = pushConstants.cameraVertical.xyz;
+	vec3 topLeftCorner = -horizontal/2.0 + vertical/2.0 + pushConstants.cameraDirection.xyz * pushConstants.cameraPos.w;
+	return normalize(topLeftCorner + pixel.x/pushConstants.data.x * horizontal - pixel.y/pushConstants.data.y * vertical);
+}
+
+const int RAY_HIT = 0;
+const int RAY_MISSED = 1;	//left the scene, pixel keeps the clear color
+const int RAY_ACTIVE = 2;	//ran out of steps before hitting anything
+
+//every doubling of the distance past the start drops iterations, never below half of them
+int lodIterationCount(float totalDistance)
+{
+	int iterations = int(pushConstants.cameraDirection.w);
+	int dropped = int(marchLod.z * log2(max(totalDistance / marchLod.y, 1.0)));
+	return max(iterations - dropped, (iterations + 1) / 2);
+}
+
+//march until hit, miss or stepLimit, can be resumed with the returned totalDistance and steps
+int march(vec3 from, vec3 direction, int stepLimit, inout float totalDistance, inout int steps)
+{
+	//angle one pixel covers, the image plane is one unit high at focal length
+	float pixelAngle = 1.0 / (pushConstants.data.y * pushConstants.cameraPos.w);
+	for (; steps < stepLimit; steps++)
+	{
+		if (marchLod.y > 0.0) lodIterations = lodIterationCount(totalDistance);
+		float distance;
+		if (pushConstants.marchPass.z != 0.0) distance = sceneDistanceDeep((from - pushConstants.cameraPos.xyz) + totalDistance * direction);
+		else if (pushConstants.marchPass.w != 0.0) distance = cachedDistance(from + totalDistance * direction);
+		else distance = sceneDistance(from + totalDistance * direction);
+		totalDistance += distance;
+		//detail smaller than the pixel footprint can't be seen, stop there instead of at the fixed precision
+		float hitDistance = max(rayPrecision * pushConstants.cameraLow.w, marchLod.x * totalDistance * pixelAngle);
+		if (distance < hitDistance) return RAY_HIT;
+		if (distance > 512.0) return RAY_MISSED;
+	}
+	return RAY_ACTIVE;
+}
+
+float shade(float totalDistance, int steps, float maxDistance)
+{
+	if (totalDistance > maxDistance)
+	{
+		return 0.0;
+	}
+	else
+	{
+		return 1.0-float(steps)/float(int(pushConstants.data.z));
+	}
+}
+
+#include "fractal_temporal.glsl"
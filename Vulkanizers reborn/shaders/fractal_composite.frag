@@ -0,0 +1,18 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) out vec4 outColor;
+
+//written by fractal_shader.comp before the render pass
+layout(binding = 0, rgba8) uniform readonly image2D fractalImage;
+
+//fractal image size over framebuffer size, below 1 when RESOLUTION_SCALE is
+layout(push_constant) uniform PushConstants
+{
+	vec2 scale;
+} pushConstants;
+
+void main()
+{
+	outColor = imageLoad(fractalImage, ivec2(gl_FragCoord.xy * pushConstants.scale));
+}
@@ -0,0 +1,365 @@
+//deep zoom: rays are marched relative to the camera and the fold DEs are evaluated as a perturbation
+//delta = w - z of the reference orbit z, which the CPU computes in double for the camera position (ReferenceOrbit.cpp)
+//every nonlinear op of the reference records its decision values (the quantity compared against 0) so that
+//a pixel taking a different branch than the reference can still be expressed with small, exact terms
+//included by fractal_common.glsl after the DEs
+
+const int ORBIT_STRIDE = 16;	//floats per iteration, matches ReferenceOrbit::stride
+const float PERTURBATION_ERROR = 0.000001;	//relative float error of w, with a few ulps of margin
+
+layout(std430, set = FRACTAL_SET, binding = 0) readonly buffer ReferenceOrbit
+{
+	int orbitLength;	//recorded iterations, the last one only has its point
+	int orbitPadding[3];
+	float orbit[];
+};
+
+vec3 orbitPoint(int iteration)
+{
+	int index = iteration * ORBIT_STRIDE;
+	return vec3(orbit[index], orbit[index + 1], orbit[index + 2]);
+}
+
+float orbitValue(inout int cursor)
+{
+	return orbit[cursor++];
+}
+
+//true once w = z + delta can be held in a float without losing more than the hit precision, scale is the derivative
+bool leavePerturbation(int iteration, vec4 delta)
+{
+	if (iteration + 1 >= orbitLength) return true;
+	return PERTURBATION_ERROR * length(orbitPoint(iteration)) < rayPrecision * pushConstants.cameraLow.w * delta.w;
+}
+
+//abs(z + delta) - abs(z) for the reference value z
+float absDelta(float z, float delta)
+{
+	bool referenceNegative = z < 0.0;
+	bool pixelNegative = z + delta < 0.0;
+	if (referenceNegative == pixelNegative) return referenceNegative ? -delta : delta;
+	return referenceNegative ? 2.0 * z + delta : -2.0 * z - delta;
+}
+
+void absFoldDelta(inout vec4 delta, inout int cursor)
+{
+	delta.x = absDelta(orbitValue(cursor), delta.x);
+	delta.y = absDelta(orbitValue(cursor), delta.y);
+	delta.z = absDelta(orbitValue(cursor), delta.z);
+}
+
+//clamp(x, -r, r)*2 - x with the reference decisions a = z - r and b = z + r
+float boxFoldDelta(float r, float delta, inout int cursor)
+{
+	float a = orbitValue(cursor);
+	float b = orbitValue(cursor);
+	int referenceSide = (a > 0.0) ? 1 : ((b < 0.0) ? -1 : 0);
+	int pixelSide = (a + delta > 0.0) ? 1 : ((b + delta < 0.0) ? -1 : 0);
+	if (referenceSide == pixelSide) return (pixelSide == 0) ? delta : -delta;
+	if (referenceSide == 0) return (pixelSide > 0) ? -2.0 * a - delta : -2.0 * b - delta;
+	if (pixelSide == 0) return (referenceSide > 0) ? 2.0 * a + delta : 2.0 * b + delta;
+	return (pixelSide > 0) ? 4.0 * r - delta : -4.0 * r - delta;
+}
+
+void boxFoldDelta(float r, inout vec4 delta, inout int cursor)
+{
+	delta.x = boxFoldDelta(r, delta.x, cursor);
+	delta.y = boxFoldDelta(r, delta.y, cursor);
+	delta.z = boxFoldDelta(r, delta.z, cursor);
+}
+
+//divisor of the ball fold, 0 is the constant r2, 1 is the constant 1, 2 is the inversion by m2
+int ballFoldRegion(float r2, float m2MinusR2, float m2MinusOne)
+{
+	if (r2 >= 1.0 || m2MinusOne >= 0.0) return 1;
+	if (m2MinusR2 < 0.0) return 0;
+	return 2;
+}
+
+//the reference records its point before the fold and m2 - r2, m2 - 1
+void ballFoldDelta(float r2, inout vec4 delta, inout int cursor)
+{
+	vec3 z;
+	z.x = orbitValue(cursor);
+	z.y = orbitValue(cursor);
+	z.z = orbitValue(cursor);
+	float m2MinusR2 = orbitValue(cursor);
+	float m2MinusOne = orbitValue(cursor);
+	float m2Change = 2.0 * dot(z, delta.xyz) + dot(delta.xyz, delta.xyz);
+	int referenceRegion = ballFoldRegion(r2, m2MinusR2, m2MinusOne);
+	int pixelRegion = ballFoldRegion(r2, m2MinusR2 + m2Change, m2MinusOne + m2Change);
+
+	float divisors[3] = float[3](r2, 1.0, 0.0);
+	float referenceDivisor = (referenceRegion == 2) ? m2MinusOne + 1.0 : divisors[referenceRegion];
+	float pixelDivisor = (pixelRegion == 2) ? m2MinusOne + m2Change + 1.0 : divisors[pixelRegion];
+	//referenceDivisor - pixelDivisor without cancellation
+	float divisorDifference;
+	if (referenceRegion == pixelRegion) divisorDifference = (pixelRegion == 2) ? -m2Change : 0.0;
+	else if (referenceRegion == 2) divisorDifference = (pixelRegion == 0) ? m2MinusR2 : m2MinusOne;
+	else if (pixelRegion == 2) divisorDifference = (referenceRegion == 0) ? -(m2MinusR2 + m2Change) : -(m2MinusOne + m2Change);
+	else divisorDifference = referenceDivisor - pixelDivisor;
+
+	delta.xyz = delta.xyz / pixelDivisor + z * (divisorDifference / (pixelDivisor * referenceDivisor));
+	delta.w /= pixelDivisor;
+}
+
+//swap of components i and j when z.i - z.j = e is negative
+vec2 swapDelta(vec2 delta, inout int cursor)
+{
+	float e = orbitValue(cursor);
+	bool referenceSwaps = e < 0.0;
+	bool pixelSwaps = e + delta.x - delta.y < 0.0;
+	if (referenceSwaps == pixelSwaps) return referenceSwaps ? delta.yx : delta;
+	return pixelSwaps ? vec2(delta.y - e, delta.x + e) : vec2(delta.x + e, delta.y - e);
+}
+
+void mengerFoldDelta(inout vec4 delta, inout int cursor)
+{
+	delta.xy = swapDelta(delta.xy, cursor);
+	delta.xz = swapDelta(delta.xz, cursor);
+	delta.yz = swapDelta(delta.yz, cursor);
+}
+
+//negated swap of components i and j when z.i + z.j = c is negative
+vec2 negatedSwapDelta(vec2 delta, inout int cursor)
+{
+	float c = orbitValue(cursor);
+	bool referenceSwaps = c < 0.0;
+	bool pixelSwaps = c + delta.x + delta.y < 0.0;
+	if (referenceSwaps == pixelSwaps) return referenceSwaps ? -delta.yx : delta;
+	return pixelSwaps ? vec2(-c - delta.y, -c - delta.x) : vec2(c + delta.x, c + delta.y);
+}
+
+void sierpinskiFoldDelta(inout vec4 delta, inout int cursor)
+{
+	delta.xy = negatedSwapDelta(delta.xy, cursor);
+	delta.xz = negatedSwapDelta(delta.xz, cursor);
+	delta.zy = negatedSwapDelta(delta.zy, cursor);
+}
+
+void scaleDelta(inout vec4 delta)
+{
+	delta.xyz *= pushConstants.juliaC.w;
+	delta.w *= abs(pushConstants.juliaC.w);
+}
+
+//true if the pixel escaped after the iteration, w then holds its absolute point
+bool escapedDelta(int iteration, vec4 delta, out vec4 w)
+{
+	w = vec4(orbitPoint(iteration + 1) + delta.xyz, delta.w);
+	return dot(w.xyz, w.xyz) > 100000.0;
+}
+
+float DEP_spheres(vec3 delta)
+{
+	//a single entry: distance to the nearest center q, the fold signs, |q|^2 - r^2 and the distance to the cell walls
+	vec3 q = orbitPoint(0);
+	vec3 signs = vec3(orbit[3], orbit[4], orbit[5]);
+	float sphere = orbit[6];
+	if (orbitLength < 1 || max(abs(delta.x), max(abs(delta.y), abs(delta.z))) >= orbit[7])
+		return DE_spheres(pushConstants.cameraPos.xyz + (pushConstants.cameraLow.xyz + delta));
+	vec3 e = signs * delta;
+	return (sphere + 2.0 * dot(q, e) + dot(e, e)) / (length(q + e) + pushConstants.data.w);
+}
+
+float DEP_mandelbox(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0);
+	vec4 w;
+	vec3 point = pushConstants.cameraPos.xyz + (pushConstants.cameraLow.xyz + rayDelta);
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_mandelboxFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration, point);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		boxFoldDelta(1.0, delta, cursor);
+		delta *= pushConstants.juliaC.w;
+		ballFoldDelta(pushConstants.cameraVertical.w * pushConstants.cameraVertical.w, delta, cursor);
+		delta.xyz = pushConstants.data.w * delta.xyz + rayDelta;
+		delta.w = delta.w * abs(pushConstants.data.w) + 1.0;
+		if (escapedDelta(iteration, delta, w)) return DE_mandelboxFrom(w, iterationCount + 1, point);
+	}
+	return DE_mandelboxFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1, point);
+}
+
+float DEP_juliabox(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0);
+	vec4 w;
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_juliaboxFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		boxFoldDelta(1.0, delta, cursor);
+		scaleDelta(delta);
+		ballFoldDelta(pushConstants.cameraVertical.w * pushConstants.cameraVertical.w, delta, cursor);
+		delta.xyz *= pushConstants.data.w;
+		delta.w *= abs(pushConstants.data.w);
+		if (escapedDelta(iteration, delta, w)) return DE_juliaboxFrom(w, iterationCount + 1);
+	}
+	return DE_juliaboxFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1);
+}
+
+float DEP_butterweedHills(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0);
+	vec4 w;
+	float firstSin = sin(pushConstants.data.w);
+	float firstCos = cos(pushConstants.data.w);
+	float secondSin = sin(pushConstants.cameraVertical.w);
+	float secondCos = cos(pushConstants.cameraVertical.w);
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_butterweedHillsFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		absFoldDelta(delta, cursor);
+		scaleDelta(delta);
+		delta.yz = vec2(firstCos * delta.y + firstSin * delta.z, firstCos * delta.z - firstSin * delta.y);
+		delta.zx = vec2(secondCos * delta.z + secondSin * delta.x, secondCos * delta.x - secondSin * delta.z);
+		if (escapedDelta(iteration, delta, w)) return DE_butterweedHillsFrom(w, iterationCount + 1);
+	}
+	return DE_butterweedHillsFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1);
+}
+
+float DEP_menger(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0) / 100.0;
+	vec4 w;
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_mengerFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		absFoldDelta(delta, cursor);
+		mengerFoldDelta(delta, cursor);
+		scaleDelta(delta);
+		delta.z = -absDelta(orbitValue(cursor), delta.z);
+		if (escapedDelta(iteration, delta, w)) return DE_mengerFrom(w, iterationCount + 1);
+	}
+	return DE_mengerFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1);
+}
+
+float DEP_mausoleum(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0);
+	vec4 w;
+	float firstSin = sin(pushConstants.cameraVertical.w);
+	float firstCos = cos(pushConstants.cameraVertical.w);
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_mausoleumFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		boxFoldDelta(pushConstants.data.w, delta, cursor);
+		mengerFoldDelta(delta, cursor);
+		scaleDelta(delta);
+		delta.yz = vec2(firstCos * delta.y + firstSin * delta.z, firstCos * delta.z - firstSin * delta.y);
+		if (escapedDelta(iteration, delta, w)) return DE_mausoleumFrom(w, iterationCount + 1);
+	}
+	return DE_mausoleumFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1);
+}
+
+float DEP_treePlanet(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0);
+	vec4 w;
+	float firstSin = sin(pushConstants.cameraVertical.w);
+	float firstCos = cos(pushConstants.cameraVertical.w);
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_treePlanetFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		delta.zx = vec2(firstCos * delta.z + firstSin * delta.x, firstCos * delta.x - firstSin * delta.z);
+		absFoldDelta(delta, cursor);
+		mengerFoldDelta(delta, cursor);
+		scaleDelta(delta);
+		delta.z = -absDelta(orbitValue(cursor), delta.z);
+		if (escapedDelta(iteration, delta, w)) return DE_treePlanetFrom(w, iterationCount + 1);
+	}
+	return DE_treePlanetFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1);
+}
+
+float DEP_sierpinskiTetrahedron(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0);
+	vec4 w;
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_sierpinskiTetrahedronFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		sierpinskiFoldDelta(delta, cursor);
+		scaleDelta(delta);
+		if (escapedDelta(iteration, delta, w)) return DE_sierpinskiTetrahedronFrom(w, iterationCount + 1);
+	}
+	return DE_sierpinskiTetrahedronFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1);
+}
+
+float DEP_snowStadium(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0);
+	vec4 w;
+	float firstSin = sin(pushConstants.data.w);
+	float firstCos = cos(pushConstants.data.w);
+	float secondSin = sin(pushConstants.cameraVertical.w);
+	float secondCos = cos(pushConstants.cameraVertical.w);
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_snowStadiumFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		delta.zx = vec2(firstCos * delta.z + firstSin * delta.x, firstCos * delta.x - firstSin * delta.z);
+		sierpinskiFoldDelta(delta, cursor);
+		delta.yz = vec2(secondCos * delta.y + secondSin * delta.z, secondCos * delta.z - secondSin * delta.y);
+		mengerFoldDelta(delta, cursor);
+		scaleDelta(delta);
+		if (escapedDelta(iteration, delta, w)) return DE_snowStadiumFrom(w, iterationCount + 1);
+	}
+	return DE_snowStadiumFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1);
+}
+
+float DEP_cum(vec3 rayDelta)
+{
+	vec4 delta = vec4(rayDelta, 1.0);
+	vec4 w;
+	float firstSin = sin(pushConstants.data.w);
+	float firstCos = cos(pushConstants.data.w);
+	float secondSin = sin(pushConstants.cameraVertical.w);
+	float secondCos = cos(pushConstants.cameraVertical.w);
+	int iterationCount = iterationLimit();
+	for (int iteration = 0; iteration <= iterationCount; iteration++)
+	{
+		if (leavePerturbation(iteration, delta)) return DE_cumFrom(vec4(orbitPoint(iteration) + delta.xyz, delta.w), iteration);
+		int cursor = iteration * ORBIT_STRIDE + 3;
+		sierpinskiFoldDelta(delta, cursor);
+		mengerFoldDelta(delta, cursor);
+		delta.zx = vec2(firstCos * delta.z + firstSin * delta.x, firstCos * delta.x - firstSin * delta.z);
+		absFoldDelta(delta, cursor);
+		delta.xy = vec2(secondCos * delta.x + secondSin * delta.y, secondCos * delta.y - secondSin * delta.x);
+		scaleDelta(delta);
+		if (escapedDelta(iteration, delta, w)) return DE_cumFrom(w, iterationCount + 1);
+	}
+	return DE_cumFrom(vec4(orbitPoint(iterationCount + 1) + delta.xyz, delta.w), iterationCount + 1);
+}
+
+//delta is the offset from the camera, the non fold scenes only get the camera relative position
+float sceneDistanceDeep(vec3 delta)
+{
+	switch(int(pushConstants.cameraHorizontal.w))
+	{
+		case 0:	return DEP_spheres(delta);
+		case 5:	return DEP_mandelbox(delta);
+		case 6:	return DEP_juliabox(delta);
+		case 7:	return DEP_butterweedHills(delta);
+		case 8:	return DEP_menger(delta);
+		case 9:	return DEP_mausoleum(delta);
+		case 10:return DEP_treePlanet(delta);
+		case 11:return DEP_sierpinskiTetrahedron(delta);
+		case 12:return DEP_snowStadium(delta);
+		case 13:return DEP_cum(delta);
+		default:return sceneDistance(pushConstants.cameraPos.xyz + (pushConstants.cameraLow.xyz + delta));
+	}
+}
@@ -0,0 +1,78 @@
+//temporal reprojection: last frame's hit distances, scattered into this frame's view by fractal_reproject.comp
+//a pixel whose whole neighbourhood got a hit starts marching just short of the nearest one instead of at the camera
+
+const uint TEMPORAL_NONE = 0xffffffffu;		//no hit recorded or reprojected here
+const uint TEMPORAL_STEP_BITS = 0x3ffu;		//low mantissa bits carry the step count, truncating them only shortens the distance
+const float TEMPORAL_MARGIN = 0.05;			//fraction of the reprojected distance to start short of it
+const float TEMPORAL_DISCONTINUITY = 0.1;	//relative depth spread of the neighbourhood treated as a disocclusion edge
+
+//previous camera and temporalFlags are in the FrameState block of fractal_common.glsl
+//two planes of packed hits, one written this frame and the one from last frame
+layout(std430, set = FRACTAL_SET, binding = 5) buffer TemporalHistory { uint temporalHistory[]; };
+//last frame's hits in this frame's pixels, the nearest one wins
+layout(std430, set = FRACTAL_SET, binding = 6) buffer TemporalReprojection { uint temporalReprojection[]; };
+
+uint temporalPack(float distance, int steps)
+{
+	return (floatBitsToUint(distance) & ~TEMPORAL_STEP_BITS) | uint(clamp(steps, 0, int(TEMPORAL_STEP_BITS)));
+}
+
+float temporalDistance(uint packed)
+{
+	return uintBitsToFloat(packed & ~TEMPORAL_STEP_BITS);
+}
+
+int temporalSteps(uint packed)
+{
+	return int(packed & TEMPORAL_STEP_BITS);
+}
+
+uint temporalIndex(ivec2 pixel)
+{
+	return uint(pixel.y) * uint(pushConstants.data.x) + uint(pixel.x);
+}
+
+//moves the ray start to the reprojected hit and returns the step count it carries over, -1 to march from the camera
+int temporalBegin(ivec2 pixel, float clipDistance, inout float totalDistance, inout int steps)
+{
+	if (temporalFlags.x == 0u) return -1;
+	//every frame one pixel of each 4x4 block marches from the camera so carried step counts can't go stale
+	if (uint((pixel.x & 3) + 4 * (pixel.y & 3)) == temporalFlags.w) return -1;
+
+	uint center = temporalReprojection[temporalIndex(pixel)];
+	if (center == TEMPORAL_NONE) return -1;
+
+	ivec2 size = ivec2(pushConstants.data.xy);
+	float nearest = temporalDistance(center);
+	float farthest = nearest;
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			uint packed = temporalReprojection[temporalIndex(clamp(pixel + ivec2(x, y), ivec2(0), size - 1))];
+			//a hole next to the pixel is something last frame didn't see
+			if (packed == TEMPORAL_NONE) return -1;
+			nearest = min(nearest, temporalDistance(packed));
+			farthest = max(farthest, temporalDistance(packed));
+		}
+	}
+	if (farthest - nearest > TEMPORAL_DISCONTINUITY * nearest) return -1;
+
+	totalDistance = max(nearest * (1.0 - TEMPORAL_MARGIN) - clipDistance, 0.0);
+	steps = temporalSteps(center);
+	return steps;
+}
+
+//a hit on the very first step means the start was already on or inside the surface
+bool temporalRejected(int carriedSteps, int status, int steps)
+{
+	return carriedSteps >= 0 && status == RAY_HIT && steps == carriedSteps + 1;
+}
+
+//distance is measured from the camera, carried rays keep their carried step count so it doesn't grow every frame
+void temporalStore(ivec2 pixel, int status, float distance, int steps, int carriedSteps)
+{
+	if (temporalFlags.z == TEMPORAL_NONE) return;
+	temporalHistory[temporalFlags.z + temporalIndex(pixel)] = (status == RAY_HIT) ?
+		temporalPack(distance, (carriedSteps >= 0) ? carriedSteps : steps) : TEMPORAL_NONE;
+}
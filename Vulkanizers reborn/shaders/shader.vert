@@ -1,9 +1,10 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform UniformBufferObject {
-	mat4 mvp;
-} ubo;
+//mvps of one sprite page, the draw's first instance is the first sprite's slot
+layout(std430, set = 0, binding = 0) readonly buffer SpriteMvps {
+	mat4 mvps[];
+} page;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -13,7 +14,7 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-	gl_Position = ubo.mvp * vec4(inPosition, 1.0);
+	gl_Position = page.mvps[gl_InstanceIndex] * vec4(inPosition, 1.0);
 	fragColor = inColor;
 	fragTexCoord = inTexCoord;
 }
\ No newline at end of file